@@ -0,0 +1,105 @@
+/****************************************************************************
+Copyright (c) 2019, 李柯鹏
+All rights reserved.
+
+Author: 李柯鹏 <likepeng0418@163.com>
+****************************************************************************/
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "myframe/log.h"
+#include "myframe/msg.h"
+#include "myframe/actor.h"
+#include "myframe/co_actor.h"
+
+#if defined(MYFRAME_HAS_CO_ACTOR)
+
+// 处理请求需要一段时间，等待期间不占用工作线程，可以同时处理多个请求
+class ExampleActorCoroutine : public myframe::CoActor {
+ public:
+  int random(int min, int max) {
+    std::random_device seed;
+    std::ranlux48 engine(seed());
+    std::uniform_int_distribution<> distrib(min, max);
+    return distrib(engine);
+  }
+
+  int Init(const char* param) override {
+    (void)param;
+    return 0;
+  }
+
+  myframe::CoTask CoProc(std::shared_ptr<const myframe::Msg> msg) override {
+    int cost_ms = random(100, 500);
+    LOG(INFO) << "-----> " << GetActorName() << " begin runing...";
+    co_await CoSleep(std::chrono::milliseconds(cost_ms));
+    LOG(INFO) << "-----> " << GetActorName() << " process end, cost "
+              << cost_ms << " ms";
+    GetMailbox()->Reply(msg,
+      std::make_shared<myframe::Msg>(std::to_string(cost_ms)));
+  }
+};
+
+// 与 example_actor_concurrent 相同的流程，不需要记录每个actor的状态
+class ExampleActorCoroutineTrigger : public myframe::CoActor {
+ public:
+  int Init(const char* param) override {
+    (void)param;
+    Spawn(Run());
+    return 0;
+  }
+
+  myframe::CoTask CoProc(std::shared_ptr<const myframe::Msg> msg) override {
+    LOG(INFO) << "unexpected msg " << *msg;
+    co_return;
+  }
+
+ private:
+  myframe::CoTask Run() {
+    LOG(INFO) << "begin concurrent task...";
+    std::vector<RequestItem> reqs;
+    for (int i = 1; i <= 3; ++i) {
+      reqs.emplace_back(
+        "actor.example_actor_coroutine.#" + std::to_string(i),
+        std::make_shared<myframe::Msg>(""));
+    }
+    auto resps = co_await CoRequestAll(
+      std::move(reqs), std::chrono::seconds(1));
+    for (std::size_t i = 0; i < resps.size(); ++i) {
+      LOG(INFO) << "task " << i + 1 << " cost "
+                << (resps[i] ? resps[i]->GetData() : "timeout") << " ms";
+    }
+    LOG(INFO) << "concurrent task finished";
+    co_await Serial();
+    LOG(INFO) << "all task finished";
+  }
+
+  // 依次请求，上一个请求完成后再发送下一个
+  myframe::CoTask Serial() {
+    for (int i = 1; i <= 3; ++i) {
+      auto resp = co_await CoRequest(
+        "actor.example_actor_coroutine.#" + std::to_string(i),
+        std::make_shared<myframe::Msg>(""),
+        std::chrono::seconds(1));
+      LOG(INFO) << "serial task " << i << " cost "
+                << (resp ? resp->GetData() : "timeout") << " ms";
+    }
+  }
+};
+
+#endif
+
+extern "C" MYFRAME_EXPORT std::shared_ptr<myframe::Actor> actor_create(
+    const std::string& actor_name) {
+#if defined(MYFRAME_HAS_CO_ACTOR)
+  if (actor_name == "example_actor_coroutine") {
+    return std::make_shared<ExampleActorCoroutine>();
+  }
+  if (actor_name == "example_actor_coroutine_trigger") {
+    return std::make_shared<ExampleActorCoroutineTrigger>();
+  }
+#endif
+  return nullptr;
+}
@@ -0,0 +1,67 @@
+/****************************************************************************
+Copyright (c) 2019, 李柯鹏
+All rights reserved.
+
+Author: 李柯鹏 <likepeng0418@163.com>
+****************************************************************************/
+#include <chrono>
+
+#include "myframe/log.h"
+#include "myframe/msg.h"
+#include "myframe/actor.h"
+
+class ExampleActorRequestServer : public myframe::Actor {
+ public:
+  int Init(const char* param) override {
+    (void)param;
+    return 0;
+  }
+
+  void Proc(const std::shared_ptr<const myframe::Msg>& msg) override {
+    // 不回复"ignore"请求，请求方会超时
+    if (msg->GetData() == "ignore") {
+      return;
+    }
+    auto mailbox = GetMailbox();
+    mailbox->Reply(msg,
+      std::make_shared<myframe::Msg>("resp: " + msg->GetData()));
+  }
+};
+
+class ExampleActorRequestClient : public myframe::Actor {
+ public:
+  int Init(const char* param) override {
+    (void)param;
+    // 同时发送多个请求，回复由各自的回调处理
+    const char* reqs[] = {"hello", "world", "ignore"};
+    for (auto req : reqs) {
+      std::string data(req);
+      Request("actor.example_actor_request_server.#1",
+        std::make_shared<myframe::Msg>(data),
+        std::chrono::milliseconds(500),
+        [data](const std::shared_ptr<const myframe::Msg>& resp) {
+          if (resp == nullptr) {
+            LOG(INFO) << "request " << data << " timeout";
+            return;
+          }
+          LOG(INFO) << "request " << data << " get " << resp->GetData();
+        });
+    }
+    return 0;
+  }
+
+  void Proc(const std::shared_ptr<const myframe::Msg>& msg) override {
+    LOG(INFO) << "unexpected msg " << *msg;
+  }
+};
+
+extern "C" MYFRAME_EXPORT std::shared_ptr<myframe::Actor> actor_create(
+    const std::string& actor_name) {
+  if (actor_name == "example_actor_request_server") {
+    return std::make_shared<ExampleActorRequestServer>();
+  }
+  if (actor_name == "example_actor_request_client") {
+    return std::make_shared<ExampleActorRequestClient>();
+  }
+  return nullptr;
+}
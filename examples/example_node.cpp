@@ -42,9 +42,11 @@ class ExampleNode : public myframe::Actor {
       const auto& sub_list = sub_list_[msg->GetDst()];
       auto mailbox = GetMailbox();
       for (const auto& sub : sub_list) {
-        auto send_msg = std::make_shared<myframe::Msg>();
+        auto send_msg = mailbox->NewMsg();
         send_msg->SetSrc(msg->GetDst());
         send_msg->SetDst(sub);
+        // 共享数据，不复制
+        send_msg->SetBuffer(msg->GetBuffer());
         mailbox->Send(send_msg);
       }
     }
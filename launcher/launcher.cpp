@@ -73,11 +73,7 @@ int main(int argc, char** argv) {
 
   // 初始化并启动线程
   g_app = std::make_shared<myframe::App>();
-  if (false == g_app->Init(
-    lib_dir.string(),
-    module_args.GetThreadPoolSize(),
-    module_args.GetConnEventSize(),
-    module_args.GetWarningMsgSize())) {
+  if (false == g_app->Init(lib_dir.string(), module_args.GetAppOptions())) {
     LOG(ERROR) << "Init failed";
     return -1;
   }
@@ -109,9 +105,21 @@ int main(int argc, char** argv) {
   // 注册退出函数
   std::signal(SIGINT, OnShutDown);
 
+  // 记录运行轨迹
+  auto trace_file = module_args.GetTraceFile();
+  if (!trace_file.empty()) {
+    g_app->StartTrace();
+  }
+
   // 开始事件循环
   g_app->Exec();
 
+  if (!trace_file.empty()) {
+    g_app->StopTrace();
+    g_app->DumpTrace(
+      myframe::Common::GetAbsolutePath(trace_file).string());
+  }
+
   // 退出资源清理
   g_app = nullptr;
   LOG(INFO) << "launcher exit";
@@ -37,6 +37,9 @@ ModuleArgument::ModuleArgument(
   parser_.add<std::string>("lib_dir", 0,
     "framework lib dir",
     false, "");
+  parser_.add<std::string>("trace", 0,
+    "record trace and dump to this file on exit(chrome trace format)",
+    false, "");
   parser_.footer("module_config_file ...");
 }
 
@@ -87,6 +90,8 @@ void ModuleArgument::ParseArgument(
   if (!lib_dir.empty()) {
     lib_dir_ = lib_dir;
   }
+
+  trace_file_ = parser_.get<std::string>("trace");
 }
 
 bool ModuleArgument::ParseSysConf(const std::string& sys_conf) {
@@ -105,19 +110,60 @@ bool ModuleArgument::ParseSysConf(const std::string& sys_conf) {
       && root["thread_poll_size"].isInt()
       && root["thread_poll_size"].asInt() > 0
       && root["thread_poll_size"].asInt() < 1024) {
-    thread_poll_size_ = root["thread_poll_size"].asInt();
+    app_opts_.thread_pool_size = root["thread_poll_size"].asInt();
   }
   if (root.isMember("conn_event_size")
       && root["conn_event_size"].isInt()
       && root["conn_event_size"].asInt() > 0
       && root["conn_event_size"].asInt() < 1024) {
-    conn_event_size_ = root["conn_event_size"].asInt();
+    app_opts_.event_conn_size = root["conn_event_size"].asInt();
   }
   if (root.isMember("warning_msg_size")
       && root["warning_msg_size"].isInt()
       && root["warning_msg_size"].asInt() > 0
       && root["warning_msg_size"].asInt() < 1024) {
-    warning_msg_size_ = root["warning_msg_size"].asInt();
+    app_opts_.warning_msg_size = root["warning_msg_size"].asInt();
+  }
+  if (root.isMember("dispatcher_shard_size")
+      && root["dispatcher_shard_size"].isInt()
+      && root["dispatcher_shard_size"].asInt() > 0
+      && root["dispatcher_shard_size"].asInt() < 1024) {
+    app_opts_.dispatcher_shard_size = root["dispatcher_shard_size"].asInt();
+  }
+  if (root.isMember("direct_dispatch")
+      && root["direct_dispatch"].isBool()) {
+    app_opts_.direct_dispatch = root["direct_dispatch"].asBool();
+  }
+  if (root.isMember("worker_cpu_affinity")
+      && root["worker_cpu_affinity"].isArray()) {
+    app_opts_.worker_cpu_affinity = root["worker_cpu_affinity"];
+  }
+  if (root.isMember("spin_time_us")
+      && root["spin_time_us"].isInt()
+      && root["spin_time_us"].asInt() >= 0
+      && root["spin_time_us"].asInt() < 1000000) {
+    app_opts_.spin_time_us = root["spin_time_us"].asInt();
+  }
+  if (root.isMember("timer_resolution_us")
+      && root["timer_resolution_us"].isInt()
+      && root["timer_resolution_us"].asInt() > 0
+      && root["timer_resolution_us"].asInt() <= 1000000) {
+    app_opts_.timer_resolution_us = root["timer_resolution_us"].asInt();
+  }
+  if (root.isMember("timer_worker_size")
+      && root["timer_worker_size"].isInt()
+      && root["timer_worker_size"].asInt() > 0) {
+    app_opts_.timer_worker_size = root["timer_worker_size"].asInt();
+  }
+  if (root.isMember("cache_msg_ttl_ms")
+      && root["cache_msg_ttl_ms"].isInt()
+      && root["cache_msg_ttl_ms"].asInt() > 0) {
+    app_opts_.cache_msg_ttl_ms = root["cache_msg_ttl_ms"].asInt();
+  }
+  if (root.isMember("cache_msg_max_size")
+      && root["cache_msg_max_size"].isInt()
+      && root["cache_msg_max_size"].asInt() > 0) {
+    app_opts_.cache_msg_max_size = root["cache_msg_max_size"].asInt();
   }
   if (root.isMember("log_dir")
       && root["log_dir"].isString()) {
@@ -9,6 +9,7 @@ Author: 李柯鹏 <likepeng0418@163.com>
 #include <list>
 #include "cmdline.h"
 #include "myframe/common.h"
+#include "myframe/app.h"
 
 namespace myframe {
 
@@ -22,21 +23,19 @@ class ModuleArgument final {
   inline std::string GetConfDir() const { return conf_dir_; }
   inline std::string GetLogDir() const { return log_dir_; }
   inline std::string GetLibDir() const { return lib_dir_; }
+  inline std::string GetTraceFile() const { return trace_file_; }
   inline std::string GetBinaryName() const { return binary_name_; }
   inline std::string GetProcessName() const { return process_name_; }
   inline std::string GetCmd() const { return cmd_; }
-  inline int GetThreadPoolSize() const { return thread_poll_size_; }
-  inline int GetConnEventSize() const { return conn_event_size_; }
-  inline int GetWarningMsgSize() const { return warning_msg_size_; }
+  inline const AppOptions& GetAppOptions() const { return app_opts_; }
 
  private:
   bool ParseSysConf(const std::string&);
 
-  int thread_poll_size_{4};
-  int conn_event_size_{2};
-  int warning_msg_size_{10};
+  AppOptions app_opts_;
   std::string log_dir_;
   std::string lib_dir_;
+  std::string trace_file_;
   std::string conf_dir_;
   std::list<std::string> conf_list_;
   stdfs::path default_sys_conf_dir_;
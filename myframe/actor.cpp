@@ -52,23 +52,87 @@ void Actor::SetTypeName(const std::string& name) { actor_name_ = name; }
 
 void Actor::SetInstName(const std::string& name) { instance_name_ = name; }
 
-int Actor::Timeout(const std::string& timer_name, int expired) {
+std::shared_ptr<WorkerTimer> Actor::GetTimerWorker() {
   auto ctx = ctx_.lock();
   if (ctx == nullptr) {
     LOG(ERROR) << "actor context is nullptr";
-    return -1;
+    return nullptr;
   }
   auto app = ctx->GetApp();
   if (app == nullptr) {
     LOG(ERROR) << "app is nullptr";
+    return nullptr;
+  }
+  return app->GetTimerWorker(GetMailbox()->AddrId());
+}
+
+int Actor::Timeout(const std::string& timer_name, int expired) {
+  auto timer_worker = GetTimerWorker();
+  if (timer_worker == nullptr) {
+    return -1;
+  }
+  return timer_worker->SetTimeout(
+    GetMailbox()->Addr(), timer_name, expired);
+}
+
+int Actor::Timeout(
+  const std::string& timer_name,
+  std::chrono::nanoseconds expired) {
+  auto timer_worker = GetTimerWorker();
+  if (timer_worker == nullptr) {
+    return -1;
+  }
+  return timer_worker->SetTimeout(
+    GetMailbox()->Addr(), timer_name, expired);
+}
+
+int Actor::Timeout(
+  const std::string& timer_name,
+  std::chrono::nanoseconds expired,
+  timer_handle_t* handle) {
+  auto timer_worker = GetTimerWorker();
+  if (timer_worker == nullptr || handle == nullptr) {
+    return -1;
+  }
+  return timer_worker->SetTimeout(
+    GetMailbox()->Addr(), timer_name, expired, handle);
+}
+
+int Actor::ResetTimeout(
+  timer_handle_t handle,
+  std::chrono::nanoseconds expired) {
+  auto timer_worker = GetTimerWorker();
+  if (timer_worker == nullptr) {
+    return -1;
+  }
+  return timer_worker->ResetTimeout(handle, expired);
+}
+
+int Actor::Interval(
+  const std::string& timer_name,
+  std::chrono::nanoseconds period) {
+  auto timer_worker = GetTimerWorker();
+  if (timer_worker == nullptr) {
     return -1;
   }
-  auto timer_worker = app->GetTimerWorker();
+  return timer_worker->SetTimeout(
+    GetMailbox()->Addr(), timer_name, period, period);
+}
+
+int Actor::CancelTimeout(const std::string& timer_name) {
+  auto timer_worker = GetTimerWorker();
+  if (timer_worker == nullptr) {
+    return -1;
+  }
+  return timer_worker->CancelTimeout(GetMailbox()->Addr(), timer_name);
+}
+
+int Actor::CancelTimeout(timer_handle_t handle) {
+  auto timer_worker = GetTimerWorker();
   if (timer_worker == nullptr) {
-    LOG(ERROR) << "timer worker is nullptr";
     return -1;
   }
-  return timer_worker->SetTimeout(GetActorName(), timer_name, expired);
+  return timer_worker->CancelTimeout(handle);
 }
 
 bool Actor::Subscribe(const std::string& name) {
@@ -79,15 +143,55 @@ bool Actor::Subscribe(const std::string& name) {
   if (name == GetActorName()) {
     return false;
   }
-  auto msg = std::make_shared<Msg>();
-  msg->SetType("SUBSCRIBE");
   auto mailbox = ctx->GetMailbox();
+  auto msg = mailbox->NewMsg();
+  msg->SetType("SUBSCRIBE");
+  msg->SetPriority(Msg::Priority::kHigh);
   mailbox->Send(name, msg);
   return true;
 }
 
+int Actor::Request(
+  const std::string& dst,
+  std::shared_ptr<Msg> msg,
+  std::chrono::nanoseconds timeout,
+  RequestCallback cb) {
+  auto ctx = ctx_.lock();
+  if (ctx == nullptr || msg == nullptr) {
+    return -1;
+  }
+  if (ctx->AddRequest(msg.get(), timeout, std::move(cb))) {
+    return -1;
+  }
+  ctx->GetMailbox()->Send(dst, std::move(msg));
+  return 0;
+}
+
+int Actor::Request(
+  addr_id_t dst,
+  std::shared_ptr<Msg> msg,
+  std::chrono::nanoseconds timeout,
+  RequestCallback cb) {
+  auto ctx = ctx_.lock();
+  if (ctx == nullptr || msg == nullptr) {
+    return -1;
+  }
+  if (ctx->AddRequest(msg.get(), timeout, std::move(cb))) {
+    return -1;
+  }
+  ctx->GetMailbox()->Send(dst, std::move(msg));
+  return 0;
+}
+
 void Actor::SetContext(std::shared_ptr<ActorContext> c) { ctx_ = c; }
 
+void Actor::ProcBatch(
+  const std::vector<std::shared_ptr<const Msg>>& msgs) {
+  for (const auto& msg : msgs) {
+    Proc(msg);
+  }
+}
+
 const Json::Value* Actor::GetConfig() const {
   return &config_;
 }
@@ -7,8 +7,11 @@ Author: 李柯鹏 <likepeng0418@163.com>
 
 #pragma once
 #include <any>
+#include <chrono>
+#include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <json/json.h>
 
@@ -21,6 +24,7 @@ namespace myframe {
 class Msg;
 class ActorContext;
 class App;
+class WorkerTimer;
 class MYFRAME_EXPORT Actor {
   friend class App;
   friend class ActorContext;
@@ -28,6 +32,10 @@ class MYFRAME_EXPORT Actor {
   friend class ModManager;
 
  public:
+  /* 请求回调，超时时resp为nullptr */
+  using RequestCallback =
+    std::function<void(const std::shared_ptr<const Msg>& resp)>;
+
   Actor() = default;
   virtual ~Actor();
 
@@ -61,9 +69,25 @@ class MYFRAME_EXPORT Actor {
    * Proc() - 消息处理函数
    * @msg:      actor收到的消息
    *
+   *      收件箱容量通过 instance_config 配置(默认不限制):
+   *        "instance_config":{"mailbox_capacity":1000,
+   *                           "mailbox_policy":"drop_newest"}
+   *      策略: drop_newest/drop_oldest/reject/credit,
+   *      reject策略下发送者会收到类型为 MSG_TYPE_REJECT 的消息
    */
   virtual void Proc(const std::shared_ptr<const Msg>& msg) = 0;
 
+  /**
+   * ProcBatch() - 批量消息处理函数
+   * @msgs:     本次调度中actor收到的消息(按接收顺序)
+   *
+   *      默认逐个调用Proc(); 需要批量处理消息(比如聚合、批量写入)
+   *      的actor可以重写该函数。
+   *      每批最多的消息数通过 instance_config 配置:
+   *        "instance_config":{"max_batch_size":64}
+   */
+  virtual void ProcBatch(const std::vector<std::shared_ptr<const Msg>>& msgs);
+
   /**
    * Mailbox() - 发送消息的mailbox
    *
@@ -76,8 +100,10 @@ class MYFRAME_EXPORT Actor {
    * @expired: 超时时间(单位:10ms, 比如 expired = 1, 那么超时时间就是10ms)
    *
    *      定时器设置之后，过了超时时间，actor就会收到超时消息;
-   *      如果想实现周期性的定时器，可以在收到超时消息之后，
-   *      再次调用此函数设置下一次的超时。
+   *      周期性的定时器使用 Interval()。
+   *      同名定时器未超时之前再次设置，会再增加一个定时器，
+   *      之前的定时器仍然有效；需要替换时使用带句柄的 Timeout() 和
+   *      ResetTimeout()，或者先调用 CancelTimeout()。
    *
    *      msg->GetType() == "TIMER" 确认是定时器消息
    *      msg->GetDesc() == timer_name 确认是那个定时器消息
@@ -85,6 +111,50 @@ class MYFRAME_EXPORT Actor {
    * @return:         成功返回: 0, 失败返回: -1
    */
   int Timeout(const std::string& timer_name, int expired);
+  int Timeout(const std::string& timer_name, std::chrono::nanoseconds expired);
+  /**
+   * Timeout() - 设置独立的定时器
+   * @handle: 返回定时器句柄
+   *
+   *      不加入名字索引，只能通过句柄取消或者重新设置，
+   *      适合为每个请求设置超时；设置/超时/取消都不分配内存。
+   *
+   * @return:         成功返回: 0, 失败返回: -1
+   */
+  int Timeout(
+    const std::string& timer_name,
+    std::chrono::nanoseconds expired,
+    timer_handle_t* handle);
+  /**
+   * ResetTimeout() - 重新设置未超时的定时器
+   * @expired: 从现在开始计算的超时时间
+   *
+   * @return:         成功返回: 0, 句柄已失效返回: -1
+   */
+  int ResetTimeout(timer_handle_t handle, std::chrono::nanoseconds expired);
+
+  /**
+   * Interval() - 设置周期定时器
+   * @period: 周期，精度由定时器精度决定(默认1ms)
+   *
+   *      每个周期actor收到一次超时消息，直到调用 CancelTimeout();
+   *      下一次超时时刻按上一次的超时时刻计算，不会累积误差。
+   *
+   * @return:         成功返回: 0, 失败返回: -1
+   */
+  int Interval(const std::string& timer_name, std::chrono::nanoseconds period);
+
+  /**
+   * CancelTimeout() - 取消定时器
+   *
+   *      按名字取消时取消所有同名的定时器(包括周期定时器);
+   *      已经发出的超时消息不会被取消；
+   *      取消由定时器线程异步执行，和超时同时发生时以先处理的为准。
+   *
+   * @return:         成功返回: 0, 定时器不存在/句柄已失效返回: -1
+   */
+  int CancelTimeout(const std::string& timer_name);
+  int CancelTimeout(timer_handle_t handle);
 
   /**
    * Subscribe() - 订阅actor或者worker的消息
@@ -97,6 +167,31 @@ class MYFRAME_EXPORT Actor {
    */
   bool Subscribe(const std::string& name);
 
+  /**
+   * Request() - 发送请求
+   * @dst:      目的地址(名称或者地址句柄)
+   * @timeout:  超时时间，由定时器实现，需要大于0
+   * @cb:       回调函数
+   *
+   *      请求带上关联ID发送，不阻塞; 对方使用 Mailbox::Reply() 回复后,
+   *      actor在处理消息时调用cb(resp)，回复不会传给Proc();
+   *      超时未回复时调用cb(nullptr)，之后到达的回复被丢弃。
+   *      对方收件箱已满拒绝请求时，resp->GetType() == MSG_TYPE_REJECT。
+   *      每个请求的回调只调用一次，可以同时发送多个请求。
+   *
+   * @return:         成功返回: 0, 失败返回: -1
+   */
+  int Request(
+    const std::string& dst,
+    std::shared_ptr<Msg> msg,
+    std::chrono::nanoseconds timeout,
+    RequestCallback cb);
+  int Request(
+    addr_id_t dst,
+    std::shared_ptr<Msg> msg,
+    std::chrono::nanoseconds timeout,
+    RequestCallback cb);
+
   /**
    * GetApp() - 获得应用实例
    *
@@ -109,6 +204,7 @@ class MYFRAME_EXPORT Actor {
 
  private:
   bool IsFromLib() const;
+  std::shared_ptr<WorkerTimer> GetTimerWorker();
   void SetModName(const std::string& name);
   void SetTypeName(const std::string& name);
   void SetInstName(const std::string& name);
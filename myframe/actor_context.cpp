@@ -7,15 +7,24 @@ Author: 李柯鹏 <likepeng0418@163.com>
 
 #include "myframe/actor_context.h"
 
+#include <algorithm>
 #include <sstream>
 
 #include "myframe/log.h"
 #include "myframe/actor.h"
 #include "myframe/app.h"
 #include "myframe/msg.h"
+#include "myframe/poller.h"
+#include "myframe/dispatch_shard.h"
+#include "myframe/scheduler.h"
+#include "myframe/worker_timer.h"
+#include "myframe/trace.h"
 
 namespace myframe {
 
+/* 请求超时定时器名 */
+static const char* const kRequestTimerName = "myframe.request";
+
 ActorContext::ActorContext(
   std::shared_ptr<App> app,
   std::shared_ptr<Actor> actor)
@@ -28,12 +37,25 @@ ActorContext::ActorContext(
 }
 
 ActorContext::~ActorContext() {
+  LOG_IF(INFO, mailbox_limit_.IsBounded())
+    << mailbox_.Addr() << " mailbox " << mailbox_limit_;
   LOG(INFO) << mailbox_.Addr() << " context deconstruct";
 }
 
 std::shared_ptr<App> ActorContext::GetApp() { return app_.lock(); }
 
 int ActorContext::Init(const char* param) {
+  // 批处理大小, instance_config: {"max_batch_size": 64}
+  auto cfg = actor_->GetConfig();
+  if (cfg->isMember("max_batch_size")) {
+    if ((*cfg)["max_batch_size"].isInt()
+        && (*cfg)["max_batch_size"].asInt() > 0) {
+      max_batch_size_ = (*cfg)["max_batch_size"].asInt();
+    } else {
+      LOG(WARNING) << mailbox_.Addr() << " invalid max_batch_size, use "
+        << max_batch_size_;
+    }
+  }
   actor_->SetContext(shared_from_this());
   return actor_->Init(param);
 }
@@ -43,9 +65,230 @@ Mailbox* ActorContext::GetMailbox() {
 }
 
 void ActorContext::Proc(const std::shared_ptr<const Msg>& msg) {
+  if (IsRequestEvent(*msg)) {
+    ProcRequestEvent(msg);
+    return;
+  }
   actor_->Proc(msg);
 }
 
+void ActorContext::ProcBatch(
+  const std::vector<std::shared_ptr<const Msg>>& msgs) {
+  auto begin = std::chrono::steady_clock::now();
+  auto send_size = mailbox_.SendSize();
+  ProcMsgs(msgs);
+  auto end = std::chrono::steady_clock::now();
+  metrics_.OnProc(
+    msgs.size(),
+    std::max(0, mailbox_.SendSize() - send_size),
+    end - begin);
+  Tracer::Span(
+    Tracer::Event::kProc, mailbox_.AddrId(), begin, end, msgs.size());
+}
+
+// 回复/超时消息交给回调，其余消息保持原有顺序分段批处理
+void ActorContext::ProcMsgs(
+  const std::vector<std::shared_ptr<const Msg>>& msgs) {
+  std::size_t i = 0;
+  while (i < msgs.size() && !IsRequestEvent(*msgs[i])) {
+    ++i;
+  }
+  if (i == msgs.size()) {
+    actor_->ProcBatch(msgs);
+    return;
+  }
+  batch_msgs_.assign(msgs.begin(), msgs.begin() + i);
+  for (; i < msgs.size(); ++i) {
+    if (!IsRequestEvent(*msgs[i])) {
+      batch_msgs_.emplace_back(msgs[i]);
+      continue;
+    }
+    if (!batch_msgs_.empty()) {
+      actor_->ProcBatch(batch_msgs_);
+      batch_msgs_.clear();
+    }
+    ProcRequestEvent(msgs[i]);
+  }
+  if (!batch_msgs_.empty()) {
+    actor_->ProcBatch(batch_msgs_);
+    batch_msgs_.clear();
+  }
+}
+
+int ActorContext::AddRequest(
+  Msg* msg,
+  std::chrono::nanoseconds timeout,
+  Actor::RequestCallback cb) {
+  if (cb == nullptr) {
+    LOG(ERROR) << mailbox_.Addr() << " request callback is nullptr";
+    return -1;
+  }
+  auto app = GetApp();
+  if (app == nullptr) {
+    return -1;
+  }
+  auto timer_worker = app->GetTimerWorker(mailbox_.AddrId());
+  if (timer_worker == nullptr) {
+    return -1;
+  }
+  // 超时定时器句柄作为关联ID, 句柄在定时器超时/取消后失效，不会重复
+  timer_handle_t id = INVALID_TIMER_HANDLE;
+  if (timer_worker->SetTimeout(
+      mailbox_.Addr(), kRequestTimerName, timeout, &id)) {
+    LOG(ERROR) << mailbox_.Addr() << " set request timeout "
+      << timeout.count() << "ns failed";
+    return -1;
+  }
+  msg->SetCorrelationId(id);
+  msg->SetReply(false);
+  requests_.emplace(id, std::move(cb));
+  pending_request_size_.store(requests_.size());
+  return 0;
+}
+
+bool ActorContext::IsRequestEvent(const Msg& msg) {
+  if (msg.IsReply()) {
+    return true;
+  }
+  return msg.GetCorrelationId() != 0
+    && msg.GetType() == "TIMER"
+    && msg.GetDesc() == kRequestTimerName;
+}
+
+void ActorContext::ProcRequestEvent(const std::shared_ptr<const Msg>& msg) {
+  auto it = requests_.find(msg->GetCorrelationId());
+  if (it == requests_.end()) {
+    VLOG(1) << mailbox_.Addr() << " drop expired request event " << *msg;
+    return;
+  }
+  auto cb = std::move(it->second);
+  requests_.erase(it);
+  pending_request_size_.store(requests_.size());
+  if (!msg->IsReply()) {
+    VLOG(1) << mailbox_.Addr() << " request " << msg->GetCorrelationId()
+      << " timeout";
+    cb(nullptr);
+    return;
+  }
+  auto app = GetApp();
+  if (app != nullptr) {
+    auto timer_worker = app->GetTimerWorker(mailbox_.AddrId());
+    if (timer_worker != nullptr) {
+      timer_worker->CancelTimeout(msg->GetCorrelationId());
+    }
+  }
+  cb(msg);
+}
+
+bool ActorContext::IsAllowedWorker(std::size_t index) const {
+  if (worker_affinity_.empty()) {
+    return true;
+  }
+  for (auto i : worker_affinity_) {
+    if (i == index) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void ActorContext::SetScheduler(
+  std::shared_ptr<Scheduler> scheduler,
+  MsgQueue::Type inbox_type) {
+  scheduler_ = scheduler;
+  if (scheduler_ != nullptr) {
+    for (auto& inbox : inbox_) {
+      inbox = MsgQueue::Create(inbox_type);
+    }
+  }
+}
+
+bool ActorContext::Mute() {
+  int state = kMuteNone;
+  return mute_state_.compare_exchange_strong(state, kMuted);
+}
+
+// 直接分发模式下已移出调度器的actor重新放入调度器,
+// 否则唤醒actor所在的分片重新调度
+void ActorContext::Unmute() {
+  auto state = mute_state_.exchange(kMuteNone);
+  if (state == kParked) {
+    scheduler_->Push(shared_from_this(), HasHighInbox());
+    return;
+  }
+  if (state == kMuted && scheduler_ == nullptr) {
+    auto app = app_.lock();
+    if (app == nullptr) {
+      return;
+    }
+    auto shard = app->GetShard(mailbox_.AddrId());
+    if (shard != nullptr) {
+      shard->GetPoller()->Wakeup();
+    }
+  }
+}
+
+bool ActorContext::Park() {
+  int state = kMuted;
+  return mute_state_.compare_exchange_strong(state, kParked);
+}
+
+void ActorContext::Deliver(std::shared_ptr<Msg> msg) {
+  bool high = msg->GetPriority() == Msg::Priority::kHigh;
+  auto depth = inbox_size_.fetch_add(1) + 1;
+  metrics_.UpdateMaxDepth(depth);
+  Tracer::Instant(Tracer::Event::kEnqueue, mailbox_.AddrId(), depth);
+  inbox_[static_cast<std::size_t>(msg->GetPriority())]->Push(std::move(msg));
+  if (!scheduled_.exchange(true)) {
+    scheduler_->Push(shared_from_this(), high);
+  }
+}
+
+std::size_t ActorContext::PopInbox(
+  std::vector<std::shared_ptr<const Msg>>* msgs,
+  std::size_t max) {
+  std::size_t cnt = 0;
+  for (std::size_t i = Msg::kPriorityLevels; i > 0 && cnt < max; --i) {
+    cnt += inbox_[i - 1]->PopBatch(msgs, max - cnt);
+  }
+  inbox_size_.fetch_sub(cnt);
+  return cnt;
+}
+
+bool ActorContext::DropInbox() {
+  for (auto& inbox : inbox_) {
+    if (inbox->Pop() != nullptr) {
+      inbox_size_.fetch_sub(1);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ActorContext::InboxEmpty() const {
+  for (const auto& inbox : inbox_) {
+    if (!inbox->Empty()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ActorContext::HasHighInbox() const {
+  return !inbox_[static_cast<std::size_t>(Msg::Priority::kHigh)]->Empty();
+}
+
+// 先清除调度标志再检查收件箱，避免与Deliver()竞争时丢失调度
+void ActorContext::Yield() {
+  scheduled_.exchange(false);
+  if (InboxEmpty()) {
+    return;
+  }
+  if (!scheduled_.exchange(true)) {
+    scheduler_->Push(shared_from_this(), HasHighInbox());
+  }
+}
+
 std::ostream& operator<<(std::ostream& out, const ActorContext& ctx) {
   out << ctx.actor_->GetActorName() << ", in worker: " << ctx.in_worker_
      << ", in wait queue: " << ctx.in_wait_que_;
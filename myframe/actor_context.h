@@ -6,19 +6,28 @@ Author: 李柯鹏 <likepeng0418@163.com>
 ****************************************************************************/
 
 #pragma once
+#include <atomic>
+#include <chrono>
 #include <list>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "myframe/macros.h"
+#include "myframe/actor.h"
 #include "myframe/mailbox.h"
+#include "myframe/mailbox_limit.h"
+#include "myframe/msg.h"
+#include "myframe/msg_queue.h"
+#include "myframe/metrics.h"
 
 namespace myframe {
 
 class App;
 class Msg;
-class Actor;
 class WorkerCommon;
+class Scheduler;
 class ActorContext final : public std::enable_shared_from_this<ActorContext> {
   friend std::ostream& operator<<(std::ostream& out, const ActorContext& ctx);
   friend class ActorContextManager;
@@ -30,10 +39,16 @@ class ActorContext final : public std::enable_shared_from_this<ActorContext> {
   virtual ~ActorContext();
 
   Mailbox* GetMailbox();
+  /* 收件箱容量限制 */
+  MailboxLimit* GetMailboxLimit() { return &mailbox_limit_; }
 
   int Init(const char* param);
 
   void Proc(const std::shared_ptr<const Msg>& msg);
+  /* 处理一批消息并记录运行指标 */
+  void ProcBatch(const std::vector<std::shared_ptr<const Msg>>& msgs);
+  /* 每次调度最多处理的消息数 */
+  std::size_t GetMaxBatchSize() const { return max_batch_size_; }
 
   void SetRuningFlag(bool in_worker) { in_worker_ = in_worker; }
   bool IsRuning() { return in_worker_; }
@@ -44,14 +59,97 @@ class ActorContext final : public std::enable_shared_from_this<ActorContext> {
   std::shared_ptr<Actor> GetActor() { return actor_; }
   std::shared_ptr<App> GetApp();
 
+  /* actor可以运行的工作线程，为空时可以在任意工作线程运行 */
+  const std::vector<std::size_t>& GetWorkerAffinity() const {
+    return worker_affinity_;
+  }
+  /* 在actor放入调度器之前设置 */
+  void SetWorkerAffinity(const std::vector<std::size_t>& workers) {
+    worker_affinity_ = workers;
+  }
+  bool IsAllowedWorker(std::size_t index) const;
+
+  /// 请求/回复
+  /* 给请求设置关联ID及超时定时器并记录回调，在actor处理消息时调用 */
+  int AddRequest(
+    Msg* msg,
+    std::chrono::nanoseconds timeout,
+    Actor::RequestCallback cb);
+  /* 未回复的请求数，可以在任意线程调用 */
+  std::size_t PendingRequestSize() const {
+    return pending_request_size_.load();
+  }
+
+  /* 运行指标 */
+  ActorMetrics* GetMetrics() { return &metrics_; }
+
+  /// 发送者限流(收件箱credit策略)
+  /* 暂停调度该actor，已经暂停时返回false */
+  bool Mute();
+  /* 恢复调度该actor，可以在任意线程调用 */
+  void Unmute();
+  bool IsMuted() const { return mute_state_.load() != kMuteNone; }
+
+  /// 直接分发模式
+  /* 投递消息到actor收件箱并将actor放入调度器，可以在任意线程调用 */
+  void Deliver(std::shared_ptr<Msg> msg);
+  /* 收件箱中未处理的消息数(近似值) */
+  std::size_t InboxSize() const { return inbox_size_.load(); }
+  /* 丢弃收件箱最低优先级通道中最早的消息, 要求收件箱是locked类型 */
+  bool DropInbox();
+
  private:
+  /* 是否是请求的回复或者超时消息 */
+  static bool IsRequestEvent(const Msg& msg);
+  /* 回复/超时消息交给回调，其余消息交给actor */
+  void ProcMsgs(const std::vector<std::shared_ptr<const Msg>>& msgs);
+  /* 调用请求的回调 */
+  void ProcRequestEvent(const std::shared_ptr<const Msg>& msg);
+  void SetScheduler(
+    std::shared_ptr<Scheduler> scheduler,
+    MsgQueue::Type inbox_type = MsgQueue::Type::kMpsc);
+  /* 最多取出max个收件箱中的消息，先取高优先级通道 */
+  std::size_t PopInbox(
+    std::vector<std::shared_ptr<const Msg>>* msgs,
+    std::size_t max);
+  bool InboxEmpty() const;
+  bool HasHighInbox() const;
+  /* 处理完消息后调用，收件箱有消息时重新放入调度器 */
+  void Yield();
+  /* 处理完消息后调用，actor被暂停时不再放入调度器，由Unmute()重新放入 */
+  bool Park();
+
   Mailbox mailbox_;
   /* 该actor的是否在工作线程的标志 */
   bool in_worker_;
   /* actor是否在消息队列中 */
   bool in_wait_que_;
+  /* actor所在消息队列的优先级 */
+  std::size_t wait_lane_{0};
   std::shared_ptr<Actor> actor_;
   std::weak_ptr<App> app_;
+  std::size_t max_batch_size_{64};
+  /// key: 关联ID(超时定时器句柄), value: 回调
+  std::unordered_map<uint64_t, Actor::RequestCallback> requests_;
+  std::atomic<std::size_t> pending_request_size_{0};
+  /// 去掉回复消息后的批处理消息
+  std::vector<std::shared_ptr<const Msg>> batch_msgs_;
+  /* 绑定的工作线程序号 */
+  std::vector<std::size_t> worker_affinity_;
+  /// 直接分发模式的收件箱
+  std::shared_ptr<Scheduler> scheduler_{nullptr};
+  /* 按消息优先级分通道 */
+  std::shared_ptr<MsgQueue> inbox_[Msg::kPriorityLevels];
+  /* actor是否在调度器中或正在运行 */
+  std::atomic_bool scheduled_{false};
+  std::atomic<std::size_t> inbox_size_{0};
+  /// 收件箱容量限制
+  MailboxLimit mailbox_limit_;
+  /// 暂停状态: 未暂停/已暂停/已暂停且已移出调度器
+  enum : int { kMuteNone, kMuted, kParked };
+  std::atomic_int mute_state_{kMuteNone};
+  /// 运行指标
+  ActorMetrics metrics_;
 
   DISALLOW_COPY_AND_ASSIGN(ActorContext)
 };
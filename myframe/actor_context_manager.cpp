@@ -13,6 +13,7 @@ Author: 李柯鹏 <likepeng0418@163.com>
 #include "myframe/msg.h"
 #include "myframe/actor.h"
 #include "myframe/actor_context.h"
+#include "myframe/trace.h"
 
 namespace myframe {
 
@@ -24,18 +25,20 @@ ActorContextManager::~ActorContextManager() {
   LOG(INFO) << "ActorContextManager deconstruct";
 }
 
-void ActorContextManager::DispatchMsg(
+bool ActorContextManager::DispatchMsg(
     std::shared_ptr<Msg> msg,
-    const std::string& dst) {
-  std::string actor_name = dst.empty()? msg->GetDst() : dst;
-  auto ctx = GetContext(actor_name);
+    addr_id_t dst) {
+  auto ctx = GetContext(dst);
   if (nullptr == ctx) {
-    LOG(ERROR) << "Unknown msg " << *msg;
-    return;
+    return false;
   }
   auto mailbox = ctx->GetMailbox();
-  mailbox->Recv(msg);
-  PushContext(ctx);
+  auto priority = msg->GetPriority();
+  mailbox->Recv(std::move(msg));
+  ctx->GetMetrics()->SetDepth(mailbox->RecvSize());
+  Tracer::Instant(Tracer::Event::kEnqueue, dst, mailbox->RecvSize());
+  PushContext(ctx, priority);
+  return true;
 }
 
 bool ActorContextManager::RegContext(std::shared_ptr<ActorContext> ctx) {
@@ -47,18 +50,32 @@ bool ActorContextManager::RegContext(std::shared_ptr<ActorContext> ctx) {
   }
   LOG(INFO) << "reg actor " << ctx->GetActor()->GetActorName();
   ctxs_[ctx->GetActor()->GetActorName()] = ctx;
+  auto id = ctx->GetMailbox()->AddrId();
+  if (id != INVALID_ADDR_ID) {
+    if (id >= id_ctxs_.size()) {
+      id_ctxs_.resize(id + 1);
+    }
+    id_ctxs_[id] = ctx;
+  }
   return true;
 }
 
-std::shared_ptr<ActorContext> ActorContextManager::GetContext(
-    const std::string& actor_name) {
+std::shared_ptr<ActorContext> ActorContextManager::GetContext(addr_id_t id) {
   std::shared_lock<std::shared_mutex> lk(rw_);
-  if (ctxs_.find(actor_name) == ctxs_.end()) {
-    LOG(WARNING) << "not found " << actor_name;
+  if (id >= id_ctxs_.size()) {
     return nullptr;
   }
-  auto ctx = ctxs_[actor_name];
-  return ctx;
+  return id_ctxs_[id];
+}
+
+std::vector<std::shared_ptr<ActorContext>>
+ActorContextManager::GetAllContext() {
+  std::vector<std::shared_ptr<ActorContext>> res;
+  std::shared_lock<std::shared_mutex> lk(rw_);
+  for (auto& ctx : ctxs_) {
+    res.push_back(ctx.second);
+  }
+  return res;
 }
 
 std::vector<std::string> ActorContextManager::GetAllActorAddr() {
@@ -75,38 +92,64 @@ bool ActorContextManager::HasActor(const std::string& name) {
   return ctxs_.find(name) != ctxs_.end();
 }
 
+bool ActorContextManager::HasActor(addr_id_t id) {
+  return GetContext(id) != nullptr;
+}
+
 void ActorContextManager::PrintWaitQueue() {
+  if (!VLOG_IS_ON(1)) {
+    return;
+  }
   VLOG(1) << "cur wait queue actor:";
-  auto it = wait_queue_.begin();
-  while (it != wait_queue_.end()) {
-    auto ctx = it->lock();
-    if (ctx == nullptr) {
-      LOG(ERROR) << "context is nullptr";
-      continue;
+  for (std::size_t lane = Msg::kPriorityLevels; lane > 0; --lane) {
+    for (auto& it : wait_queue_[lane - 1]) {
+      auto ctx = it.lock();
+      if (ctx == nullptr) {
+        LOG(ERROR) << "context is nullptr";
+        continue;
+      }
+      VLOG(1) << "|--> " << *ctx;
     }
-    VLOG(1) << "|--> " << *ctx;
-    ++it;
   }
 }
 
-std::shared_ptr<ActorContext> ActorContextManager::GetContextWithMsg() {
-  if (wait_queue_.empty()) {
+std::shared_ptr<ActorContext> ActorContextManager::GetContextWithMsg(
+  std::size_t worker_index) {
+  for (std::size_t lane = Msg::kPriorityLevels; lane > 0; --lane) {
+    auto ctx = PopContext(lane - 1, worker_index);
+    if (ctx != nullptr) {
+      return ctx;
+    }
+  }
+  return nullptr;
+}
+
+std::shared_ptr<ActorContext> ActorContextManager::PopContext(
+  std::size_t lane,
+  std::size_t worker_index) {
+  auto& wait_queue = wait_queue_[lane];
+  if (wait_queue.empty()) {
     return nullptr;
   }
 
   std::vector<std::shared_ptr<ActorContext>> in_runing_context;
+  std::vector<std::shared_ptr<ActorContext>> other_worker_context;
   std::shared_ptr<ActorContext> ret = nullptr;
-  while (!wait_queue_.empty()) {
-    if (wait_queue_.front().expired()) {
-      wait_queue_.pop_front();
+  while (!wait_queue.empty()) {
+    if (wait_queue.front().expired()) {
+      wait_queue.pop_front();
       continue;
     }
-    auto ctx = wait_queue_.front().lock();
+    auto ctx = wait_queue.front().lock();
     if (ctx->IsRuning()) {
-      wait_queue_.pop_front();
+      wait_queue.pop_front();
       in_runing_context.push_back(ctx);
+    } else if (!ctx->IsAllowedWorker(worker_index) || ctx->IsMuted()) {
+      // 绑定其它工作线程或者被限流暂停的actor
+      wait_queue.pop_front();
+      other_worker_context.push_back(ctx);
     } else {
-      wait_queue_.pop_front();
+      wait_queue.pop_front();
 
       ctx->SetRuningFlag(true);
       ctx->SetWaitQueueFlag(false);
@@ -114,22 +157,39 @@ std::shared_ptr<ActorContext> ActorContextManager::GetContextWithMsg() {
       break;
     }
   }
+  // 跳过的actor保持原有顺序放回队列头部
+  wait_queue.insert(wait_queue.begin(),
+    other_worker_context.begin(), other_worker_context.end());
   for (std::size_t i = 0; i < in_runing_context.size(); ++i) {
     VLOG(1) << in_runing_context[i]->GetActor()->GetActorName()
                << " is runing, move to wait queue back";
-    wait_queue_.push_back(in_runing_context[i]);
+    wait_queue.push_back(in_runing_context[i]);
   }
   return ret;
 }
 
-void ActorContextManager::PushContext(std::shared_ptr<ActorContext> ctx) {
+void ActorContextManager::PushContext(
+  std::shared_ptr<ActorContext> ctx,
+  Msg::Priority priority) {
+  auto lane = static_cast<std::size_t>(priority);
   if (ctx->IsInWaitQueue()) {
-    VLOG(1) << *ctx << " already in wait queue, return";
-    PrintWaitQueue();
-    return;
+    if (lane <= ctx->wait_lane_) {
+      VLOG(1) << *ctx << " already in wait queue, return";
+      PrintWaitQueue();
+      return;
+    }
+    // 收到高优先级消息，从低优先级链表移到高优先级链表
+    auto& low = wait_queue_[ctx->wait_lane_];
+    for (auto it = low.begin(); it != low.end(); ++it) {
+      if (it->lock() == ctx) {
+        low.erase(it);
+        break;
+      }
+    }
   }
   ctx->SetWaitQueueFlag(true);
-  wait_queue_.push_back(ctx);
+  ctx->wait_lane_ = lane;
+  wait_queue_[lane].push_back(ctx);
   PrintWaitQueue();
 }
 
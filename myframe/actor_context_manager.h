@@ -17,9 +17,9 @@ Author: 李柯鹏 <likepeng0418@163.com>
 #include <unordered_map>
 
 #include "myframe/macros.h"
+#include "myframe/msg.h"
 
 namespace myframe {
-class Msg;
 class ActorContext;
 class ActorContextManager final {
  public:
@@ -29,31 +29,43 @@ class ActorContextManager final {
   /* 注册actor */
   bool RegContext(std::shared_ptr<ActorContext> ctx);
 
-  void DispatchMsg(
+  /* 分发消息给地址句柄对应的actor，actor不存在返回false */
+  bool DispatchMsg(
     std::shared_ptr<Msg> msg,
-    const std::string& dst = "");
+    addr_id_t dst);
 
-  /* 获得一个待处理的actor */
-  std::shared_ptr<ActorContext> GetContextWithMsg();
+  /* 获得一个可以在第worker_index个工作线程运行的待处理actor */
+  std::shared_ptr<ActorContext> GetContextWithMsg(
+    std::size_t worker_index = static_cast<std::size_t>(-1));
 
   std::vector<std::string> GetAllActorAddr();
+  std::vector<std::shared_ptr<ActorContext>> GetAllContext();
   bool HasActor(const std::string& name);
+  bool HasActor(addr_id_t id);
+  /* 获得地址句柄对应的actor */
+  std::shared_ptr<ActorContext> GetContext(addr_id_t id);
 
  private:
-  /* 获得actor名对应的actor */
-  std::shared_ptr<ActorContext> GetContext(const std::string& actor_name);
-  /* 将有消息的actor放入链表 */
-  void PushContext(std::shared_ptr<ActorContext> ctx);
+  /* 将有消息的actor放入优先级对应的链表，
+   * 已在低优先级链表中的actor移到高优先级链表 */
+  void PushContext(
+    std::shared_ptr<ActorContext> ctx,
+    Msg::Priority priority = Msg::Priority::kNormal);
+  /* 从第lane个链表获得可以在第worker_index个工作线程运行的actor */
+  std::shared_ptr<ActorContext> PopContext(
+    std::size_t lane, std::size_t worker_index);
   void PrintWaitQueue();
 
   /// 当前注册actor数量
   uint32_t ctx_count_;
-  /// 待处理actor链表
-  std::list<std::weak_ptr<ActorContext>> wait_queue_;
+  /// 待处理actor链表(按优先级，高优先级的先调度)
+  std::list<std::weak_ptr<ActorContext>> wait_queue_[Msg::kPriorityLevels];
   /// 读写锁
   std::shared_mutex rw_;
   /// key: context name, value: context
   std::unordered_map<std::string, std::shared_ptr<ActorContext>> ctxs_;
+  /// index: addr id, value: context
+  std::vector<std::shared_ptr<ActorContext>> id_ctxs_;
 
   DISALLOW_COPY_AND_ASSIGN(ActorContextManager)
 };
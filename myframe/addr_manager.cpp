@@ -0,0 +1,95 @@
+/****************************************************************************
+Copyright (c) 2019, 李柯鹏
+All rights reserved.
+
+Author: 李柯鹏 <likepeng0418@163.com>
+****************************************************************************/
+
+#include "myframe/addr_manager.h"
+
+#include "myframe/log.h"
+#include "myframe/common.h"
+
+namespace myframe {
+
+AddrManager::AddrManager() {
+  // 句柄0保留为无效地址
+  addrs_.emplace_back("", Type::kInvalid);
+  Intern(MAIN_ADDR);
+  LOG(INFO) << "AddrManager create";
+}
+
+AddrManager::~AddrManager() {
+  LOG(INFO) << "AddrManager deconstruct";
+}
+
+AddrManager::Type AddrManager::ParseType(const std::string& addr) {
+  if (addr == MAIN_ADDR) {
+    return Type::kMain;
+  }
+  auto name_list = Common::SplitMsgName(addr);
+  if (name_list.size() < 2) {
+    return Type::kInvalid;
+  }
+  if (name_list[0] == "actor") {
+    return Type::kActor;
+  } else if (name_list[0] == "worker") {
+    return Type::kWorker;
+  } else if (name_list[0] == "event") {
+    if (name_list[1] == "conn") {
+      return Type::kEventConn;
+    }
+    return Type::kInvalid;
+  }
+  return Type::kOther;
+}
+
+addr_id_t AddrManager::Intern(const std::string& addr) {
+  auto id = Find(addr);
+  if (id != INVALID_ADDR_ID) {
+    return id;
+  }
+  auto type = ParseType(addr);
+  std::unique_lock<std::shared_mutex> lk(rw_);
+  auto it = addr_id_map_.find(addr);
+  if (it != addr_id_map_.end()) {
+    return it->second;
+  }
+  id = static_cast<addr_id_t>(addrs_.size());
+  addrs_.emplace_back(addr, type);
+  addr_id_map_[addr] = id;
+  VLOG(1) << "intern addr " << addr << " to " << id;
+  return id;
+}
+
+addr_id_t AddrManager::Find(const std::string& addr) {
+  std::shared_lock<std::shared_mutex> lk(rw_);
+  auto it = addr_id_map_.find(addr);
+  if (it == addr_id_map_.end()) {
+    return INVALID_ADDR_ID;
+  }
+  return it->second;
+}
+
+const std::string& AddrManager::GetAddr(addr_id_t id) {
+  std::shared_lock<std::shared_mutex> lk(rw_);
+  if (id >= addrs_.size()) {
+    return addrs_[INVALID_ADDR_ID].addr;
+  }
+  return addrs_[id].addr;
+}
+
+AddrManager::Type AddrManager::GetType(addr_id_t id) {
+  std::shared_lock<std::shared_mutex> lk(rw_);
+  if (id >= addrs_.size()) {
+    return Type::kInvalid;
+  }
+  return addrs_[id].type;
+}
+
+std::size_t AddrManager::Size() {
+  std::shared_lock<std::shared_mutex> lk(rw_);
+  return addrs_.size();
+}
+
+}  // namespace myframe
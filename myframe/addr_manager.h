@@ -0,0 +1,75 @@
+/****************************************************************************
+Copyright (c) 2019, 李柯鹏
+All rights reserved.
+
+Author: 李柯鹏 <likepeng0418@163.com>
+****************************************************************************/
+#pragma once
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+#include "myframe/macros.h"
+#include "myframe/msg.h"
+
+namespace myframe {
+
+/**
+ * 地址管理对象
+ *
+ *  将 actor/worker/main/event 等字符串地址转换为整型地址句柄,
+ *  地址只在第一次使用时解析一次, 之后分发消息时使用句柄索引,
+ *  字符串地址仅用于日志以及未知地址的转发。
+ *  只为注册的actor/worker/连接以及 Mailbox::Resolve() 解析的地址分配句柄，
+ *  分发消息时未知地址只查找不分配。
+ *  地址句柄一旦分配不会回收，同一地址始终对应同一句柄。
+ */
+class AddrManager final {
+ public:
+  enum class Type : int {
+    kInvalid,     ///< 无效地址
+    kMain,        ///< 框架地址
+    kActor,       ///< actor.xx.xx
+    kWorker,      ///< worker.xx.xx
+    kEventConn,   ///< event.conn.xx
+    kOther,       ///< 其它地址(转发给node)
+  };
+
+  AddrManager();
+  virtual ~AddrManager();
+
+  /* 获得地址对应的句柄，地址不存在则分配新的句柄 */
+  addr_id_t Intern(const std::string& addr);
+
+  /* 查找地址对应的句柄，不存在返回 INVALID_ADDR_ID */
+  addr_id_t Find(const std::string& addr);
+
+  /* 句柄对应的字符串地址 */
+  const std::string& GetAddr(addr_id_t id);
+
+  /* 句柄对应的地址类型 */
+  Type GetType(addr_id_t id);
+
+  std::size_t Size();
+
+ private:
+  struct AddrInfo {
+    AddrInfo(const std::string& a, Type t)
+      : addr(a)
+      , type(t) {}
+    std::string addr;
+    Type type{Type::kInvalid};
+  };
+  static Type ParseType(const std::string& addr);
+
+  std::shared_mutex rw_;
+  std::unordered_map<std::string, addr_id_t> addr_id_map_;
+  /// index: addr id, std::deque保证扩容后元素引用不失效
+  std::deque<AddrInfo> addrs_;
+
+  DISALLOW_COPY_AND_ASSIGN(AddrManager)
+};
+
+}  // namespace myframe
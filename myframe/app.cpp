@@ -7,16 +7,26 @@ Author: 李柯鹏 <likepeng0418@163.com>
 
 #include "myframe/app.h"
 
+#include <algorithm>
+#include <chrono>
 #include <regex>
+#include <thread>
+#include <utility>
 
 #include "myframe/log.h"
 #include "myframe/platform.h"
 #include "myframe/common.h"
 #include "myframe/msg.h"
+#include "myframe/msg_pool.h"
+#include "myframe/msg_queue.h"
 #include "myframe/mailbox.h"
+#include "myframe/mailbox_limit.h"
+#include "myframe/metrics.h"
+#include "myframe/addr_manager.h"
 #include "myframe/actor.h"
 #include "myframe/actor_context.h"
-#include "myframe/actor_context_manager.h"
+#include "myframe/dispatch_shard.h"
+#include "myframe/scheduler.h"
 #include "myframe/event_manager.h"
 #include "myframe/event_conn.h"
 #include "myframe/event_conn_manager.h"
@@ -26,32 +36,36 @@ Author: 李柯鹏 <likepeng0418@163.com>
 #include "myframe/worker_context_manager.h"
 #include "myframe/mod_manager.h"
 #include "myframe/poller.h"
+#include "myframe/pending_msg_cache.h"
+#include "myframe/trace.h"
 
 namespace myframe {
 
-std::shared_ptr<WorkerTimer> App::GetTimerWorker() {
-  if (!worker_ctx_mgr_) {
-    LOG(ERROR) << "worker context manager is nullptr";
-    return nullptr;
-  }
-  std::string worker_timer_name = "worker.timer.#1";
-  auto w = ev_mgr_->Get<WorkerContext>(worker_timer_name);
-  if (w == nullptr) {
-    LOG(ERROR)
-      << "can't find " << worker_timer_name;
+/* 外部线程发送消息的默认源地址 */
+static const char* const kExternalSendAddr = "event.send";
+
+std::shared_ptr<WorkerTimer> App::GetTimerWorker(addr_id_t id) {
+  if (timer_workers_.empty()) {
+    LOG(ERROR) << "timer worker not start";
     return nullptr;
   }
-  auto timer_worker = w->GetWorker<WorkerTimer>();
-  return timer_worker;
+  return timer_workers_[id % timer_workers_.size()];
 }
 
 App::App()
-  : mods_(new ModManager())
+  : cache_msgs_(new PendingMsgCache())
+  , mods_(new ModManager())
+  , addr_mgr_(new AddrManager())
   , poller_(Poller::Create())
-  , actor_ctx_mgr_(new ActorContextManager())
   , ev_mgr_(new EventManager())
-  , ev_conn_mgr_(new EventConnManager(ev_mgr_, poller_))
+  , ev_conn_mgr_(new EventConnManager(ev_mgr_, poller_, addr_mgr_))
   , worker_ctx_mgr_(new WorkerContextManager(ev_mgr_))
+  , send_msgs_(new MpscMsgQueue())
+  , start_tp_(std::chrono::steady_clock::now())
+  , send_cnt_(new ShardedCounter())
+  , dispatch_cnt_(new ShardedCounter())
+  , direct_dispatch_cnt_(new ShardedCounter())
+  , last_metrics_tp_(start_tp_)
 {}
 
 App::~App() {
@@ -63,18 +77,47 @@ bool App::Init(
   int thread_pool_size,
   int event_conn_size,
   int warning_msg_size) {
+  AppOptions opts;
+  opts.thread_pool_size = thread_pool_size;
+  opts.event_conn_size = event_conn_size;
+  opts.warning_msg_size = warning_msg_size;
+  return Init(lib_dir, opts);
+}
+
+bool App::Init(const std::string& lib_dir, const AppOptions& opts) {
   if (!quit_.load()) {
     return true;
   }
 
   bool ret = true;
+  auto dispatcher_shard_size = opts.dispatcher_shard_size;
   lib_dir_ = lib_dir;
-  warning_msg_size_.store(warning_msg_size);
+  warning_msg_size_.store(opts.warning_msg_size);
+  cache_msgs_->SetTtl(std::chrono::milliseconds(opts.cache_msg_ttl_ms));
+  cache_msgs_->SetMaxSize(opts.cache_msg_max_size);
   ret &= poller_->Init();
-  ret &= worker_ctx_mgr_->Init(warning_msg_size);
-  ret &= ev_conn_mgr_->Init(event_conn_size);
-  ret &= StartCommonWorker(thread_pool_size);
-  ret &= StartTimerWorker();
+  // 低延迟模式: 主线程和工作线程阻塞等待之前先自旋
+  poller_->GetSpinWait()->SetMaxSpinTime(opts.spin_time_us);
+  ret &= worker_ctx_mgr_->Init(opts.warning_msg_size);
+  ret &= ev_conn_mgr_->Init(opts.event_conn_size);
+  if (opts.direct_dispatch) {
+    // 直接分发模式由工作线程自行调度actor，不使用分片
+    LOG_IF(WARNING, dispatcher_shard_size > 1)
+      << "direct dispatch enabled, ignore dispatcher shard size "
+      << dispatcher_shard_size;
+    dispatcher_shard_size = 1;
+    scheduler_ = std::make_shared<Scheduler>(opts.thread_pool_size);
+    LOG(INFO) << "enable direct dispatch";
+  }
+  // 每个分片至少分配一个工作线程
+  ret &= CreateShards(
+    std::max(1, std::min(dispatcher_shard_size, opts.thread_pool_size)));
+  ret &= StartCommonWorker(
+    opts.thread_pool_size, opts.worker_cpu_affinity, opts.spin_time_us);
+  ret &= StartTimerWorker(opts.timer_worker_size, opts.timer_resolution_us);
+  for (auto& shard : shards_) {
+    shard->Start();
+  }
 
   quit_.store(false);
   return ret;
@@ -274,16 +317,46 @@ bool App::AddWorker(
   const std::string& inst_name,
   std::shared_ptr<Worker> worker,
   const Json::Value& config) {
+  return AddWorker(inst_name, worker, nullptr, config);
+}
+
+bool App::AddWorker(
+  const std::string& inst_name,
+  std::shared_ptr<Worker> worker,
+  std::shared_ptr<DispatchShard> shard,
+  const Json::Value& config) {
+  auto poller = shard == nullptr ? poller_ : shard->GetPoller();
   auto worker_ctx = std::make_shared<WorkerContext>(
-    shared_from_this(), worker, poller_);
+    shared_from_this(), worker, poller);
   worker->SetContext(worker_ctx);
   worker->SetInstName(inst_name);
   worker->SetConfig(config);
+  worker_ctx->GetMailbox()->SetAddrManager(addr_mgr_);
+  worker_ctx->GetMailbox()->SetAddr(worker->GetWorkerName());
+  // 自旋等待时间, instance_config: {"spin_time_us": 20}
+  if (config.isObject() && config.isMember("spin_time_us")
+      && config["spin_time_us"].isInt()) {
+    worker_ctx->GetCmdChannel()->GetSpinWait()->SetMaxSpinTime(
+      config["spin_time_us"].asInt());
+  }
+  // 线程绑定的cpu, instance_config: {"cpu_affinity": [0, 1]/"0-3"}
+  if (config.isObject() && config.isMember("cpu_affinity")) {
+    std::vector<int> cpus;
+    if (Common::ParseIndexList(config["cpu_affinity"], &cpus)) {
+      worker_ctx->SetCpuAffinity(cpus);
+    } else {
+      LOG(WARNING) << worker->GetWorkerName() << " invalid cpu_affinity "
+        << config["cpu_affinity"].toStyledString();
+    }
+  }
+  // 接收缓存容量, instance_config: {"mailbox_capacity": 1000}
+  worker_ctx->GetMailboxLimit()->Init(worker->GetWorkerName(), config);
   if (worker->GetTypeName() == "node") {
     std::lock_guard<std::recursive_mutex> lock(local_mtx_);
     if (node_addr_.empty()) {
       LOG(INFO) << "create node " << worker->GetWorkerName();
       node_addr_ = worker->GetWorkerName();
+      node_addr_id_ = worker_ctx->GetMailbox()->AddrId();
     } else {
       LOG(ERROR) << "has more than one node instance, "
         << node_addr_ << " and " << worker->GetWorkerName();
@@ -293,24 +366,73 @@ bool App::AddWorker(
   if (!worker_ctx_mgr_->Add(worker_ctx)) {
     return false;
   }
-  if (!poller_->Add(worker_ctx)) {
+  if (shard != nullptr) {
+    if (!shard->AddWorker(worker_ctx)) {
+      return false;
+    }
+  } else if (!poller_->Add(worker_ctx)) {
     return false;
   }
   worker_ctx->Start();
   return true;
 }
 
+// 不占用EventConn，也不等待主线程确认
 int App::Send(std::shared_ptr<Msg> msg) {
-  auto conn = ev_conn_mgr_->Alloc();
-  if (conn == nullptr) {
-    LOG(ERROR) << "alloc conn event failed";
+  if (msg == nullptr || msg->GetDst().empty()) {
     return -1;
   }
-  poller_->Add(conn);
-  auto ret = conn->Send(msg);
-  poller_->Del(conn);
-  ev_conn_mgr_->Release(conn);
-  return ret;
+  if (msg->GetSrc().empty()) {
+    msg->SetSrc(kExternalSendAddr);
+  }
+  send_msgs_->Push(std::move(msg));
+  send_cnt_->Add();
+  Tracer::Instant(Tracer::Event::kSend, INVALID_ADDR_ID, 1);
+  // 多次发送只唤醒一次
+  if (!send_notified_.exchange(true)) {
+    poller_->Wakeup();
+  }
+  return 0;
+}
+
+int App::SendBatch(std::vector<std::shared_ptr<Msg>> msgs) {
+  for (auto& msg : msgs) {
+    if (msg == nullptr || msg->GetDst().empty()) {
+      return -1;
+    }
+    if (msg->GetSrc().empty()) {
+      msg->SetSrc(kExternalSendAddr);
+    }
+  }
+  if (msgs.empty()) {
+    return 0;
+  }
+  send_cnt_->Add(msgs.size());
+  Tracer::Instant(Tracer::Event::kSend, INVALID_ADDR_ID, msgs.size());
+  send_msgs_->PushBatch(&msgs);
+  if (!send_notified_.exchange(true)) {
+    poller_->Wakeup();
+  }
+  return 0;
+}
+
+// 一次取完队列中的消息，分发期间不释放锁
+void App::ProcessSendMsg() {
+  // 读到标记的同时看到设置标记之前入队的消息
+  send_notified_.exchange(false, std::memory_order_acq_rel);
+  std::lock_guard<std::recursive_mutex> lock(local_mtx_);
+  std::shared_ptr<Msg> msg;
+  while (true) {
+    while ((msg = send_msgs_->Pop()) != nullptr) {
+      DispatchMsg(msg);
+    }
+    // 有消息正在入队(还没有链接好)时等待链接完成后取出，
+    // 不留到下一次唤醒
+    if (send_msgs_->Empty()) {
+      break;
+    }
+    std::this_thread::yield();
+  }
 }
 
 const std::shared_ptr<const Msg> App::SendRequest(
@@ -320,13 +442,28 @@ const std::shared_ptr<const Msg> App::SendRequest(
     LOG(ERROR) << "alloc conn event failed";
     return nullptr;
   }
-  poller_->Add(conn);
   auto resp = conn->SendRequest(msg);
-  poller_->Del(conn);
   ev_conn_mgr_->Release(conn);
   return resp;
 }
 
+std::vector<std::shared_ptr<const Msg>> App::SendRequestBatch(
+  std::vector<std::shared_ptr<Msg>> reqs) {
+  for (auto& req : reqs) {
+    if (req == nullptr) {
+      return std::vector<std::shared_ptr<const Msg>>(reqs.size(), nullptr);
+    }
+  }
+  auto conn = ev_conn_mgr_->Alloc();
+  if (conn == nullptr) {
+    LOG(ERROR) << "alloc conn event failed";
+    return std::vector<std::shared_ptr<const Msg>>(reqs.size(), nullptr);
+  }
+  auto resps = conn->SendRequestBatch(reqs);
+  ev_conn_mgr_->Release(conn);
+  return resps;
+}
+
 /**
  * 创建一个新的actor:
  *      1. 从ModManager中获得对应模块对象
@@ -361,6 +498,7 @@ bool App::CreateActorContext(
     if (node_addr_.empty()) {
       LOG(INFO) << "create node " << actor_name;
       node_addr_ = actor_name;
+      node_addr_id_ = addr_mgr_->Intern(actor_name);
     } else {
       LOG(ERROR) << "has more than one node instance, "
         << node_addr_ << " and " << actor_name;
@@ -368,47 +506,162 @@ bool App::CreateActorContext(
     }
   }
   auto ctx = std::make_shared<ActorContext>(shared_from_this(), mod_inst);
+  ctx->GetMailbox()->SetAddrManager(addr_mgr_);
+  // 收件箱容量, instance_config: {"mailbox_capacity": 1000}
+  auto limit = ctx->GetMailboxLimit();
+  limit->Init(actor_name, *mod_inst->GetConfig());
+  if (scheduler_ != nullptr) {
+    // 收件箱类型, instance_config: {"mailbox_type": "mpsc"/"locked"}
+    auto inbox_type = MsgQueue::Type::kMpsc;
+    auto cfg = mod_inst->GetConfig();
+    if (cfg->isMember("mailbox_type") && (*cfg)["mailbox_type"].isString()
+        && !MsgQueue::ParseType((*cfg)["mailbox_type"].asString(),
+          &inbox_type)) {
+      LOG(WARNING) << actor_name << " unknown mailbox type "
+        << (*cfg)["mailbox_type"].asString() << ", use mpsc";
+    }
+    // 发送线程丢弃最早的消息需要加锁的收件箱
+    if (limit->IsBounded()
+        && limit->GetPolicy() == MailboxLimit::Policy::kDropOldest
+        && inbox_type != MsgQueue::Type::kLocked) {
+      LOG(INFO) << actor_name << " mailbox policy drop_oldest, use locked";
+      inbox_type = MsgQueue::Type::kLocked;
+    }
+    ctx->SetScheduler(scheduler_, inbox_type);
+  }
+  if (!SetWorkerAffinity(ctx)) {
+    return false;
+  }
   if (ctx->Init(params.c_str())) {
     LOG(ERROR) << "init " << actor_name << " fail";
     return false;
   }
-  actor_ctx_mgr_->RegContext(ctx);
+  // 注册后actor可能立即在其它线程中运行，先取出初始化时发送的消息
+  std::list<std::shared_ptr<Msg>> init_msgs;
+  init_msgs.splice(init_msgs.end(), *ctx->GetMailbox()->GetSendList());
+  auto shard = GetShard(ctx->GetMailbox()->AddrId());
+  if (shard == nullptr || !shard->RegContext(ctx)) {
+    LOG(ERROR) << "reg " << actor_name << " fail";
+    return false;
+  }
   std::lock_guard<std::recursive_mutex> lock(local_mtx_);
   // 接收缓存中发给自己的消息
-  for (auto it = cache_msgs_.begin(); it != cache_msgs_.end();) {
-    if (it->msg->GetDst() == actor_name) {
-      LOG(INFO) << actor_name
-        << " recv msg from cache " << *(it->msg);
-      DispatchMsg(it->msg);
-      it = cache_msgs_.erase(it);
-      continue;
-    }
-    ++it;
+  std::list<std::shared_ptr<Msg>> cached_msgs;
+  if (cache_msgs_->Pop(ctx->GetMailbox()->AddrId(), &cached_msgs)) {
+    LOG(INFO) << actor_name
+      << " recv " << cached_msgs.size() << " msg from cache";
+    DispatchMsg(&cached_msgs);
   }
   // 目的地址不存在的暂时放到缓存消息队列
-  auto send_list = ctx->GetMailbox()->GetSendList();
-  for (auto it = send_list->begin(); it != send_list->end();) {
+  std::list<std::shared_ptr<Msg>> evicted_msgs;
+  for (auto it = init_msgs.begin(); it != init_msgs.end();) {
     if (!HasUserInst((*it)->GetDst())) {
       LOG(WARNING) << "can't found " << (*it)->GetDst()
         << ", cache this msg";
-      cache_msgs_.emplace_back(0, *it);
-      it = send_list->erase(it);
+      auto dst_id = (*it)->GetDstId();
+      if (dst_id == INVALID_ADDR_ID) {
+        dst_id = addr_mgr_->Intern((*it)->GetDst());
+        (*it)->SetDstId(dst_id);
+      }
+      cache_msgs_->Push(dst_id, *it, &evicted_msgs);
+      it = init_msgs.erase(it);
       continue;
     }
     ++it;
   }
+  // 超出缓存容量的消息不再等待
+  LOG_IF(WARNING, !evicted_msgs.empty())
+    << "cache msg full, dispatch " << evicted_msgs.size() << " msg";
+  DispatchMsg(&evicted_msgs);
   // 分发目的地址已经存在的消息
-  DispatchMsg(ctx);
+  DispatchMsg(&init_msgs);
+  return true;
+}
+
+bool App::CreateShards(int shard_size) {
+  if (!shards_.empty()) {
+    return true;
+  }
+  for (int i = 0; i < shard_size; ++i) {
+    // 分片0使用主线程的poller
+    auto poller = poller_;
+    if (i > 0) {
+      poller = Poller::Create();
+      if (!poller->Init()) {
+        LOG(ERROR) << "init shard " << i << " poller failed";
+        return false;
+      }
+      poller->GetSpinWait()->SetMaxSpinTime(
+        poller_->GetSpinWait()->GetMaxSpinTime());
+    }
+    shards_.push_back(std::make_shared<DispatchShard>(
+      shared_from_this(), i, poller, ev_mgr_, warning_msg_size_.load()));
+  }
+  LOG(INFO) << "create " << shards_.size() << " dispatch shard";
   return true;
 }
 
-bool App::StartCommonWorker(int worker_count) {
+std::shared_ptr<DispatchShard> App::GetShard(addr_id_t id) {
+  if (shards_.empty()) {
+    return nullptr;
+  }
+  return shards_[id % shards_.size()];
+}
+
+// 绑定的工作线程, instance_config: {"worker_affinity": 0/[0, 1]}
+// 分片模式下只能绑定actor所在分片的工作线程
+bool App::SetWorkerAffinity(std::shared_ptr<ActorContext> ctx) {
+  auto actor = ctx->GetActor();
+  auto cfg = actor->GetConfig();
+  if (!cfg->isObject() || !cfg->isMember("worker_affinity")) {
+    return true;
+  }
+  std::vector<int> workers;
+  if (!Common::ParseIndexList((*cfg)["worker_affinity"], &workers)) {
+    LOG(ERROR) << actor->GetActorName() << " invalid worker_affinity "
+      << (*cfg)["worker_affinity"].toStyledString();
+    return false;
+  }
+  auto shard_idx = ctx->GetMailbox()->AddrId() % shards_.size();
+  std::vector<std::size_t> affinity;
+  for (auto w : workers) {
+    auto idx = static_cast<std::size_t>(w);
+    if (idx >= common_worker_size_ || idx % shards_.size() != shard_idx) {
+      LOG(WARNING) << actor->GetActorName()
+        << " can't bind to worker " << idx << ", skip";
+      continue;
+    }
+    affinity.push_back(idx);
+  }
+  if (affinity.empty()) {
+    LOG(ERROR) << actor->GetActorName() << " has no valid worker to bind";
+    return false;
+  }
+  ctx->SetWorkerAffinity(affinity);
+  return true;
+}
+
+// worker_cpu_affinity: 第i个工作线程使用第(i % size)个cpu集合
+bool App::StartCommonWorker(
+  int worker_count,
+  const Json::Value& worker_cpu_affinity,
+  int spin_time_us) {
   bool ret = false;
+  common_worker_size_ = worker_count;
   for (int i = 0; i < worker_count; ++i) {
     auto worker = std::make_shared<WorkerCommon>();
     worker->SetModName("class");
     worker->SetTypeName("WorkerCommon");
-    if (!AddWorker(std::to_string(i), worker)) {
+    worker->SetScheduler(scheduler_);
+    worker->SetIndex(i);
+    auto shard = shards_[i % shards_.size()];
+    Json::Value cfg;
+    cfg["spin_time_us"] = spin_time_us;
+    if (worker_cpu_affinity.isArray() && worker_cpu_affinity.size() > 0) {
+      cfg["cpu_affinity"] =
+        worker_cpu_affinity[i % worker_cpu_affinity.size()];
+    }
+    if (!AddWorker(std::to_string(i), worker, shard, cfg)) {
       LOG(ERROR) << "start common worker " << i << " failed";
       continue;
     }
@@ -418,15 +671,20 @@ bool App::StartCommonWorker(int worker_count) {
   return ret;
 }
 
-bool App::StartTimerWorker() {
-  auto worker = std::make_shared<WorkerTimer>();
-  worker->SetModName("class");
-  worker->SetTypeName("timer");
-  if (!AddWorker("#1", worker)) {
-    LOG(ERROR) << "start timer worker failed";
-    return false;
+bool App::StartTimerWorker(int timer_worker_size, int timer_resolution_us) {
+  timer_workers_.clear();
+  for (int i = 0; i < std::max(1, timer_worker_size); ++i) {
+    auto worker = std::make_shared<WorkerTimer>();
+    worker->SetModName("class");
+    worker->SetTypeName("timer");
+    worker->timer_mgr_.SetResolution(timer_resolution_us);
+    if (!AddWorker("#" + std::to_string(i + 1), worker)) {
+      LOG(ERROR) << "start timer worker " << i + 1 << " failed";
+      return false;
+    }
+    timer_workers_.emplace_back(worker);
+    LOG(INFO) << "start timer worker " << worker->GetWorkerName();
   }
-  LOG(INFO) << "start timer worker " << worker->GetWorkerName();
   return true;
 }
 
@@ -443,43 +701,197 @@ void App::DispatchMsg(std::list<std::shared_ptr<Msg>>* msg_list) {
 void App::DispatchMsg(std::shared_ptr<Msg> msg) {
   std::lock_guard<std::recursive_mutex> lock(local_mtx_);
   VLOG(1) << *msg;
-  /// 处理框架消息
-  if (msg->GetDst() == MAIN_ADDR) {
-    ProcessMain(msg);
-    return;
+  dispatch_cnt_->Add();
+  /// 未解析的地址(比如外部发送或者直接设置的地址)在此查找一次,
+  /// 只有注册过的actor/worker/连接有句柄，未知地址不分配句柄
+  auto dst_id = msg->GetDstId();
+  if (dst_id == INVALID_ADDR_ID) {
+    dst_id = addr_mgr_->Find(msg->GetDst());
+    msg->SetDstId(dst_id);
   }
+  Tracer::Instant(Tracer::Event::kDispatch, dst_id);
   /// 消息分发
-  auto name_list = Common::SplitMsgName(msg->GetDst());
-  if (name_list.size() < 2) {
-    LOG(ERROR) << "Unknown msg " << *msg;
-    return;
-  }
-  if (name_list[0] == "worker"
-      && ev_mgr_->Has(msg->GetDst())) {
-    // dispatch to user worker
-    worker_ctx_mgr_->DispatchWorkerMsg(msg);
-  } else if (name_list[0] == "actor"
-      && actor_ctx_mgr_->HasActor(msg->GetDst())) {
-    // dispatch to actor
-    actor_ctx_mgr_->DispatchMsg(msg);
-  } else if (name_list[0] == "event") {
-    if (name_list[1] == "conn") {
-      auto handle = ev_mgr_->ToHandle(msg->GetDst());
-      ev_conn_mgr_->Notify(handle, msg);
-    } else {
+  switch (addr_mgr_->GetType(dst_id)) {
+    case AddrManager::Type::kMain:
+      // 处理框架消息
+      ProcessMain(msg);
+      return;
+    case AddrManager::Type::kWorker:
+      // dispatch to user worker
+      if (worker_ctx_mgr_->DispatchWorkerMsg(msg, dst_id)) {
+        return;
+      }
+      break;
+    case AddrManager::Type::kActor:
+      // dispatch to actor
+      if (DispatchToActor(msg, dst_id)) {
+        return;
+      }
+      break;
+    case AddrManager::Type::kEventConn:
+      ev_conn_mgr_->Notify(ev_mgr_->ToHandle(msg->GetDst()), msg);
+      return;
+    case AddrManager::Type::kOther:
+      break;
+    default:
+      // 发给 App::Send() 默认源地址的消息(比如回复)直接丢弃
+      if (msg->GetDst() == kExternalSendAddr) {
+        VLOG(1) << "drop msg to " << kExternalSendAddr;
+        return;
+      }
+      // 未知地址交给node处理
+      if (dst_id == INVALID_ADDR_ID) {
+        break;
+      }
       LOG(ERROR) << "Unknown msg " << *msg;
+      return;
+  }
+  DispatchToNode(msg);
+}
+
+// actor所在分片不是分片0时投递到对应分片
+bool App::DispatchToActor(std::shared_ptr<Msg> msg, addr_id_t dst) {
+  auto shard = GetShard(dst);
+  if (shard == nullptr) {
+    return false;
+  }
+  if (scheduler_ != nullptr) {
+    auto ctx = shard->GetContext(dst);
+    if (ctx == nullptr) {
+      return false;
     }
-  } else if (!node_addr_.empty()) {
-    if (node_addr_.substr(0, 5) == "actor") {
-      actor_ctx_mgr_->DispatchMsg(msg, node_addr_);
-    } else if (node_addr_.substr(0, 6) == "worker") {
-      worker_ctx_mgr_->DispatchWorkerMsg(msg, node_addr_);
-    } else {
-      LOG(ERROR) << "Unknown msg " << *msg;
+    DeliverToActor(ctx, msg, dst);
+    return true;
+  }
+  if (!shard->HasActor(dst)) {
+    return false;
+  }
+  if (shard->GetIndex() == 0) {
+    return shard->DispatchActorMsg(msg, dst);
+  }
+  shard->Post(msg, dst);
+  return true;
+}
+
+// 目的地址是actor的消息直接投递，其余的交给主线程处理
+void App::DirectDispatchMsg(std::shared_ptr<ActorContext> context) {
+  auto msg_list = context->GetMailbox()->GetSendList();
+  LOG_IF(WARNING,
+      msg_list->size() > warning_msg_size_.load())
+    << " dispatch msg too many";
+  for (auto& msg : (*msg_list)) {
+    auto dst_id = msg->GetDstId();
+    if (dst_id != INVALID_ADDR_ID
+        && addr_mgr_->GetType(dst_id) == AddrManager::Type::kActor) {
+      auto ctx = shards_[0]->GetContext(dst_id);
+      if (ctx != nullptr) {
+        DeliverToActor(ctx, msg, dst_id);
+        direct_dispatch_cnt_->Add();
+        continue;
+      }
     }
-  } else {
+    shards_[0]->Post(msg);
+  }
+  msg_list->clear();
+}
+
+void App::DeliverToActor(
+    std::shared_ptr<ActorContext> ctx,
+    std::shared_ptr<Msg> msg,
+    addr_id_t dst) {
+  auto limit = ctx->GetMailboxLimit();
+  if (limit->IsBounded()) {
+    bool drop_oldest = false;
+    if (!CheckMailboxLimit(limit, ctx->InboxSize(), msg, dst, &drop_oldest)) {
+      return;
+    }
+    if (drop_oldest) {
+      ctx->DropInbox();
+    }
+  }
+  ctx->Deliver(std::move(msg));
+}
+
+// 拒绝消息回复给actor、worker或者外部请求的发送者;
+// 外部请求(App::SendRequest())同步等待回复，丢弃时也回复拒绝消息;
+// 限流只暂停actor发送者，并且不暂停自己收件箱也在限流的actor，
+// 避免actor之间相互等待
+bool App::CheckMailboxLimit(
+    MailboxLimit* limit,
+    std::size_t size,
+    const std::shared_ptr<Msg>& msg,
+    addr_id_t dst,
+    bool* drop_oldest) {
+  auto src_id = msg->GetSrcId();
+  auto result = limit->Check(size);
+  if (result == MailboxLimit::Result::kAccept) {
+    return true;
+  }
+  if (src_id == INVALID_ADDR_ID && !msg->GetSrc().empty()
+      && (result == MailboxLimit::Result::kReject
+        || result == MailboxLimit::Result::kDropNewest)) {
+    src_id = addr_mgr_->Find(msg->GetSrc());
+  }
+  auto src_type = src_id == INVALID_ADDR_ID
+    ? AddrManager::Type::kInvalid : addr_mgr_->GetType(src_id);
+  switch (result) {
+    case MailboxLimit::Result::kDropOldest:
+      VLOG(1) << addr_mgr_->GetAddr(dst) << " mailbox full, drop oldest msg";
+      *drop_oldest = true;
+      return true;
+    case MailboxLimit::Result::kReject:
+      VLOG(1) << addr_mgr_->GetAddr(dst) << " mailbox full, reject " << *msg;
+      if (src_type == AddrManager::Type::kActor
+          || src_type == AddrManager::Type::kWorker
+          || src_type == AddrManager::Type::kEventConn) {
+        ReplyReject(msg, dst, src_id);
+      }
+      return false;
+    case MailboxLimit::Result::kThrottle:
+      if (src_id != dst && src_type == AddrManager::Type::kActor) {
+        auto shard = GetShard(src_id);
+        auto src_ctx = shard == nullptr ? nullptr : shard->GetContext(src_id);
+        if (src_ctx != nullptr && !src_ctx->GetMailboxLimit()->HasMuted()
+            && limit->Mute(src_ctx)) {
+          VLOG(1) << addr_mgr_->GetAddr(dst) << " mailbox full, mute "
+            << addr_mgr_->GetAddr(src_id);
+        }
+      }
+      return true;
+    default:
+      VLOG(1) << addr_mgr_->GetAddr(dst) << " mailbox full, drop " << *msg;
+      if (src_type == AddrManager::Type::kEventConn) {
+        ReplyReject(msg, dst, src_id);
+      }
+      return false;
+  }
+}
+
+// 由主线程(分片0)分发，发送者为外部请求时交给EventConnManager
+void App::ReplyReject(
+    const std::shared_ptr<Msg>& msg, addr_id_t dst, addr_id_t src_id) {
+  auto reject = MailboxLimit::MakeReject(*msg, addr_mgr_->GetAddr(dst));
+  reject->SetSrcId(dst);
+  reject->SetDstId(src_id);
+  // 被拒绝的请求作为回复交给请求者的回调
+  reject->SetCorrelationId(msg->GetCorrelationId());
+  reject->SetReply(msg->GetCorrelationId() != 0 && !msg->IsReply());
+  shards_[0]->Post(reject);
+}
+
+void App::DispatchToNode(std::shared_ptr<Msg> msg) {
+  if (node_addr_id_ == INVALID_ADDR_ID) {
     LOG(ERROR) << "Unknown msg " << *msg;
+    return;
   }
+  bool res = false;
+  auto type = addr_mgr_->GetType(node_addr_id_);
+  if (type == AddrManager::Type::kActor) {
+    res = DispatchToActor(msg, node_addr_id_);
+  } else if (type == AddrManager::Type::kWorker) {
+    res = worker_ctx_mgr_->DispatchWorkerMsg(msg, node_addr_id_);
+  }
+  LOG_IF(ERROR, !res) << "Unknown msg " << *msg;
 }
 
 // 将获得的消息分发给其他actor
@@ -496,38 +908,8 @@ void App::DispatchMsg(std::shared_ptr<ActorContext> context) {
 void App::CheckStopWorkers() {
   VLOG(1) << "check stop worker";
   worker_ctx_mgr_->WeakupWorker();
-
-  LOG_IF(INFO, worker_ctx_mgr_->IdleWorkerSize() == 0)
-      << "worker busy, wait for idle worker...";
-  std::shared_ptr<ActorContext> actor_ctx = nullptr;
-  std::shared_ptr<WorkerContext> worker_ctx = nullptr;
-  while ((worker_ctx = worker_ctx_mgr_->FrontIdleWorker()) != nullptr) {
-    if (nullptr == (actor_ctx = actor_ctx_mgr_->GetContextWithMsg())) {
-      VLOG(1) << "no actor need process, waiting...";
-      break;
-    }
-    VLOG(1)
-      << actor_ctx->GetActor()->GetActorName()
-      << " dispatch msg to "
-      << *worker_ctx;
-    auto msg_list = actor_ctx->GetMailbox()->GetRecvList();
-    if (!msg_list->empty()) {
-      LOG_IF(WARNING,
-        msg_list->size() > warning_msg_size_.load())
-          << actor_ctx->GetActor()->GetActorName()
-          << " recv msg size too many: " << msg_list->size();
-      VLOG(1) << "run " << actor_ctx->GetActor()->GetActorName();
-      worker_ctx->GetMailbox()->Recv(msg_list);
-      VLOG(1) << actor_ctx->GetActor()->GetActorName()
-        << " has " << worker_ctx->GetMailbox()->RecvSize()
-        << " msg need process";
-      worker_ctx_mgr_->PopFrontIdleWorker();
-      auto common_idle_worker = worker_ctx->GetWorker<WorkerCommon>();
-      common_idle_worker->SetActorContext(actor_ctx);
-      worker_ctx->GetCmdChannel()->SendToOwner(CmdChannel::Cmd::kRun);
-    } else {
-      LOG(ERROR) << actor_ctx->GetActor()->GetActorName() << " has no msg";
-    }
+  if (scheduler_ == nullptr) {
+    shards_[0]->CheckStopWorkers();
   }
 }
 
@@ -540,28 +922,51 @@ void App::ProcessMain(std::shared_ptr<Msg> msg) {
     LOG(WARNING) << "unknown MAIN_CMD " << cmd;
     return;
   }
-  auto resp_msg = std::make_shared<Msg>();
+  auto src_id = msg->GetSrcId();
+  if (src_id == INVALID_ADDR_ID) {
+    src_id = addr_mgr_->Find(src);
+  }
+  std::string data;
   if (cmd == MAIN_CMD_ALL_USER_MOD_ADDR) {
-    resp_msg->SetSrc(MAIN_ADDR);
-    resp_msg->SetDst(src);
-    std::string mod_addr_list;
-    GetAllUserModAddr(&mod_addr_list);
-    resp_msg->SetData(mod_addr_list);
+    GetAllUserModAddr(&data);
+  } else if (cmd == MAIN_CMD_METRICS) {
+    GetMetrics(&data);
   } else {
     LOG(WARNING) << "unknown MAIN_CMD " << cmd;
     return;
   }
-  if (src.substr(0, 6) == "worker") {
-    worker_ctx_mgr_->DispatchWorkerMsg(resp_msg);
-  } else if (src.substr(0, 5) == "actor") {
-    actor_ctx_mgr_->DispatchMsg(resp_msg);
-  } else {
-    LOG(ERROR) << "unknow msg " << *msg;
+  auto resp_msg = MsgPool::Instance()->Get();
+  resp_msg->SetSrc(MAIN_ADDR);
+  resp_msg->SetPriority(Msg::Priority::kHigh);
+  resp_msg->SetDst(src);
+  resp_msg->SetDstId(src_id);
+  // Actor::Request() 发送的命令作为回复交给请求者的回调
+  resp_msg->SetCorrelationId(msg->GetCorrelationId());
+  resp_msg->SetReply(msg->GetCorrelationId() != 0 && !msg->IsReply());
+  resp_msg->SetData(std::move(data));
+  bool res = false;
+  auto src_type = addr_mgr_->GetType(src_id);
+  if (src_type == AddrManager::Type::kWorker) {
+    res = worker_ctx_mgr_->DispatchWorkerMsg(resp_msg, src_id);
+  } else if (src_type == AddrManager::Type::kActor) {
+    res = DispatchToActor(resp_msg, src_id);
+  } else if (src_type == AddrManager::Type::kEventConn) {
+    // App::SendRequest() 发送的命令
+    ev_conn_mgr_->Notify(ev_mgr_->ToHandle(src), resp_msg);
+    res = true;
+  } else if (src == kExternalSendAddr) {
+    // App::Send() 发送的命令不需要回复
+    res = true;
   }
+  LOG_IF(ERROR, !res) << "unknow msg " << *msg;
 }
 
 void App::GetAllUserModAddr(std::string* info) {
-  auto res_actor = actor_ctx_mgr_->GetAllActorAddr();
+  std::vector<std::string> res_actor;
+  for (auto& shard : shards_) {
+    auto addrs = shard->GetAllActorAddr();
+    res_actor.insert(res_actor.end(), addrs.begin(), addrs.end());
+  }
   auto res_worker = worker_ctx_mgr_->GetAllUserWorkerAddr();
   std::stringstream ss;
   for (std::size_t i = 0; i < res_actor.size(); ++i) {
@@ -574,6 +979,118 @@ void App::GetAllUserModAddr(std::string* info) {
   info->append(ss.str());
 }
 
+// 快照在主线程生成，计数器由各线程并发更新，结果是近似值
+void App::GetMetrics(std::string* info) {
+  using std::chrono::duration_cast;
+  using std::chrono::milliseconds;
+  Json::Value root(Json::objectValue);
+  auto now = std::chrono::steady_clock::now();
+  root["uptime_ms"] = Json::UInt64(
+    duration_cast<milliseconds>(now - start_tp_).count());
+
+  /// 主线程
+  Json::Value main(Json::objectValue);
+  auto dispatch_cnt = dispatch_cnt_->Value();
+  auto elapsed_ms = duration_cast<milliseconds>(now - last_metrics_tp_).count();
+  main["dispatch"] = Json::UInt64(dispatch_cnt);
+  main["dispatch_per_sec"] = Json::UInt64(elapsed_ms > 0
+    ? (dispatch_cnt - last_dispatch_cnt_) * 1000 / elapsed_ms : 0);
+  main["external_send"] = Json::UInt64(send_cnt_->Value());
+  main["direct_dispatch"] = Json::UInt64(direct_dispatch_cnt_->Value());
+  main["addrs"] = Json::UInt64(addr_mgr_->Size());
+  auto spin = poller_->GetSpinWait();
+  if (spin->IsEnabled()) {
+    main["spin"] = Json::UInt64(spin->GetSpinCount());
+    main["spin_hit_rate"] = spin->GetHitRate();
+  }
+  root["main"] = main;
+  last_metrics_tp_ = now;
+  last_dispatch_cnt_ = dispatch_cnt;
+
+  /// 目的地址未注册的缓存消息
+  Json::Value cache(Json::objectValue);
+  cache["size"] = Json::UInt64(cache_msgs_->Size());
+  cache["cached"] = Json::UInt64(cache_msgs_->CachedCount());
+  cache["delivered"] = Json::UInt64(cache_msgs_->DeliveredCount());
+  cache["expired"] = Json::UInt64(cache_msgs_->ExpiredCount());
+  cache["evicted"] = Json::UInt64(cache_msgs_->EvictedCount());
+  root["cache"] = cache;
+
+  /// actor(按处理总耗时降序)
+  /// 统计值在工作线程中持续更新，先取快照再排序，保证比较结果一致
+  std::vector<std::pair<uint64_t, std::shared_ptr<ActorContext>>> ctxs;
+  for (auto& shard : shards_) {
+    for (auto& ctx : shard->GetAllContext()) {
+      ctxs.emplace_back(ctx->GetMetrics()->ProcTime().TotalUs(), ctx);
+    }
+  }
+  std::sort(ctxs.begin(), ctxs.end(),
+    [](const std::pair<uint64_t, std::shared_ptr<ActorContext>>& a,
+        const std::pair<uint64_t, std::shared_ptr<ActorContext>>& b) {
+      return a.first > b.first;
+    });
+  Json::Value actors(Json::arrayValue);
+  for (auto& item : ctxs) {
+    auto& ctx = item.second;
+    auto metrics = ctx->GetMetrics();
+    Json::Value actor(Json::objectValue);
+    actor["name"] = ctx->GetActor()->GetActorName();
+    actor["msg_in"] = Json::UInt64(metrics->MsgIn());
+    actor["msg_out"] = Json::UInt64(metrics->MsgOut());
+    actor["mailbox_depth"] = Json::UInt64(
+      scheduler_ != nullptr ? ctx->InboxSize() : metrics->Depth());
+    actor["mailbox_max_depth"] = Json::UInt64(metrics->MaxDepth());
+    actor["pending_request"] = Json::UInt64(ctx->PendingRequestSize());
+    Json::Value proc(Json::objectValue);
+    metrics->ProcTime().ToJson(&proc);
+    actor["proc"] = proc;
+    auto limit = ctx->GetMailboxLimit();
+    if (limit->IsBounded()) {
+      Json::Value mailbox_limit(Json::objectValue);
+      mailbox_limit["capacity"] = Json::UInt64(limit->GetCapacity());
+      mailbox_limit["drop_newest"] = Json::UInt64(limit->DropNewestCount());
+      mailbox_limit["drop_oldest"] = Json::UInt64(limit->DropOldestCount());
+      mailbox_limit["reject"] = Json::UInt64(limit->RejectCount());
+      mailbox_limit["throttle"] = Json::UInt64(limit->ThrottleCount());
+      actor["mailbox_limit"] = mailbox_limit;
+    }
+    actors.append(actor);
+  }
+  root["actors"] = actors;
+
+  /// 内置工作线程
+  Json::Value workers(Json::arrayValue);
+  auto evs = ev_mgr_->Get({Event::Type::kWorkerCommon});
+  for (auto& ev : evs) {
+    auto worker_ctx = std::dynamic_pointer_cast<WorkerContext>(ev);
+    if (worker_ctx == nullptr) {
+      continue;
+    }
+    auto worker = worker_ctx->GetWorker<WorkerCommon>();
+    if (worker == nullptr) {
+      continue;
+    }
+    Json::Value w(Json::objectValue);
+    w["name"] = worker->GetWorkerName();
+    worker->GetMetrics()->ToJson(&w);
+    workers.append(w);
+  }
+  root["workers"] = workers;
+
+  /// 定时器
+  Json::Value timers(Json::arrayValue);
+  for (auto& timer_worker : timer_workers_) {
+    Json::Value t(Json::objectValue);
+    t["name"] = timer_worker->GetWorkerName();
+    t["active"] = Json::UInt64(timer_worker->GetTimerSize());
+    t["capacity"] = Json::UInt64(timer_worker->GetTimerCapacity());
+    timers.append(t);
+  }
+  root["timers"] = timers;
+
+  *info = root.toStyledString();
+}
+
 void App::ProcessTimerEvent(std::shared_ptr<WorkerContext> worker_ctx) {
   // 将定时器线程的发送队列分发完毕
   VLOG(1) << *worker_ctx << " dispatch msg...";
@@ -627,49 +1144,16 @@ void App::ProcessUserEvent(std::shared_ptr<WorkerContext> worker_ctx) {
   }
 }
 
-/// FIXME: Idle/DispatchMsg 会影响actor的执行顺序
-void App::ProcessWorkerEvent(std::shared_ptr<WorkerContext> worker_ctx) {
-  // 将actor的发送队列分发完毕
-  auto worker = worker_ctx->GetWorker<WorkerCommon>();
-  VLOG_IF(1, worker->GetActorContext() != nullptr)
-      << *worker_ctx << " dispatch "
-      << worker->GetActorContext()->GetActor()->GetActorName() << " msg...";
-  DispatchMsg(worker->GetActorContext());
-
-  CmdChannel::Cmd cmd;
-  auto cmd_channel = worker->GetCmdChannel();
-  cmd_channel->RecvFromOwner(&cmd);
-  switch (cmd) {
-    case CmdChannel::Cmd::kIdle:  // idle
-      // 将工作线程中的actor状态设置为全局状态
-      // 将线程加入空闲队列
-      VLOG(1)
-        << *worker_ctx
-        << " idle, push to idle queue";
-      worker->Idle();
-      worker_ctx_mgr_->PushBackIdleWorker(worker_ctx);
-      break;
-    case CmdChannel::Cmd::kQuit:  // quit
-      LOG(INFO)
-        << *worker_ctx
-        << " quit, delete from main";
-      poller_->Del(worker_ctx);
-      worker_ctx_mgr_->Del(worker_ctx);
-      // FIXME: 应该将worker加入删除队列，等worker运行结束后再从队列删除
-      // 否则会造成删除智能指针后，worker还没结束运行造成coredump
-      break;
-    default:
-      LOG(WARNING) << "unknown common worker cmd: " << static_cast<char>(cmd);
-      break;
-  }
-}
-
+// 先取走命令和发送队列再分发：发给框架的命令在分发中直接回复，
+// 调用者收到回复后会立即复用该连接发送下一个请求
 void App::ProcessEventConn(std::shared_ptr<EventConn> ev) {
-  // 将event_conn的发送队列分发完毕
-  DispatchMsg(ev->GetMailbox()->GetSendList());
   auto cmd_channel = ev->GetCmdChannel();
   CmdChannel::Cmd cmd;
   cmd_channel->RecvFromOwner(&cmd);
+  std::list<std::shared_ptr<Msg>> msg_list;
+  msg_list.swap(*ev->GetMailbox()->GetSendList());
+  // 将event_conn的发送队列分发完毕
+  DispatchMsg(&msg_list);
   switch (cmd) {
     case CmdChannel::Cmd::kRun:
       cmd_channel->SendToOwner(CmdChannel::Cmd::kIdle);
@@ -698,7 +1182,8 @@ void App::ProcessEvent(const std::vector<ev_handle_t>& evs) {
     }
     switch (ev_obj->GetType()) {
       case Event::Type::kWorkerCommon:
-        ProcessWorkerEvent(std::dynamic_pointer_cast<WorkerContext>(ev_obj));
+        shards_[0]->ProcessWorkerEvent(
+          std::dynamic_pointer_cast<WorkerContext>(ev_obj));
         break;
       case Event::Type::kWorkerTimer:
         ProcessTimerEvent(std::dynamic_pointer_cast<WorkerContext>(ev_obj));
@@ -716,29 +1201,38 @@ void App::ProcessEvent(const std::vector<ev_handle_t>& evs) {
   }
 }
 
+// 缓存超时的消息按目的地址不存在处理(转发给node)
 void App::ProcessCacheMsg() {
-  for (auto it = cache_msgs_.begin(); it != cache_msgs_.end();) {
-    if (it->search_count >= default_search_count_) {
-      VLOG(1) << *(it->msg) << " search count: " << it->search_count
-        << ", dispatch it";
-      DispatchMsg(it->msg);
-      it = cache_msgs_.erase(it);
-    } else {
-      it->search_count++;
-      ++it;
-    }
+  std::lock_guard<std::recursive_mutex> lock(local_mtx_);
+  if (cache_msgs_->Empty()) {
+    return;
+  }
+  std::list<std::shared_ptr<Msg>> expired_msgs;
+  if (cache_msgs_->Expire(&expired_msgs)) {
+    VLOG(1) << expired_msgs.size() << " cache msg timeout, dispatch it";
+    DispatchMsg(&expired_msgs);
   }
 }
 
 int App::Exec() {
   int time_wait_ms = 100;
   std::vector<ev_handle_t> evs;
+  {
+    // 启动时缓存的消息从这里开始计时
+    std::lock_guard<std::recursive_mutex> lock(local_mtx_);
+    cache_msgs_->Start();
+  }
+  Tracer::Instance()->SetThreadName("main");
 
   while (worker_ctx_mgr_->WorkerSize()) {
     /// 检查空闲线程队列是否有空闲线程，如果有就找到一个有消息的actor处理
     CheckStopWorkers();
     /// 等待事件
     poller_->Wait(&evs, time_wait_ms);
+    /// 处理其它分片投递的消息
+    shards_[0]->ProcessPostMsg();
+    /// 处理外部线程发送的消息
+    ProcessSendMsg();
     /// 处理缓存消息
     ProcessCacheMsg();
     /// 处理事件
@@ -746,18 +1240,48 @@ int App::Exec() {
   }
 
   // quit App
+  for (auto& shard : shards_) {
+    shard->Join();
+  }
   worker_ctx_mgr_->WaitAllWorkerQuit();
   quit_.store(true);
+  auto spin = poller_->GetSpinWait();
+  LOG_IF(INFO, spin->IsEnabled())
+    << "main spin " << spin->GetSpinCount()
+    << ", hit rate " << spin->GetHitRate();
+  LOG_IF(INFO, cache_msgs_->CachedCount() > 0)
+    << "cache msg " << cache_msgs_->CachedCount()
+    << ", delivered " << cache_msgs_->DeliveredCount()
+    << ", expired " << cache_msgs_->ExpiredCount()
+    << ", evicted " << cache_msgs_->EvictedCount();
   LOG(INFO) << "app exit exec";
   return 0;
 }
 
+void App::StartTrace(std::size_t events_per_thread) {
+  Tracer::Instance()->Start(events_per_thread);
+}
+
+void App::StopTrace() {
+  Tracer::Instance()->Stop();
+}
+
+bool App::DumpTrace(const std::string& file) {
+  auto addr_mgr = addr_mgr_;
+  return Tracer::Instance()->Dump(file, [addr_mgr](addr_id_t id) {
+    return addr_mgr->GetAddr(id);
+  });
+}
+
 void App::Quit() {
   // wait worker stop
   if (quit_.load()) {
     return;
   }
   worker_ctx_mgr_->StopAllWorker();
+  if (scheduler_ != nullptr) {
+    scheduler_->Stop();
+  }
 }
 
 bool App::HasUserInst(const std::string& name) {
@@ -768,7 +1292,12 @@ bool App::HasUserInst(const std::string& name) {
       return true;
     }
   } else if (name.substr(0, 5) == "actor") {
-    if (actor_ctx_mgr_->HasActor(name)) {
+    auto id = addr_mgr_->Find(name);
+    if (id == INVALID_ADDR_ID) {
+      return false;
+    }
+    auto shard = GetShard(id);
+    if (shard != nullptr && shard->HasActor(id)) {
       return true;
     }
   }
@@ -6,6 +6,7 @@ Author: 李柯鹏 <likepeng0418@163.com>
 ****************************************************************************/
 #pragma once
 #include <atomic>
+#include <chrono>
 #include <list>
 #include <memory>
 #include <mutex>
@@ -18,17 +19,18 @@ Author: 李柯鹏 <likepeng0418@163.com>
 
 #include "myframe/macros.h"
 #include "myframe/event.h"
+#include "myframe/msg.h"
 #include "myframe/export.h"
 
 namespace stdfs = std::filesystem;
 
 namespace myframe {
 
-class Msg;
 class Poller;
 class Actor;
 class ActorContext;
-class ActorContextManager;
+class DispatchShard;
+class Scheduler;
 class Event;
 class EventManager;
 class EventConn;
@@ -39,8 +41,48 @@ class WorkerCommon;
 class WorkerTimer;
 class WorkerContextManager;
 class ModManager;
+class AddrManager;
+class PendingMsgCache;
+class MailboxLimit;
+class MpscMsgQueue;
+class ShardedCounter;
+
+/**
+ * App::Init() 的运行参数
+ *  与 sys.json 中的配置项对应，未设置的使用默认值;
+ *  新增参数时在此添加字段，不修改 App::Init() 的参数列表
+ */
+struct AppOptions {
+  /// 工作线程数
+  int thread_pool_size{4};
+  /// 外部请求使用的连接数(不够时自动增加)
+  int event_conn_size{2};
+  /// 一次分发的消息数超过该值时告警
+  int warning_msg_size{10};
+  /// 分发分片数，直接分发模式下忽略
+  int dispatcher_shard_size{1};
+  /// 工作线程直接分发actor消息，使用work-stealing调度
+  bool direct_dispatch{false};
+  /// 工作线程绑定的cpu集合，例如: [[0, 1], [2, 3]]
+  Json::Value worker_cpu_affinity;
+  /// 主线程和工作线程阻塞等待之前的自旋时间(us)，0表示不自旋
+  int spin_time_us{0};
+  /// 定时器精度(us)
+  int timer_resolution_us{1000};
+  /// 定时器线程数
+  int timer_worker_size{1};
+  /// 目的地址未注册的消息缓存时间(ms)
+  int cache_msg_ttl_ms{1000};
+  /// 目的地址未注册的消息最大缓存数
+  int cache_msg_max_size{10000};
+};
+
 class MYFRAME_EXPORT App final : public std::enable_shared_from_this<App> {
   friend class Actor;
+  friend class DispatchShard;
+  friend class WorkerCommon;
+  friend class ActorContext;
+  friend class WorkerContextManager;
 
  public:
   App();
@@ -52,6 +94,8 @@ class MYFRAME_EXPORT App final : public std::enable_shared_from_this<App> {
     int event_conn_size = 2,
     int warning_msg_size = 10);
 
+  bool Init(const std::string& lib_dir, const AppOptions& opts);
+
   int LoadServiceFromDir(const std::string& path);
 
   bool LoadServiceFromFile(const std::string& file);
@@ -71,10 +115,49 @@ class MYFRAME_EXPORT App final : public std::enable_shared_from_this<App> {
     std::shared_ptr<Worker> worker,
     const Json::Value& config = Json::Value::nullSingleton());
 
+  /**
+   * Send() - 从外部线程发送消息
+   *
+   *    不阻塞: 消息放入无锁队列后立即返回，由主线程分发;
+   *    连续发送的消息只唤醒主线程一次。
+   *    同一线程发送的消息按发送顺序分发。
+   *    未设置源地址时为 "event.send"，发给该地址的消息会被丢弃。
+   *
+   * @return: 成功返回: 0, 失败返回: -1
+   */
   int Send(std::shared_ptr<Msg> msg);
+  /**
+   * SendBatch() - 从外部线程发送一批消息
+   *
+   *    整批消息一次放入队列，只唤醒主线程一次，按顺序分发;
+   *    有消息没有目的地址时整批都不发送。
+   *
+   * @return: 成功返回: 0, 失败返回: -1
+   */
+  int SendBatch(std::vector<std::shared_ptr<Msg>> msgs);
 
+  /**
+   * SendRequest() - 从外部线程发送请求，阻塞等待回复
+   *
+   *    请求的关联ID由框架分配，使用 Mailbox::Reply() 回复时，
+   *    与请求不匹配的多余回复会被丢弃;
+   *    对方收件箱已满(reject/drop_newest策略)时，
+   *    回复类型为 MSG_TYPE_REJECT 的消息。
+   *
+   * @return: 成功返回: 回复消息, 失败返回: nullptr
+   */
   const std::shared_ptr<const Msg> SendRequest(
     std::shared_ptr<Msg> msg);
+  /**
+   * SendRequestBatch() - 从外部线程发送一批请求，阻塞等待所有回复
+   *
+   *    每个请求需要回复一次，回复与请求按下标对应:
+   *    使用 Mailbox::Reply() 回复时按关联ID对应，否则按到达顺序。
+   *
+   * @return: 回复列表，失败时为nullptr
+   */
+  std::vector<std::shared_ptr<const Msg>> SendRequestBatch(
+    std::vector<std::shared_ptr<Msg>> reqs);
 
   std::unique_ptr<ModManager>& GetModManager() { return mods_; }
 
@@ -82,6 +165,26 @@ class MYFRAME_EXPORT App final : public std::enable_shared_from_this<App> {
 
   void Quit();
 
+  /**
+   * StartTrace() - 开始记录运行轨迹
+   * @events_per_thread: 每个线程缓冲区的事件数，只在第一次调用时生效
+   *
+   *    记录消息发送/分发/投递、actor调度及处理耗时、定时器超时事件;
+   *    每个线程写自己的环形缓冲区，满后覆盖最早的事件。
+   *    可以在运行中随时开始/停止。
+   */
+  void StartTrace(std::size_t events_per_thread = 32768);
+  void StopTrace();
+  /**
+   * DumpTrace() - 导出运行轨迹
+   *
+   *    Chrome trace格式(JSON)，可以用 chrome://tracing 或者 Perfetto 打开;
+   *    建议在 StopTrace() 之后导出。
+   *
+   * @return: 成功返回: true, 失败返回: false
+   */
+  bool DumpTrace(const std::string& file);
+
  private:
   bool CreateActorContext(
     const std::string& mod_name,
@@ -93,8 +196,15 @@ class MYFRAME_EXPORT App final : public std::enable_shared_from_this<App> {
     std::shared_ptr<Actor> inst,
     const std::string& params);
 
+  bool AddWorker(
+    const std::string& inst_name,
+    std::shared_ptr<Worker> worker,
+    std::shared_ptr<DispatchShard> shard,
+    const Json::Value& config);
+
   bool HasUserInst(const std::string& name);
-  std::shared_ptr<WorkerTimer> GetTimerWorker();
+  /* actor的定时器按地址句柄取模分配到定时器线程 */
+  std::shared_ptr<WorkerTimer> GetTimerWorker(addr_id_t id);
 
   bool LoadActors(
     const std::string& mod_name,
@@ -107,8 +217,17 @@ class MYFRAME_EXPORT App final : public std::enable_shared_from_this<App> {
   std::string GetLibName(const std::string& name);
 
   /// worker
-  bool StartCommonWorker(int worker_count);
-  bool StartTimerWorker();
+  bool StartCommonWorker(
+    int worker_count,
+    const Json::Value& worker_cpu_affinity,
+    int spin_time_us);
+  bool StartTimerWorker(int timer_worker_size, int timer_resolution_us);
+
+  /// 分发分片
+  bool CreateShards(int shard_size);
+  std::shared_ptr<DispatchShard> GetShard(addr_id_t id);
+  /* 设置actor绑定的工作线程 */
+  bool SetWorkerAffinity(std::shared_ptr<ActorContext> ctx);
 
   /// 通知执行事件
   void CheckStopWorkers();
@@ -118,43 +237,77 @@ class MYFRAME_EXPORT App final : public std::enable_shared_from_this<App> {
   void DispatchMsg(std::list<std::shared_ptr<Msg>>* msg_list);
   void DispatchMsg(std::shared_ptr<ActorContext> context);
   void ProcessCacheMsg();
+  void ProcessSendMsg();
   void ProcessEvent(const std::vector<ev_handle_t>& evs);
-  void ProcessWorkerEvent(std::shared_ptr<WorkerContext>);
   void ProcessTimerEvent(std::shared_ptr<WorkerContext>);
   void ProcessUserEvent(std::shared_ptr<WorkerContext>);
   void ProcessEventConn(std::shared_ptr<EventConn>);
+  bool DispatchToActor(std::shared_ptr<Msg> msg, addr_id_t dst);
+  /* 直接分发模式: 投递消息到actor收件箱 */
+  void DeliverToActor(std::shared_ptr<ActorContext> ctx,
+    std::shared_ptr<Msg> msg, addr_id_t dst);
+  /* 收件箱有size条消息时按容量策略处理发给dst的消息:
+   * 返回false时消息已被丢弃(或者回复了拒绝消息)，不需要投递;
+   * drop_oldest为true时需要先丢弃收件箱中最早的消息再投递 */
+  bool CheckMailboxLimit(
+    MailboxLimit* limit,
+    std::size_t size,
+    const std::shared_ptr<Msg>& msg,
+    addr_id_t dst,
+    bool* drop_oldest);
+  /* 回复发给dst的消息被拒绝，src_id为发送者 */
+  void ReplyReject(
+    const std::shared_ptr<Msg>& msg, addr_id_t dst, addr_id_t src_id);
+  /* 直接分发模式: 在工作线程中分发actor发送的消息 */
+  void DirectDispatchMsg(std::shared_ptr<ActorContext> context);
+  void DispatchToNode(std::shared_ptr<Msg> msg);
   void ProcessMain(std::shared_ptr<Msg>);
   void GetAllUserModAddr(std::string* info);
+  /* 运行指标快照(JSON), 见 MAIN_CMD_METRICS */
+  void GetMetrics(std::string* info);
 
   stdfs::path lib_dir_;
   /// node地址
   std::string node_addr_;
+  addr_id_t node_addr_id_{INVALID_ADDR_ID};
   std::atomic<std::size_t> warning_msg_size_{10};
+  /// 内置工作线程数
+  std::size_t common_worker_size_{0};
   std::atomic_bool quit_{true};
   std::recursive_mutex local_mtx_;
-  /// 缓存消息列表
-  struct CacheMsg {
-    CacheMsg(int c, std::shared_ptr<Msg> m)
-      : search_count(c)
-      , msg(m) {}
-    int search_count{0};
-    std::shared_ptr<Msg> msg{nullptr};
-  };
-  int default_search_count_{3};
-  std::vector<CacheMsg> cache_msgs_;
+  /// 目的地址未注册的缓存消息
+  std::unique_ptr<PendingMsgCache> cache_msgs_;
 
   /// 模块管理对象
   std::unique_ptr<ModManager> mods_;
+  /// 地址管理对象
+  std::shared_ptr<AddrManager> addr_mgr_;
   /// poller
   std::shared_ptr<Poller> poller_;
-  /// 句柄管理对象
-  std::unique_ptr<ActorContextManager> actor_ctx_mgr_;
+  /// 分发分片(actor按地址句柄取模分配到分片)
+  std::vector<std::shared_ptr<DispatchShard>> shards_;
+  /// 定时器线程(每个线程有自己的时间轮)
+  std::vector<std::shared_ptr<WorkerTimer>> timer_workers_;
+  /// 直接分发模式的调度器(未开启时为nullptr)
+  std::shared_ptr<Scheduler> scheduler_;
   /// 事件管理对象
   std::shared_ptr<EventManager> ev_mgr_;
   /// 与框架通信管理对象
   std::unique_ptr<EventConnManager> ev_conn_mgr_;
   /// 线程管理对象
   std::unique_ptr<WorkerContextManager> worker_ctx_mgr_;
+  /// 外部线程发送的消息
+  std::unique_ptr<MpscMsgQueue> send_msgs_;
+  std::atomic_bool send_notified_{false};
+
+  /// 运行指标
+  std::chrono::steady_clock::time_point start_tp_;
+  std::unique_ptr<ShardedCounter> send_cnt_;
+  std::unique_ptr<ShardedCounter> dispatch_cnt_;
+  std::unique_ptr<ShardedCounter> direct_dispatch_cnt_;
+  /// 上次快照(计算分发速率)
+  std::chrono::steady_clock::time_point last_metrics_tp_;
+  uint64_t last_dispatch_cnt_{0};
 
   DISALLOW_COPY_AND_ASSIGN(App)
 };
@@ -0,0 +1,56 @@
+/****************************************************************************
+Copyright (c) 2019, 李柯鹏
+All rights reserved.
+
+Author: 李柯鹏 <likepeng0418@163.com>
+****************************************************************************/
+
+#include "myframe/buffer.h"
+
+namespace myframe {
+
+Buffer::Buffer(const char* data, std::size_t len)
+  : Buffer(std::make_shared<const std::string>(data, len)) {
+}
+
+Buffer::Buffer(const std::string& data)
+  : Buffer(std::make_shared<const std::string>(data)) {
+}
+
+Buffer::Buffer(std::string&& data)
+  : Buffer(std::make_shared<const std::string>(std::move(data))) {
+}
+
+Buffer::Buffer(std::shared_ptr<const std::string> data) {
+  if (data == nullptr) {
+    return;
+  }
+  str_ = data.get();
+  data_ = data->data();
+  size_ = data->size();
+  owner_ = std::move(data);
+}
+
+Buffer::Buffer(
+  std::shared_ptr<const void> owner,
+  const char* data,
+  std::size_t len)
+  : owner_(std::move(owner))
+  , data_(data == nullptr ? "" : data)
+  , size_(data == nullptr ? 0 : len) {
+}
+
+Buffer Buffer::Slice(std::size_t offset, std::size_t len) const {
+  if (offset == 0 && len >= size_) {
+    return *this;
+  }
+  if (offset >= size_) {
+    return Buffer();
+  }
+  if (len > size_ - offset) {
+    len = size_ - offset;
+  }
+  return Buffer(owner_, data_ + offset, len);
+}
+
+}  // namespace myframe
@@ -0,0 +1,69 @@
+/****************************************************************************
+Copyright (c) 2019, 李柯鹏
+All rights reserved.
+
+Author: 李柯鹏 <likepeng0418@163.com>
+****************************************************************************/
+
+#pragma once
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "myframe/export.h"
+
+namespace myframe {
+
+/**
+ * 引用计数的只读数据缓冲区
+ *
+ *  复制Buffer或者获取子切片不会复制数据，多个消息可以共享同一份数据。
+ *  示例:
+ *    myframe::Buffer buf(std::move(data));  // 接管data，不复制
+ *    msg1->SetBuffer(buf);
+ *    msg2->SetBuffer(buf.Slice(0, 16));     // 共享前16个字节
+ */
+class MYFRAME_EXPORT Buffer final {
+ public:
+  static constexpr std::size_t npos = std::string::npos;
+
+  Buffer() = default;
+  /* 复制数据 */
+  Buffer(const char* data, std::size_t len);
+  explicit Buffer(const std::string& data);
+  /* 接管字符串，不复制数据 */
+  explicit Buffer(std::string&& data);
+  explicit Buffer(std::shared_ptr<const std::string> data);
+  /* 引用外部内存，不复制数据，owner 负责保证内存在引用期间有效 */
+  Buffer(
+    std::shared_ptr<const void> owner,
+    const char* data,
+    std::size_t len);
+
+  const char* Data() const { return data_; }
+  std::size_t Size() const { return size_; }
+  bool Empty() const { return size_ == 0; }
+  std::string_view View() const { return std::string_view(data_, size_); }
+  std::string ToString() const { return std::string(data_, size_); }
+
+  /**
+   * @brief 获得子切片
+   * @note 与原缓冲区共享数据，越界部分会被截断
+   * @return Buffer 子切片
+   */
+  Buffer Slice(std::size_t offset, std::size_t len = npos) const;
+
+  /**
+   * @brief 缓冲区是完整的字符串时返回该字符串
+   * @return const std::string* 不是完整的字符串返回nullptr
+   */
+  const std::string* AsString() const { return str_; }
+
+ private:
+  std::shared_ptr<const void> owner_{nullptr};
+  const std::string* str_{nullptr};
+  const char* data_{""};
+  std::size_t size_{0};
+};
+
+}  // namespace myframe
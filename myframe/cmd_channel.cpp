@@ -10,6 +10,8 @@ Author: 李柯鹏 <likepeng0418@163.com>
 #if defined(MYFRAME_OS_LINUX) || defined(MYFRAME_OS_ANDROID)
   #ifdef MYFRAME_USE_CV
     #include "myframe/platform/cmd_channel_generic.h"
+  #elif defined(MYFRAME_USE_EVENTFD)
+    #include "myframe/platform/cmd_channel_eventfd.h"
   #else
     #include "myframe/platform/cmd_channel_linux.h"
   #endif
@@ -31,6 +33,8 @@ std::shared_ptr<CmdChannel> CmdChannel::Create(
 #if defined(MYFRAME_OS_LINUX) || defined(MYFRAME_OS_ANDROID)
   #ifdef MYFRAME_USE_CV
     return std::make_shared<CmdChannelGeneric>(poller);
+  #elif defined(MYFRAME_USE_EVENTFD)
+    return std::make_shared<CmdChannelEventfd>(poller);
   #else
     return std::make_shared<CmdChannelLinux>(poller);
   #endif
@@ -11,6 +11,7 @@ Author: 李柯鹏 <likepeng0418@163.com>
 #include "myframe/macros.h"
 #include "myframe/event.h"
 #include "myframe/poller.h"
+#include "myframe/spin_wait.h"
 
 namespace myframe {
 
@@ -38,8 +39,12 @@ class MYFRAME_EXPORT CmdChannel {
   virtual int SendToMain(const Cmd& cmd) = 0;
   virtual int RecvFromMain(Cmd* cmd, int timeout_ms = -1) = 0;
 
+  /* RecvFromMain()阻塞之前的自旋等待设置及统计 */
+  SpinWait* GetSpinWait() { return &spin_; }
+
  protected:
   std::shared_ptr<Poller> poller_{nullptr};
+  SpinWait spin_;
 
  private:
   DISALLOW_COPY_AND_ASSIGN(CmdChannel)
@@ -0,0 +1,306 @@
+/****************************************************************************
+Copyright (c) 2019, 李柯鹏
+All rights reserved.
+
+Author: 李柯鹏 <likepeng0418@163.com>
+****************************************************************************/
+#pragma once
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "myframe/msg.h"
+#include "myframe/actor.h"
+
+#define MYFRAME_HAS_CO_ACTOR
+
+namespace myframe {
+
+class CoActor;
+/**
+ * 协程任务
+ *
+ *  创建后不立即执行:
+ *    在actor中调用 CoActor::Spawn() 启动，执行结束后自动释放;
+ *    或者在另一个协程中 co_await 执行，执行结束后恢复等待的协程。
+ */
+class CoTask final {
+ public:
+  struct promise_type;
+  using Handle = std::coroutine_handle<promise_type>;
+
+  struct FinalAwaiter {
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(Handle h) noexcept;
+    void await_resume() const noexcept {}
+  };
+
+  struct promise_type {
+    CoTask get_return_object() { return CoTask(Handle::from_promise(*this)); }
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void return_void() const noexcept {}
+    void unhandled_exception() const noexcept { std::terminate(); }
+
+    /// 启动该任务的actor(由Spawn()设置)
+    CoActor* actor{nullptr};
+    /// 等待该任务的协程
+    std::coroutine_handle<> continuation{nullptr};
+    /// 由Spawn()启动，结束后自行释放
+    bool detached{false};
+  };
+
+  CoTask() = default;
+  CoTask(CoTask&& other) noexcept : h_(std::exchange(other.h_, nullptr)) {}
+  CoTask& operator=(CoTask&& other) noexcept {
+    if (this != &other) {
+      Reset();
+      h_ = std::exchange(other.h_, nullptr);
+    }
+    return *this;
+  }
+  ~CoTask() { Reset(); }
+
+  bool Valid() const { return h_ != nullptr; }
+
+  /* co_await task: 执行task，结束后恢复当前协程 */
+  auto operator co_await() && noexcept {
+    struct Awaiter {
+      Handle h;
+      bool await_ready() const noexcept { return h == nullptr; }
+      std::coroutine_handle<> await_suspend(
+          std::coroutine_handle<> caller) noexcept {
+        h.promise().continuation = caller;
+        return h;
+      }
+      void await_resume() const noexcept {}
+    };
+    return Awaiter{h_};
+  }
+
+ private:
+  friend class CoActor;
+  explicit CoTask(Handle h) : h_(h) {}
+  Handle Release() { return std::exchange(h_, nullptr); }
+  void Reset() {
+    if (h_ != nullptr) {
+      h_.destroy();
+      h_ = nullptr;
+    }
+  }
+
+  Handle h_{nullptr};
+
+  CoTask(const CoTask&) = delete;
+  CoTask& operator=(const CoTask&) = delete;
+};
+
+/**
+ * 协程actor(需要C++20)
+ *
+ *  实现 CoProc() 代替 Proc()，在 CoProc() 中可以 co_await:
+ *    CoRequest(): 请求回复
+ *    CoRequestAll(): 同时发送多个请求，等待所有回复
+ *    CoSleep(): 定时器
+ *    其它CoTask
+ *  等待期间不占用工作线程，actor继续处理后续消息;
+ *  协程在actor自己的调度中恢复，与Proc()一样不需要加锁。
+ *  actor销毁时未结束的协程直接释放。
+ *
+ *  注意: 协程参数在挂起后仍然需要有效，不要使用引用参数。
+ */
+class CoActor : public Actor {
+  friend struct CoTask::FinalAwaiter;
+
+ public:
+  /* 请求目的地址及消息 */
+  using RequestItem = std::pair<std::string, std::shared_ptr<Msg>>;
+
+  CoActor() = default;
+  virtual ~CoActor() {
+    // 释放未结束的协程，协程中等待的子任务随之释放
+    auto tasks = std::move(tasks_);
+    for (auto addr : tasks) {
+      CoTask::Handle::from_address(addr).destroy();
+    }
+  }
+
+ protected:
+  /**
+   * CoProc() - 协程消息处理函数
+   * @msg:      actor收到的消息
+   */
+  virtual CoTask CoProc(std::shared_ptr<const Msg> msg) = 0;
+
+  /**
+   * Spawn() - 启动协程任务
+   *
+   *      执行到第一次挂起时返回，比如在 Init() 中启动流程。
+   */
+  void Spawn(CoTask task) {
+    auto h = task.Release();
+    if (h == nullptr) {
+      return;
+    }
+    h.promise().actor = this;
+    h.promise().detached = true;
+    tasks_.insert(h.address());
+    h.resume();
+  }
+
+  /**
+   * CoRequest() - 发送请求并等待回复
+   *
+   *      co_await 的结果为回复消息，超时或者发送失败为nullptr，
+   *      对方拒绝时类型为 MSG_TYPE_REJECT，见 Actor::Request()。
+   */
+  auto CoRequest(
+      std::string dst,
+      std::shared_ptr<Msg> msg,
+      std::chrono::nanoseconds timeout) {
+    struct Awaiter {
+      CoActor* actor;
+      std::string dst;
+      std::shared_ptr<Msg> msg;
+      std::chrono::nanoseconds timeout;
+      std::shared_ptr<const Msg> resp{nullptr};
+
+      bool await_ready() const noexcept { return false; }
+      bool await_suspend(std::coroutine_handle<> h) {
+        // 回调在actor之后的调度中执行，不会在这里恢复
+        return 0 == actor->Request(dst, std::move(msg), timeout,
+          [this, h](const std::shared_ptr<const Msg>& r) {
+            resp = r;
+            h.resume();
+          });
+      }
+      std::shared_ptr<const Msg> await_resume() { return std::move(resp); }
+    };
+    return Awaiter{this, std::move(dst), std::move(msg), timeout};
+  }
+
+  /**
+   * CoRequestAll() - 同时发送多个请求并等待所有回复
+   *
+   *      co_await 的结果与请求按下标对应，超时或者发送失败为nullptr。
+   */
+  auto CoRequestAll(
+      std::vector<RequestItem> reqs,
+      std::chrono::nanoseconds timeout) {
+    struct State {
+      std::vector<std::shared_ptr<const Msg>> resps;
+      std::size_t remain{0};
+      std::coroutine_handle<> h{nullptr};
+    };
+    struct Awaiter {
+      CoActor* actor;
+      std::vector<RequestItem> reqs;
+      std::chrono::nanoseconds timeout;
+      std::shared_ptr<State> state{std::make_shared<State>()};
+
+      bool await_ready() const noexcept { return reqs.empty(); }
+      bool await_suspend(std::coroutine_handle<> h) {
+        state->h = h;
+        state->resps.resize(reqs.size());
+        state->remain = reqs.size();
+        for (std::size_t i = 0; i < reqs.size(); ++i) {
+          auto ret = actor->Request(
+            reqs[i].first, std::move(reqs[i].second), timeout,
+            [state = state, i](const std::shared_ptr<const Msg>& r) {
+              state->resps[i] = r;
+              if (--state->remain == 0) {
+                state->h.resume();
+              }
+            });
+          if (ret != 0) {
+            --state->remain;
+          }
+        }
+        return state->remain > 0;
+      }
+      std::vector<std::shared_ptr<const Msg>> await_resume() {
+        return std::move(state->resps);
+      }
+    };
+    return Awaiter{this, std::move(reqs), timeout};
+  }
+
+  /**
+   * CoSleep() - 等待一段时间
+   *
+   *      使用独立定时器实现，精度由定时器精度决定;
+   *      co_await 的结果: 成功 0, 设置定时器失败 -1(不等待)。
+   */
+  auto CoSleep(std::chrono::nanoseconds duration) {
+    struct Awaiter {
+      CoActor* actor;
+      std::chrono::nanoseconds duration;
+      int ret{0};
+
+      bool await_ready() const noexcept { return false; }
+      bool await_suspend(std::coroutine_handle<> h) {
+        timer_handle_t handle = INVALID_TIMER_HANDLE;
+        ret = actor->Timeout(kSleepTimerName, duration, &handle);
+        if (ret != 0) {
+          return false;
+        }
+        actor->sleeping_[handle] = h;
+        return true;
+      }
+      int await_resume() const noexcept { return ret; }
+    };
+    return Awaiter{this, duration};
+  }
+
+ private:
+  static constexpr const char* kSleepTimerName = "myframe.co.sleep";
+
+  void Proc(const std::shared_ptr<const Msg>& msg) final {
+    // CoSleep() 的定时器
+    if (msg->GetType() == "TIMER" && msg->GetDesc() == kSleepTimerName) {
+      auto it = sleeping_.find(msg->GetCorrelationId());
+      if (it != sleeping_.end()) {
+        auto h = it->second;
+        sleeping_.erase(it);
+        h.resume();
+      }
+      return;
+    }
+    Spawn(CoProc(msg));
+  }
+
+  /* Spawn() 启动的协程结束 */
+  void OnTaskDone(CoTask::Handle h) { tasks_.erase(h.address()); }
+
+  /// Spawn() 启动且未结束的协程(协程帧地址)
+  std::unordered_set<void*> tasks_;
+  /// CoSleep() 等待中的协程, key: 定时器句柄
+  std::unordered_map<timer_handle_t, std::coroutine_handle<>> sleeping_;
+};
+
+inline std::coroutine_handle<> CoTask::FinalAwaiter::await_suspend(
+    Handle h) noexcept {
+  auto& promise = h.promise();
+  if (promise.continuation != nullptr) {
+    return promise.continuation;
+  }
+  if (promise.detached) {
+    if (promise.actor != nullptr) {
+      promise.actor->OnTaskDone(h);
+    }
+    h.destroy();
+  }
+  return std::noop_coroutine();
+}
+
+}  // namespace myframe
+
+#endif
@@ -11,6 +11,8 @@ Author: 李柯鹏 <likepeng0418@163.com>
 #include "myframe/platform.h"
 #if defined(MYFRAME_OS_LINUX) || defined(MYFRAME_OS_ANDROID)
 #include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
 #elif defined(MYFRAME_OS_WINDOWS)
 #include <Windows.h>
 #elif defined(MYFRAME_OS_MACOSX)
@@ -22,6 +24,8 @@ Author: 李柯鹏 <likepeng0418@163.com>
 #include <fstream>
 #include <sstream>
 
+#include "myframe/log.h"
+
 #define MYFRAME_MAX_PATH 256
 
 namespace myframe {
@@ -118,4 +122,73 @@ std::vector<std::string> Common::SplitMsgName(const std::string& name) {
   return name_list;
 }
 
+bool Common::ParseIndexList(
+  const Json::Value& conf, std::vector<int>* idx_list) {
+  idx_list->clear();
+  if (conf.isInt()) {
+    idx_list->push_back(conf.asInt());
+  } else if (conf.isArray()) {
+    for (Json::ArrayIndex i = 0; i < conf.size(); ++i) {
+      if (!conf[i].isInt()) {
+        return false;
+      }
+      idx_list->push_back(conf[i].asInt());
+    }
+  } else if (conf.isString()) {
+    std::string item;
+    std::stringstream ss(conf.asString());
+    while (std::getline(ss, item, ',')) {
+      int first = 0;
+      int last = 0;
+      char dash = 0;
+      std::stringstream range(item);
+      if (!(range >> first)) {
+        return false;
+      }
+      last = first;
+      if (range >> dash && (dash != '-' || !(range >> last))) {
+        return false;
+      }
+      for (int idx = first; idx <= last; ++idx) {
+        idx_list->push_back(idx);
+      }
+    }
+  } else {
+    return false;
+  }
+  for (auto idx : *idx_list) {
+    if (idx < 0) {
+      return false;
+    }
+  }
+  return !idx_list->empty();
+}
+
+bool Common::SetThreadAffinity(const std::vector<int>& cpus) {
+  if (cpus.empty()) {
+    return false;
+  }
+#if defined(MYFRAME_OS_LINUX) || defined(MYFRAME_OS_ANDROID)
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (auto cpu : cpus) {
+    if (cpu >= CPU_SETSIZE) {
+      LOG(WARNING) << "cpu " << cpu << " out of range, skip";
+      continue;
+    }
+    CPU_SET(cpu, &cpu_set);
+  }
+  int ret = pthread_setaffinity_np(
+    pthread_self(), sizeof(cpu_set), &cpu_set);
+  if (ret != 0) {
+    LOG(WARNING) << "set thread affinity failed, " << strerror(ret);
+    return false;
+  }
+  return true;
+#else
+  LOG(WARNING) << "set thread affinity not supported on this platform";
+  return false;
+#endif
+}
+
 }  // namespace myframe
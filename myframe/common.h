@@ -39,6 +39,12 @@ class MYFRAME_EXPORT Common final {
     src->clear();
   }
   static std::vector<std::string> SplitMsgName(const std::string& name);
+
+  /* 解析序号列表(cpu/工作线程): 整数 2, 数组 [0, 1] 或字符串 "0-3,6" */
+  static bool ParseIndexList(
+    const Json::Value& conf, std::vector<int>* idx_list);
+  /* 将当前线程绑定到cpu集合上运行 */
+  static bool SetThreadAffinity(const std::vector<int>& cpus);
 };
 
 }  // namespace myframe
@@ -0,0 +1,335 @@
+/****************************************************************************
+Copyright (c) 2019, 李柯鹏
+All rights reserved.
+
+Author: 李柯鹏 <likepeng0418@163.com>
+****************************************************************************/
+
+#include "myframe/dispatch_shard.h"
+
+#include <functional>
+#include <thread>
+
+#include "myframe/log.h"
+#include "myframe/msg.h"
+#include "myframe/mailbox.h"
+#include "myframe/poller.h"
+#include "myframe/cmd_channel.h"
+#include "myframe/actor.h"
+#include "myframe/actor_context.h"
+#include "myframe/actor_context_manager.h"
+#include "myframe/addr_manager.h"
+#include "myframe/event_manager.h"
+#include "myframe/worker_common.h"
+#include "myframe/worker_context.h"
+#include "myframe/worker_context_manager.h"
+#include "myframe/app.h"
+#include "myframe/trace.h"
+
+namespace myframe {
+
+DispatchShard::DispatchShard(
+  std::shared_ptr<App> app,
+  std::size_t index,
+  std::shared_ptr<Poller> poller,
+  std::shared_ptr<EventManager> ev_mgr,
+  std::size_t warning_msg_size)
+  : index_(index)
+  , warning_msg_size_(warning_msg_size)
+  , app_(app)
+  , poller_(poller)
+  , ev_mgr_(ev_mgr)
+  , actor_ctx_mgr_(new ActorContextManager()) {
+  LOG(INFO) << "DispatchShard " << index_ << " create";
+}
+
+DispatchShard::~DispatchShard() {
+  LOG(INFO) << "DispatchShard " << index_ << " deconstruct";
+}
+
+bool DispatchShard::RegContext(std::shared_ptr<ActorContext> ctx) {
+  if (!ctx->GetWorkerAffinity().empty()) {
+    has_bound_actor_.store(true);
+  }
+  return actor_ctx_mgr_->RegContext(ctx);
+}
+
+bool DispatchShard::HasActor(addr_id_t id) {
+  return actor_ctx_mgr_->HasActor(id);
+}
+
+bool DispatchShard::HasActor(const std::string& name) {
+  return actor_ctx_mgr_->HasActor(name);
+}
+
+std::shared_ptr<ActorContext> DispatchShard::GetContext(addr_id_t id) {
+  return actor_ctx_mgr_->GetContext(id);
+}
+
+std::vector<std::string> DispatchShard::GetAllActorAddr() {
+  return actor_ctx_mgr_->GetAllActorAddr();
+}
+
+std::vector<std::shared_ptr<ActorContext>> DispatchShard::GetAllContext() {
+  return actor_ctx_mgr_->GetAllContext();
+}
+
+bool DispatchShard::DispatchActorMsg(
+  std::shared_ptr<Msg> msg,
+  addr_id_t dst) {
+  auto ctx = actor_ctx_mgr_->GetContext(dst);
+  if (nullptr == ctx) {
+    return false;
+  }
+  // 收件箱容量限制
+  auto limit = ctx->GetMailboxLimit();
+  if (limit->IsBounded()) {
+    auto app = app_.lock();
+    if (app == nullptr) {
+      return false;
+    }
+    auto mailbox = ctx->GetMailbox();
+    bool drop_oldest = false;
+    if (!app->CheckMailboxLimit(
+        limit, mailbox->RecvSize(), msg, dst, &drop_oldest)) {
+      return true;
+    }
+    if (drop_oldest) {
+      mailbox->DropRecv();
+    }
+  }
+  return actor_ctx_mgr_->DispatchMsg(msg, dst);
+}
+
+void DispatchShard::Post(std::shared_ptr<Msg> msg, addr_id_t dst) {
+  if (dst == INVALID_ADDR_ID) {
+    dst = msg->GetDstId();
+  }
+  post_msgs_.Push(PostMsg{dst, std::move(msg)});
+  // 多次投递只唤醒一次
+  if (!post_notified_.exchange(true)) {
+    poller_->Wakeup();
+  }
+}
+
+void DispatchShard::ProcessPostMsg() {
+  // 读到标记的同时看到设置标记之前入队的消息
+  post_notified_.exchange(false, std::memory_order_acq_rel);
+  auto app = app_.lock();
+  if (app == nullptr) {
+    return;
+  }
+  PostMsg post;
+  while (true) {
+    while (post_msgs_.Pop(&post)) {
+      if (index_ == 0) {
+        app->DispatchMsg(post.msg);
+        continue;
+      }
+      if (!DispatchActorMsg(post.msg, post.dst)) {
+        LOG(ERROR) << "Unknown msg " << *post.msg;
+      }
+    }
+    // 有消息正在入队(还没有链接好)时等待链接完成后取出，
+    // 不留到下一次唤醒
+    if (post_msgs_.Empty()) {
+      break;
+    }
+    std::this_thread::yield();
+  }
+}
+
+bool DispatchShard::AddWorker(std::shared_ptr<WorkerContext> worker_ctx) {
+  if (!poller_->Add(worker_ctx)) {
+    return false;
+  }
+  worker_count_.fetch_add(1);
+  return true;
+}
+
+// 其它分片的actor消息直接投递到对应分片，其余消息交给分片0处理
+void DispatchShard::Route(std::shared_ptr<Msg> msg) {
+  auto app = app_.lock();
+  if (app == nullptr) {
+    return;
+  }
+  auto dst_id = msg->GetDstId();
+  if (dst_id != INVALID_ADDR_ID
+      && app->addr_mgr_->GetType(dst_id) == AddrManager::Type::kActor) {
+    auto shard = app->GetShard(dst_id);
+    if (shard.get() == this) {
+      if (DispatchActorMsg(msg, dst_id)) {
+        return;
+      }
+    } else if (shard->GetIndex() != 0 && shard->HasActor(dst_id)) {
+      shard->Post(msg);
+      return;
+    }
+  }
+  app->shards_[0]->Post(msg);
+}
+
+void DispatchShard::DispatchMsg(std::shared_ptr<ActorContext> ctx) {
+  if (nullptr == ctx) {
+    return;
+  }
+  if (index_ == 0) {
+    auto app = app_.lock();
+    if (app != nullptr) {
+      app->DispatchMsg(ctx);
+    }
+    return;
+  }
+  VLOG(1) << ctx->GetActor()->GetActorName() << " dispatch msg...";
+  ctx->SetRuningFlag(false);
+  auto msg_list = ctx->GetMailbox()->GetSendList();
+  LOG_IF(WARNING,
+      msg_list->size() > warning_msg_size_)
+    << " dispatch msg too many";
+  for (auto& msg : (*msg_list)) {
+    Route(msg);
+  }
+  msg_list->clear();
+}
+
+void DispatchShard::CheckStopWorkers() {
+  LOG_IF(INFO, idle_workers_ctx_.empty())
+      << "worker busy, wait for idle worker...";
+  std::shared_ptr<ActorContext> actor_ctx = nullptr;
+  std::shared_ptr<WorkerContext> worker_ctx = nullptr;
+  auto it = idle_workers_ctx_.begin();
+  while (it != idle_workers_ctx_.end()) {
+    if (nullptr == (worker_ctx = it->lock())) {
+      it = idle_workers_ctx_.erase(it);
+      continue;
+    }
+    auto common_idle_worker = worker_ctx->GetWorker<WorkerCommon>();
+    actor_ctx = actor_ctx_mgr_->GetContextWithMsg(
+      common_idle_worker->GetIndex());
+    if (nullptr == actor_ctx) {
+      // 有绑定工作线程的actor时，其它空闲线程可能还有可处理的actor
+      if (has_bound_actor_.load()) {
+        ++it;
+        continue;
+      }
+      VLOG(1) << "no actor need process, waiting...";
+      break;
+    }
+    VLOG(1)
+      << actor_ctx->GetActor()->GetActorName()
+      << " dispatch msg to "
+      << *worker_ctx;
+    auto actor_mailbox = actor_ctx->GetMailbox();
+    if (!actor_mailbox->RecvEmpty()) {
+      LOG_IF(WARNING,
+        actor_mailbox->RecvSize() > static_cast<int>(warning_msg_size_))
+          << actor_ctx->GetActor()->GetActorName()
+          << " recv msg size too many: " << actor_mailbox->RecvSize();
+      VLOG(1) << "run " << actor_ctx->GetActor()->GetActorName();
+      worker_ctx->GetMailbox()->Recv(actor_mailbox);
+      actor_ctx->GetMetrics()->SetDepth(0);
+      Tracer::Instant(Tracer::Event::kSchedule,
+        actor_mailbox->AddrId(), common_idle_worker->GetIndex());
+      // 收件箱已经交给工作线程，恢复被限流的发送者
+      if (actor_ctx->GetMailboxLimit()->HasMuted()) {
+        actor_ctx->GetMailboxLimit()->UnmuteAll();
+      }
+      VLOG(1) << actor_ctx->GetActor()->GetActorName()
+        << " has " << worker_ctx->GetMailbox()->RecvSize()
+        << " msg need process";
+      it = idle_workers_ctx_.erase(it);
+      common_idle_worker->SetActorContext(actor_ctx);
+      worker_ctx->GetCmdChannel()->SendToOwner(CmdChannel::Cmd::kRun);
+    } else {
+      LOG(ERROR) << actor_ctx->GetActor()->GetActorName() << " has no msg";
+    }
+  }
+}
+
+/// FIXME: Idle/DispatchMsg 会影响actor的执行顺序
+void DispatchShard::ProcessWorkerEvent(
+  std::shared_ptr<WorkerContext> worker_ctx) {
+  // 将actor的发送队列分发完毕
+  auto worker = worker_ctx->GetWorker<WorkerCommon>();
+  VLOG_IF(1, worker->GetActorContext() != nullptr)
+      << *worker_ctx << " dispatch "
+      << worker->GetActorContext()->GetActor()->GetActorName() << " msg...";
+  DispatchMsg(worker->GetActorContext());
+
+  CmdChannel::Cmd cmd;
+  auto cmd_channel = worker_ctx->GetCmdChannel();
+  cmd_channel->RecvFromOwner(&cmd);
+  switch (cmd) {
+    case CmdChannel::Cmd::kIdle:  // idle
+      // 将工作线程中的actor状态设置为全局状态
+      // 将线程加入空闲队列
+      VLOG(1)
+        << *worker_ctx
+        << " idle, push to idle queue";
+      worker->Idle();
+      idle_workers_ctx_.emplace_back(worker_ctx);
+      break;
+    case CmdChannel::Cmd::kQuit:  // quit
+    {
+      LOG(INFO)
+        << *worker_ctx
+        << " quit, delete from shard " << index_;
+      poller_->Del(worker_ctx);
+      worker_count_.fetch_sub(1);
+      auto app = app_.lock();
+      if (app != nullptr) {
+        app->worker_ctx_mgr_->Del(worker_ctx);
+      }
+      // FIXME: 应该将worker加入删除队列，等worker运行结束后再从队列删除
+      // 否则会造成删除智能指针后，worker还没结束运行造成coredump
+      break;
+    }
+    default:
+      LOG(WARNING) << "unknown common worker cmd: " << static_cast<char>(cmd);
+      break;
+  }
+}
+
+void DispatchShard::Start() {
+  if (index_ == 0 || th_.joinable()) {
+    return;
+  }
+  th_ = std::thread(std::bind(&DispatchShard::ListenThread, this));
+}
+
+void DispatchShard::Join() {
+  if (th_.joinable()) {
+    th_.join();
+  }
+}
+
+void DispatchShard::ListenThread() {
+  LOG(INFO) << "DispatchShard " << index_ << " start";
+  Tracer::Instance()->SetThreadName("shard." + std::to_string(index_));
+  int time_wait_ms = 100;
+  std::vector<ev_handle_t> evs;
+  while (worker_count_.load() > 0) {
+    /// 检查空闲线程队列是否有空闲线程，如果有就找到一个有消息的actor处理
+    CheckStopWorkers();
+    /// 等待事件
+    poller_->Wait(&evs, time_wait_ms);
+    /// 处理其它分片投递的消息
+    ProcessPostMsg();
+    /// 处理工作线程事件
+    for (std::size_t i = 0; i < evs.size(); ++i) {
+      auto worker_ctx = ev_mgr_->Get<WorkerContext>(evs[i]);
+      if (worker_ctx == nullptr) {
+        LOG(WARNING) << "can't find worker ctx, handle " << evs[i];
+        continue;
+      }
+      ProcessWorkerEvent(worker_ctx);
+    }
+  }
+  auto spin = poller_->GetSpinWait();
+  LOG_IF(INFO, spin->IsEnabled())
+    << "DispatchShard " << index_ << " spin " << spin->GetSpinCount()
+    << ", hit rate " << spin->GetHitRate();
+  LOG(INFO) << "DispatchShard " << index_ << " exit";
+}
+
+}  // namespace myframe
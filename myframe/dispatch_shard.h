@@ -0,0 +1,106 @@
+/****************************************************************************
+Copyright (c) 2019, 李柯鹏
+All rights reserved.
+
+Author: 李柯鹏 <likepeng0418@163.com>
+****************************************************************************/
+
+#pragma once
+#include <atomic>
+#include <list>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "myframe/macros.h"
+#include "myframe/msg.h"
+#include "myframe/mpsc_queue.h"
+
+namespace myframe {
+
+class App;
+class Poller;
+class EventManager;
+class ActorContext;
+class ActorContextManager;
+class WorkerContext;
+/**
+ * 分发分片
+ *
+ *  每个分片拥有一部分actor(按地址句柄取模划分)、自己的poller
+ *  以及自己的空闲工作线程链表，负责这部分actor的调度。
+ *  分片0由App::Exec所在线程驱动，并负责框架消息/用户worker/定时器等分发;
+ *  其它分片运行在自己的线程中，跨分片的消息通过无锁队列投递。
+ */
+class DispatchShard final {
+ public:
+  DispatchShard(
+    std::shared_ptr<App> app,
+    std::size_t index,
+    std::shared_ptr<Poller> poller,
+    std::shared_ptr<EventManager> ev_mgr,
+    std::size_t warning_msg_size);
+  virtual ~DispatchShard();
+
+  std::size_t GetIndex() const { return index_; }
+  std::shared_ptr<Poller> GetPoller() { return poller_; }
+
+  /// actor
+  bool RegContext(std::shared_ptr<ActorContext> ctx);
+  bool HasActor(addr_id_t id);
+  bool HasActor(const std::string& name);
+  std::shared_ptr<ActorContext> GetContext(addr_id_t id);
+  std::vector<std::string> GetAllActorAddr();
+  std::vector<std::shared_ptr<ActorContext>> GetAllContext();
+  /* 分发消息给本分片的actor, 只能在分片线程中调用 */
+  bool DispatchActorMsg(std::shared_ptr<Msg> msg, addr_id_t dst);
+
+  /* 投递消息给该分片，可以在任意线程调用
+   * dst为无效句柄时使用消息的目的地址句柄 */
+  void Post(std::shared_ptr<Msg> msg, addr_id_t dst = INVALID_ADDR_ID);
+  /* 处理投递给该分片的消息 */
+  void ProcessPostMsg();
+
+  /// 内置工作线程
+  bool AddWorker(std::shared_ptr<WorkerContext> worker_ctx);
+  std::size_t IdleWorkerSize() const { return idle_workers_ctx_.size(); }
+  /* 通知空闲线程处理有消息的actor */
+  void CheckStopWorkers();
+  void ProcessWorkerEvent(std::shared_ptr<WorkerContext> worker_ctx);
+
+  /// 分片线程(分片0不创建线程)
+  void Start();
+  void Join();
+
+ private:
+  void ListenThread();
+  void DispatchMsg(std::shared_ptr<ActorContext> ctx);
+  void Route(std::shared_ptr<Msg> msg);
+
+  std::size_t index_{0};
+  std::size_t warning_msg_size_{10};
+  std::weak_ptr<App> app_;
+  std::shared_ptr<Poller> poller_;
+  std::shared_ptr<EventManager> ev_mgr_;
+  /// 本分片的actor
+  std::unique_ptr<ActorContextManager> actor_ctx_mgr_;
+  /// 本分片的空闲线程链表
+  std::list<std::weak_ptr<WorkerContext>> idle_workers_ctx_;
+  /// 本分片是否有绑定工作线程的actor
+  std::atomic_bool has_bound_actor_{false};
+  /// 本分片的工作线程数
+  std::atomic_int worker_count_{0};
+  /// 跨线程投递的消息
+  struct PostMsg {
+    addr_id_t dst{INVALID_ADDR_ID};
+    std::shared_ptr<Msg> msg{nullptr};
+  };
+  MpscQueue<PostMsg> post_msgs_;
+  std::atomic_bool post_notified_{false};
+  std::thread th_;
+
+  DISALLOW_COPY_AND_ASSIGN(DispatchShard)
+};
+
+}  // namespace myframe
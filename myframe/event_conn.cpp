@@ -40,6 +40,7 @@ int EventConn::Send(std::shared_ptr<Msg> msg) {
   mailbox_.SendClear();
   if (msg->GetSrc().empty()) {
     msg->SetSrc(mailbox_.Addr());
+    msg->SetSrcId(mailbox_.AddrId());
   }
   if (msg->GetDst().empty()) {
     return -1;
@@ -56,11 +57,16 @@ const std::shared_ptr<const Msg> EventConn::SendRequest(
   mailbox_.SendClear();
   if (req->GetSrc().empty()) {
     req->SetSrc(mailbox_.Addr());
+    req->SetSrcId(mailbox_.AddrId());
   }
   if (req->GetDst().empty()) {
     return nullptr;
   }
+  req->SetCorrelationId(++last_req_id_);
   mailbox_.Send(req);
+  resp_first_id_.store(last_req_id_);
+  resp_recv_.assign(1, 0);
+  resp_size_.store(1);
   cmd_channel_->SendToMain(CmdChannel::Cmd::kRunWithMsg);
   CmdChannel::Cmd cmd;
   cmd_channel_->RecvFromMain(&cmd);
@@ -72,4 +78,74 @@ const std::shared_ptr<const Msg> EventConn::SendRequest(
   return msg;
 }
 
+// 请求的关联ID为起始ID+下标，使用 Mailbox::Reply() 的回复按关联ID放到对应位置，
+// 其它回复按到达顺序放到剩余的位置
+std::vector<std::shared_ptr<const Msg>> EventConn::SendRequestBatch(
+  const std::vector<std::shared_ptr<Msg>>& reqs) {
+  std::vector<std::shared_ptr<const Msg>> resps(reqs.size(), nullptr);
+  conn_type_ = EventConn::Type::kSendReq;
+  mailbox_.SendClear();
+  auto first_id = last_req_id_ + 1;
+  for (std::size_t i = 0; i < reqs.size(); ++i) {
+    auto& req = reqs[i];
+    if (req->GetDst().empty()) {
+      mailbox_.SendClear();
+      return resps;
+    }
+    if (req->GetSrc().empty()) {
+      req->SetSrc(mailbox_.Addr());
+      req->SetSrcId(mailbox_.AddrId());
+    }
+    req->SetCorrelationId(first_id + i);
+    mailbox_.Send(req);
+  }
+  if (reqs.empty()) {
+    return resps;
+  }
+  last_req_id_ += reqs.size();
+  resp_first_id_.store(first_id);
+  resp_recv_.assign(reqs.size(), 0);
+  resp_size_.store(reqs.size());
+  cmd_channel_->SendToMain(CmdChannel::Cmd::kRunWithMsg);
+  CmdChannel::Cmd cmd;
+  cmd_channel_->RecvFromMain(&cmd);
+  std::vector<std::shared_ptr<const Msg>> unmatched;
+  while (!mailbox_.RecvEmpty()) {
+    auto resp = mailbox_.PopRecv();
+    auto id = resp->GetCorrelationId();
+    if (resp->IsReply() && id >= first_id && id <= last_req_id_
+        && resps[id - first_id] == nullptr) {
+      resps[id - first_id] = resp;
+    } else {
+      unmatched.emplace_back(resp);
+    }
+  }
+  mailbox_.RecvClear();
+  std::size_t idx = 0;
+  for (auto& resp : unmatched) {
+    while (idx < resps.size() && resps[idx] != nullptr) {
+      ++idx;
+    }
+    if (idx == resps.size()) {
+      break;
+    }
+    resps[idx] = resp;
+  }
+  return resps;
+}
+
+bool EventConn::AcceptResp(const Msg& msg) {
+  if (!msg.IsReply()) {
+    return true;
+  }
+  auto id = msg.GetCorrelationId();
+  auto first_id = resp_first_id_.load();
+  if (id < first_id || id - first_id >= resp_recv_.size()
+      || resp_recv_[id - first_id] != 0) {
+    return false;
+  }
+  resp_recv_[id - first_id] = 1;
+  return true;
+}
+
 }  // namespace myframe
@@ -5,8 +5,12 @@ All rights reserved.
 Author: 李柯鹏 <likepeng0418@163.com>
 ****************************************************************************/
 #pragma once
+#include <stdint.h>
+
+#include <atomic>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "myframe/macros.h"
 #include "myframe/event.h"
@@ -34,20 +38,39 @@ class EventConn final : public Event {
   Event::Type GetType() const override;
   std::string GetName() const override;
 
-  EventConn::Type GetConnType() { return conn_type_; }
+  EventConn::Type GetConnType() { return conn_type_.load(); }
 
   int Send(std::shared_ptr<Msg> msg);
 
   const std::shared_ptr<const Msg> SendRequest(
     std::shared_ptr<Msg> req);
 
+  /* 发送一批请求，收到所有回复后返回，回复与请求按下标对应 */
+  std::vector<std::shared_ptr<const Msg>> SendRequestBatch(
+    const std::vector<std::shared_ptr<Msg>>& reqs);
+
  private:
   Mailbox* GetMailbox();
   CmdChannel* GetCmdChannel();
 
   std::shared_ptr<CmdChannel> cmd_channel_;
   Mailbox mailbox_;
-  EventConn::Type conn_type_{ EventConn::Type::kSendReq };
+  /// 请求线程设置，主线程处理迟到的回复时读取
+  std::atomic<EventConn::Type> conn_type_{ EventConn::Type::kSendReq };
+  /* 主线程收到回复时调用: 按关联ID匹配当前请求，
+   * 不属于当前请求或者重复的回复返回false; 没有关联ID的回复都接收 */
+  bool AcceptResp(const Msg& msg);
+
+  /// 等待的回复数，请求线程设置，主线程收到回复时减少
+  std::atomic<std::size_t> resp_size_{0};
+  /// 当前请求的起始关联ID
+  std::atomic<uint64_t> resp_first_id_{0};
+  /// 每个请求是否已收到回复，请求线程发送前设置，之后只由主线程访问
+  std::vector<uint8_t> resp_recv_;
+  /// 已分配的关联ID，连接复用时不重复，只由请求线程访问
+  uint64_t last_req_id_{0};
+  /// 是否已被分配，请求线程收到主线程的回复后才释放
+  std::atomic_bool in_use_{false};
 
   DISALLOW_COPY_AND_ASSIGN(EventConn)
 };
@@ -7,62 +7,105 @@ Author: 李柯鹏 <likepeng0418@163.com>
 
 #include "myframe/event_conn_manager.h"
 
+#include <atomic>
+
 #include "myframe/log.h"
 #include "myframe/event_conn.h"
 #include "myframe/event_manager.h"
+#include "myframe/addr_manager.h"
 
 namespace myframe {
 
+namespace {
+/// 本线程上次使用的连接
+struct ThreadConn {
+  uint64_t mgr_id{0};
+  std::weak_ptr<EventConn> conn;
+};
+thread_local ThreadConn tls_conn;
+std::atomic<uint64_t> mgr_id_gen{0};
+}  // namespace
+
 EventConnManager::EventConnManager(
   std::shared_ptr<EventManager> ev_mgr,
-  std::shared_ptr<Poller> poller)
-  : ev_mgr_(ev_mgr) {
+  std::shared_ptr<Poller> poller,
+  std::shared_ptr<AddrManager> addr_mgr)
+  : id_(++mgr_id_gen)
+  , ev_mgr_(ev_mgr)
+  , addr_mgr_(addr_mgr) {
   poller_ = poller;
   LOG(INFO) << "EventConnManager create";
 }
 
 EventConnManager::~EventConnManager() {
+  for (auto& conn : conns_) {
+    poller_->Del(conn);
+    ev_mgr_->Del(conn);
+  }
   LOG(INFO) << "EventConnManager deconstruct";
 }
 
 bool EventConnManager::Init(int sz) {
+  std::lock_guard<std::mutex> g(mtx_);
   for (int i = 0; i < sz; ++i) {
-    std::lock_guard<std::mutex> g(mtx_);
-    AddEventConn();
+    if (AddEventConn() == nullptr) {
+      return false;
+    }
   }
   return true;
 }
 
-void EventConnManager::AddEventConn() {
+std::shared_ptr<EventConn> EventConnManager::AddEventConn() {
   auto conn = std::make_shared<EventConn>(poller_);
-  std::string name = "event.conn." + std::to_string(conn_sz_);
+  std::string name = "event.conn." + std::to_string(conns_.size());
   conn->GetMailbox()->SetAddr(name);
-  idle_conn_.emplace_back(conn);
-  conn_sz_++;
+  conn->GetMailbox()->SetAddrManager(addr_mgr_);
+  if (!ev_mgr_->Add(conn)) {
+    return nullptr;
+  }
+  if (!poller_->Add(conn)) {
+    LOG(ERROR) << "poller add " << name << " failed";
+    ev_mgr_->Del(conn);
+    return nullptr;
+  }
+  conns_.emplace_back(conn);
+  return conn;
 }
 
 std::shared_ptr<EventConn> EventConnManager::Alloc() {
-  std::lock_guard<std::mutex> g(mtx_);
-  // check has event conn
-  if (idle_conn_.empty()) {
-    AddEventConn();
+  if (tls_conn.mgr_id == id_) {
+    auto conn = tls_conn.conn.lock();
+    if (conn != nullptr && !conn->in_use_.exchange(true)) {
+      return conn;
+    }
   }
-  // remove from idle_conn
-  auto conn = idle_conn_.front();
-  idle_conn_.pop_front();
-  // add to run_conn
-  if (!ev_mgr_->Add(conn)) {
-    return nullptr;
+  std::shared_ptr<EventConn> conn = nullptr;
+  {
+    std::lock_guard<std::mutex> g(mtx_);
+    for (auto& it : conns_) {
+      if (!it->in_use_.exchange(true)) {
+        conn = it;
+        break;
+      }
+    }
+    // check has event conn
+    if (conn == nullptr) {
+      conn = AddEventConn();
+      if (conn == nullptr) {
+        return nullptr;
+      }
+      conn->in_use_.store(true);
+    }
   }
+  tls_conn.mgr_id = id_;
+  tls_conn.conn = conn;
   return conn;
 }
 
+// 主线程在回复之前已经取走连接的命令和发送队列(见 App::ProcessEventConn),
+// 请求线程收到回复后释放，连接可以立即被其它线程或者本线程复用
 void EventConnManager::Release(std::shared_ptr<EventConn> ev) {
-  // remove from run_conn
-  ev_mgr_->Del(ev);
-  // add to idle_conn
-  std::lock_guard<std::mutex> g(mtx_);
-  idle_conn_.emplace_back(ev);
+  ev->in_use_.store(false);
 }
 
 // call by main frame
@@ -75,12 +118,21 @@ void EventConnManager::Notify(
     LOG(ERROR) << "can't find handle " << h;
     return;
   }
-  if (ev->GetConnType() == EventConn::Type::kSend) {
+  if (ev->GetConnType() == EventConn::Type::kSend || ev->resp_size_ == 0) {
     LOG(WARNING) << "event " << ev->GetName() << " need't resp msg";
     return;
   }
+  // 之前请求的回复以及重复的回复不计入当前请求
+  if (!ev->AcceptResp(*msg)) {
+    LOG(WARNING) << "event " << ev->GetName() << " drop stale resp " << *msg;
+    return;
+  }
   // push msg to event_conn
   ev->GetMailbox()->Recv(msg);
+  // 批量请求收到所有回复后再通知
+  if (ev->resp_size_.fetch_sub(1) > 1) {
+    return;
+  }
   // send cmd to event_conn
   auto cmd_channel = ev->GetCmdChannel();
   cmd_channel->SendToOwner(CmdChannel::Cmd::kIdle);
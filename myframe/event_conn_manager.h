@@ -5,11 +5,10 @@ All rights reserved.
 Author: 李柯鹏 <likepeng0418@163.com>
 ****************************************************************************/
 #pragma once
-#include <list>
 #include <memory>
 #include <mutex>
-#include <unordered_map>
 #include <string>
+#include <vector>
 
 #include "myframe/macros.h"
 #include "myframe/event.h"
@@ -20,11 +19,19 @@ class Msg;
 class Poller;
 class EventManager;
 class EventConn;
+class AddrManager;
+/**
+ * 外部线程与框架通信的连接池
+ *
+ *  连接创建后一直注册在poller中，分配/释放时不调用epoll_ctl;
+ *  线程优先使用自己上次使用的连接(不加锁)，被占用时才从连接池中查找。
+ */
 class EventConnManager final {
  public:
   EventConnManager(
     std::shared_ptr<EventManager>,
-    std::shared_ptr<Poller>);
+    std::shared_ptr<Poller>,
+    std::shared_ptr<AddrManager>);
   virtual ~EventConnManager();
 
   bool Init(int sz = 2);
@@ -36,13 +43,16 @@ class EventConnManager final {
   void Notify(ev_handle_t, std::shared_ptr<Msg> msg);
 
  private:
-  void AddEventConn();
+  /* 创建并注册连接，调用者加锁 */
+  std::shared_ptr<EventConn> AddEventConn();
 
-  int conn_sz_{0};
+  /// 区分不同实例的线程缓存
+  uint64_t id_{0};
   std::mutex mtx_;
-  std::list<std::shared_ptr<EventConn>> idle_conn_;
+  std::vector<std::shared_ptr<EventConn>> conns_;
   std::shared_ptr<EventManager> ev_mgr_;
   std::shared_ptr<Poller> poller_;
+  std::shared_ptr<AddrManager> addr_mgr_;
 
   DISALLOW_COPY_AND_ASSIGN(EventConnManager)
 };
@@ -7,6 +7,8 @@ Author: 李柯鹏 <likepeng0418@163.com>
 #include "myframe/mailbox.h"
 #include "myframe/common.h"
 #include "myframe/msg.h"
+#include "myframe/addr_manager.h"
+#include "myframe/msg_pool.h"
 
 namespace myframe {
 
@@ -14,8 +16,29 @@ const std::string& Mailbox::Addr() const {
   return addr_;
 }
 
+addr_id_t Mailbox::AddrId() const {
+  return addr_id_;
+}
+
 void Mailbox::SetAddr(const std::string& addr) {
   addr_ = addr;
+  addr_id_ = Resolve(addr_);
+}
+
+void Mailbox::SetAddrManager(std::shared_ptr<AddrManager> addr_mgr) {
+  addr_mgr_ = addr_mgr;
+  addr_id_ = addr_.empty() ? INVALID_ADDR_ID : Resolve(addr_);
+}
+
+addr_id_t Mailbox::Resolve(const std::string& addr) {
+  if (addr_mgr_ == nullptr) {
+    return INVALID_ADDR_ID;
+  }
+  return addr_mgr_->Intern(addr);
+}
+
+std::shared_ptr<Msg> Mailbox::NewMsg() {
+  return MsgPool::Instance()->Get();
 }
 
 int Mailbox::SendSize() const {
@@ -38,14 +61,29 @@ void Mailbox::Send(
   const std::string& dst,
   std::shared_ptr<Msg> msg) {
   msg->SetSrc(addr_);
+  msg->SetSrcId(addr_id_);
   msg->SetDst(dst);
+  // 只查找已经存在的地址，未知地址交给框架转发，不分配句柄
+  msg->SetDstId(addr_mgr_ == nullptr ? INVALID_ADDR_ID : addr_mgr_->Find(dst));
+  Send(msg);
+}
+
+void Mailbox::Send(
+  addr_id_t dst,
+  std::shared_ptr<Msg> msg) {
+  msg->SetSrc(addr_);
+  msg->SetSrcId(addr_id_);
+  if (addr_mgr_ != nullptr) {
+    msg->SetDst(addr_mgr_->GetAddr(dst));
+  }
+  msg->SetDstId(dst);
   Send(msg);
 }
 
 void Mailbox::Send(
   const std::string& dst,
   const std::any& data) {
-  auto msg = std::make_shared<Msg>();
+  auto msg = NewMsg();
   msg->SetAnyData(data);
   Send(dst, msg);
 }
@@ -54,41 +92,90 @@ void Mailbox::Send(std::list<std::shared_ptr<Msg>>* msg_list) {
   Common::ListAppend(&send_, msg_list);
 }
 
+void Mailbox::Reply(
+  const std::shared_ptr<const Msg>& req,
+  std::shared_ptr<Msg> resp) {
+  resp->SetCorrelationId(req->GetCorrelationId());
+  resp->SetReply(req->GetCorrelationId() != 0);
+  if (req->GetSrcId() != INVALID_ADDR_ID) {
+    Send(req->GetSrcId(), std::move(resp));
+  } else {
+    Send(req->GetSrc(), std::move(resp));
+  }
+}
+
 std::list<std::shared_ptr<Msg>>* Mailbox::GetSendList() {
   return &send_;
 }
 
 int Mailbox::RecvSize() const {
-  return recv_.size();
+  std::size_t size = 0;
+  for (const auto& lane : recv_) {
+    size += lane.size();
+  }
+  return size;
 }
 
 bool Mailbox::RecvEmpty() const {
-  return recv_.empty();
+  for (const auto& lane : recv_) {
+    if (!lane.empty()) {
+      return false;
+    }
+  }
+  return true;
 }
 
 void Mailbox::RecvClear() {
-  recv_.clear();
+  for (auto& lane : recv_) {
+    lane.clear();
+  }
 }
 
 void Mailbox::Recv(std::shared_ptr<Msg> msg) {
-  recv_.emplace_back(msg);
+  auto& lane = recv_[static_cast<std::size_t>(msg->GetPriority())];
+  lane.emplace_back(std::move(msg));
 }
 
+// 逐个移动链表节点到对应通道，不复制消息
 void Mailbox::Recv(std::list<std::shared_ptr<Msg>>* msg_list) {
-  Common::ListAppend(&recv_, msg_list);
+  while (!msg_list->empty()) {
+    auto& lane = recv_[
+      static_cast<std::size_t>(msg_list->front()->GetPriority())];
+    lane.splice(lane.end(), *msg_list, msg_list->begin());
+  }
+}
+
+void Mailbox::Recv(Mailbox* from) {
+  for (std::size_t i = 0; i < Msg::kPriorityLevels; ++i) {
+    recv_[i].splice(recv_[i].end(), from->recv_[i]);
+  }
 }
 
 const std::shared_ptr<const Msg> Mailbox::PopRecv() {
-  if (recv_.empty()) {
-    return nullptr;
+  for (std::size_t i = Msg::kPriorityLevels; i > 0; --i) {
+    auto& lane = recv_[i - 1];
+    if (lane.empty()) {
+      continue;
+    }
+    auto msg = std::move(lane.front());
+    lane.pop_front();
+    return msg;
+  }
+  return nullptr;
+}
+
+bool Mailbox::DropRecv() {
+  for (auto& lane : recv_) {
+    if (!lane.empty()) {
+      lane.pop_front();
+      return true;
+    }
   }
-  auto msg = recv_.front();
-  recv_.pop_front();
-  return msg;
+  return false;
 }
 
-std::list<std::shared_ptr<Msg>>* Mailbox::GetRecvList() {
-  return &recv_;
+bool Mailbox::HasHighRecv() const {
+  return !recv_[static_cast<std::size_t>(Msg::Priority::kHigh)].empty();
 }
 
 std::ostream& operator<<(std::ostream& out, const Mailbox& mailbox) {
@@ -11,19 +11,38 @@ Author: 李柯鹏 <likepeng0418@163.com>
 #include <any>
 
 #include "myframe/export.h"
+#include "myframe/msg.h"
 
 namespace myframe {
 
-class Msg;
+class AddrManager;
 class MYFRAME_EXPORT Mailbox final {
   friend class ActorContext;
   friend class WorkerContext;
   friend class EventConnManager;
+  friend class DispatchShard;
   friend class App;
 
  public:
   /// 邮箱地址
   const std::string& Addr() const;
+  addr_id_t AddrId() const;
+
+  /**
+   * @brief 将地址解析为地址句柄
+   * @note 地址不必已经存在，句柄在程序运行期间保持不变，
+   * 可以在Init()中解析后保存，在Proc()中重复使用
+   * @return addr_id_t 失败返回 INVALID_ADDR_ID
+   */
+  addr_id_t Resolve(const std::string& addr);
+
+  /**
+   * @brief 从消息池获得一个空消息
+   * @note 消息引用计数为0时自动归还到消息池，
+   * 频繁发送消息时使用该函数代替 std::make_shared<Msg>()
+   * @return std::shared_ptr<Msg> 消息
+   */
+  std::shared_ptr<Msg> NewMsg();
 
   /// 发件箱(适用于worker/actor)
   int SendSize() const;
@@ -36,9 +55,20 @@ class MYFRAME_EXPORT Mailbox final {
   void Send(
     const std::string& dst,
     const std::any& data);
+  void Send(
+    addr_id_t dst,
+    std::shared_ptr<Msg> msg);
   void Send(std::list<std::shared_ptr<Msg>>* msg_list);
+  /**
+   * @brief 回复请求
+   * @note 回复消息带上请求的关联ID发给请求的源地址，
+   * Actor::Request() 发送的请求由请求者的回调处理回复
+   */
+  void Reply(
+    const std::shared_ptr<const Msg>& req,
+    std::shared_ptr<Msg> resp);
 
-  /// 收件箱(适用于worker)
+  /// 收件箱(适用于worker)，按消息优先级分通道，PopRecv()先取高优先级消息
   int RecvSize() const;
   bool RecvEmpty() const;
   void RecvClear();
@@ -49,12 +79,21 @@ class MYFRAME_EXPORT Mailbox final {
  private:
   /// 设置邮箱地址
   void SetAddr(const std::string& addr);
+  /// 设置地址管理对象，用于地址解析
+  void SetAddrManager(std::shared_ptr<AddrManager> addr_mgr);
 
   std::list<std::shared_ptr<Msg>>* GetSendList();
-  std::list<std::shared_ptr<Msg>>* GetRecvList();
+  /* 按通道取走from收件箱中的所有消息 */
+  void Recv(Mailbox* from);
+  /* 丢弃最低优先级通道中最早的消息 */
+  bool DropRecv();
+  /* 收件箱中是否有高优先级的消息 */
+  bool HasHighRecv() const;
 
   std::string addr_;
-  std::list<std::shared_ptr<Msg>> recv_;
+  addr_id_t addr_id_{INVALID_ADDR_ID};
+  std::shared_ptr<AddrManager> addr_mgr_{nullptr};
+  std::list<std::shared_ptr<Msg>> recv_[Msg::kPriorityLevels];
   std::list<std::shared_ptr<Msg>> send_;
 };
 
@@ -0,0 +1,135 @@
+/****************************************************************************
+Copyright (c) 2019, 李柯鹏
+All rights reserved.
+
+Author: 李柯鹏 <likepeng0418@163.com>
+****************************************************************************/
+
+#include "myframe/mailbox_limit.h"
+
+#include "myframe/log.h"
+#include "myframe/msg_pool.h"
+#include "myframe/actor_context.h"
+
+namespace myframe {
+
+MailboxLimit::~MailboxLimit() {
+  // 收件箱销毁后不会再有消费，恢复暂停的发送者
+  UnmuteAll();
+}
+
+bool MailboxLimit::ParsePolicy(const std::string& name, Policy* policy) {
+  if (name == "drop_newest") {
+    *policy = Policy::kDropNewest;
+  } else if (name == "drop_oldest") {
+    *policy = Policy::kDropOldest;
+  } else if (name == "reject") {
+    *policy = Policy::kReject;
+  } else if (name == "credit") {
+    *policy = Policy::kCredit;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+std::shared_ptr<Msg> MailboxLimit::MakeReject(
+    const Msg& msg, const std::string& addr) {
+  auto reject = MsgPool::Instance()->Get();
+  reject->SetSrc(addr);
+  reject->SetDst(msg.GetSrc());
+  reject->SetType(MSG_TYPE_REJECT);
+  reject->SetPriority(Msg::Priority::kHigh);
+  reject->SetDesc(msg.GetDesc());
+  reject->SetBuffer(msg.GetBuffer());
+  return reject;
+}
+
+bool MailboxLimit::Init(const std::string& name, const Json::Value& config) {
+  if (!config.isObject()) {
+    return true;
+  }
+  // 收件箱容量, instance_config: {"mailbox_capacity": 1000}
+  auto capacity = capacity_;
+  if (config.isMember("mailbox_capacity")) {
+    if (!config["mailbox_capacity"].isInt()
+        || config["mailbox_capacity"].asInt() < 0) {
+      LOG(WARNING) << name << " invalid mailbox_capacity, use " << capacity_;
+      return false;
+    }
+    capacity = config["mailbox_capacity"].asInt();
+  }
+  // 收件箱满时的策略, instance_config: {"mailbox_policy": "drop_newest"}
+  auto policy = policy_;
+  if (config.isMember("mailbox_policy")
+      && (!config["mailbox_policy"].isString()
+        || !ParsePolicy(config["mailbox_policy"].asString(), &policy))) {
+    LOG(WARNING) << name << " unknown mailbox_policy "
+      << config["mailbox_policy"].toStyledString();
+    return false;
+  }
+  capacity_ = capacity;
+  policy_ = policy;
+  LOG_IF(INFO, IsBounded()) << name << " mailbox " << *this;
+  return true;
+}
+
+MailboxLimit::Result MailboxLimit::Check(std::size_t size) {
+  if (size < capacity_ || !IsBounded()) {
+    return Result::kAccept;
+  }
+  switch (policy_) {
+    case Policy::kDropOldest:
+      drop_oldest_cnt_.fetch_add(1, std::memory_order_relaxed);
+      return Result::kDropOldest;
+    case Policy::kReject:
+      reject_cnt_.fetch_add(1, std::memory_order_relaxed);
+      return Result::kReject;
+    case Policy::kCredit:
+      return Result::kThrottle;
+    default:
+      drop_newest_cnt_.fetch_add(1, std::memory_order_relaxed);
+      return Result::kDropNewest;
+  }
+}
+
+// 暂停与记录在同一个锁内完成，避免与UnmuteAll()交错时漏掉恢复
+bool MailboxLimit::Mute(std::shared_ptr<ActorContext> ctx) {
+  std::lock_guard<std::mutex> lk(muted_mtx_);
+  if (!ctx->Mute()) {
+    return false;
+  }
+  throttle_cnt_.fetch_add(1, std::memory_order_relaxed);
+  muted_.emplace_back(ctx);
+  has_muted_.store(true);
+  return true;
+}
+
+void MailboxLimit::UnmuteAll() {
+  std::vector<std::weak_ptr<ActorContext>> muted;
+  {
+    std::lock_guard<std::mutex> lk(muted_mtx_);
+    muted.swap(muted_);
+    has_muted_.store(false);
+  }
+  for (auto& it : muted) {
+    auto ctx = it.lock();
+    if (ctx != nullptr) {
+      ctx->Unmute();
+    }
+  }
+}
+
+std::ostream& operator<<(std::ostream& out, const MailboxLimit& limit) {
+  static const char* policy_name[] = {
+    "drop_newest", "drop_oldest", "reject", "credit"};
+  out << "capacity: " << limit.GetCapacity()
+    << ", policy: " << policy_name[static_cast<int>(limit.GetPolicy())]
+    << ", drop newest: " << limit.DropNewestCount()
+    << ", drop oldest: " << limit.DropOldestCount()
+    << ", reject: " << limit.RejectCount()
+    << ", throttle: " << limit.ThrottleCount();
+  return out;
+}
+
+}  // namespace myframe
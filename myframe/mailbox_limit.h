@@ -0,0 +1,103 @@
+/****************************************************************************
+Copyright (c) 2019, 李柯鹏
+All rights reserved.
+
+Author: 李柯鹏 <likepeng0418@163.com>
+****************************************************************************/
+#pragma once
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <json/json.h>
+
+#include "myframe/macros.h"
+#include "myframe/msg.h"
+
+namespace myframe {
+
+class ActorContext;
+/**
+ * 收件箱容量限制
+ *
+ *  instance_config:
+ *    {"mailbox_capacity": 1000, "mailbox_policy": "drop_newest"}
+ *  mailbox_capacity 为0(默认)时不限制;
+ *  收件箱中未处理的消息数达到容量后按策略处理新消息:
+ *    drop_newest: 丢弃新消息(默认)
+ *    drop_oldest: 丢弃收件箱中最早的消息，再投递新消息
+ *    reject: 丢弃新消息，并给发送者回复 MSG_TYPE_REJECT 消息
+ *    credit: 投递新消息，但暂停调度发送消息的actor,
+ *            直到收件箱中的消息数降到容量的一半
+ *  容量检查与投递之间没有加锁，多个线程同时投递时容量是近似值。
+ */
+class MailboxLimit final {
+ public:
+  enum class Policy : int {
+    kDropNewest,
+    kDropOldest,
+    kReject,
+    kCredit,
+  };
+  enum class Result : int {
+    kAccept,      ///< 投递
+    kDropNewest,  ///< 丢弃新消息
+    kDropOldest,  ///< 丢弃最早的消息后投递
+    kReject,      ///< 丢弃新消息并回复发送者
+    kThrottle,    ///< 投递并暂停发送者
+  };
+
+  MailboxLimit() = default;
+  ~MailboxLimit();
+
+  static bool ParsePolicy(const std::string& name, Policy* policy);
+  /* 生成回复给发送者的拒绝消息, addr为拒绝的地址 */
+  static std::shared_ptr<Msg> MakeReject(
+    const Msg& msg, const std::string& addr);
+
+  /* 从instance_config读取配置，配置错误时返回false并保持原配置 */
+  bool Init(const std::string& name, const Json::Value& config);
+
+  bool IsBounded() const { return capacity_ > 0; }
+  std::size_t GetCapacity() const { return capacity_; }
+  Policy GetPolicy() const { return policy_; }
+  /* 暂停的发送者在消息数降到该值时恢复 */
+  std::size_t GetLowWatermark() const { return capacity_ / 2; }
+
+  /* 收件箱中有size条消息时，检查新消息的处理方式 */
+  Result Check(std::size_t size);
+
+  /// credit策略暂停的发送者
+  /* 暂停发送者并记录，发送者已经暂停时返回false */
+  bool Mute(std::shared_ptr<ActorContext> ctx);
+  bool HasMuted() const { return has_muted_.load(); }
+  /* 恢复所有暂停的发送者 */
+  void UnmuteAll();
+
+  /// 统计
+  uint64_t DropNewestCount() const { return drop_newest_cnt_.load(); }
+  uint64_t DropOldestCount() const { return drop_oldest_cnt_.load(); }
+  uint64_t RejectCount() const { return reject_cnt_.load(); }
+  uint64_t ThrottleCount() const { return throttle_cnt_.load(); }
+
+ private:
+  std::size_t capacity_{0};
+  Policy policy_{Policy::kDropNewest};
+
+  std::mutex muted_mtx_;
+  std::vector<std::weak_ptr<ActorContext>> muted_;
+  std::atomic_bool has_muted_{false};
+
+  std::atomic<uint64_t> drop_newest_cnt_{0};
+  std::atomic<uint64_t> drop_oldest_cnt_{0};
+  std::atomic<uint64_t> reject_cnt_{0};
+  std::atomic<uint64_t> throttle_cnt_{0};
+
+  DISALLOW_COPY_AND_ASSIGN(MailboxLimit)
+};
+
+std::ostream& operator<<(std::ostream& out, const MailboxLimit& limit);
+
+}  // namespace myframe
@@ -0,0 +1,133 @@
+/****************************************************************************
+Copyright (c) 2019, 李柯鹏
+All rights reserved.
+
+Author: 李柯鹏 <likepeng0418@163.com>
+****************************************************************************/
+
+#include "myframe/metrics.h"
+
+#include <algorithm>
+#include <string>
+
+namespace myframe {
+
+namespace {
+/// 线程使用的计数器分片
+std::atomic<std::size_t> shard_index_gen{0};
+thread_local std::size_t tls_shard_index =
+  shard_index_gen.fetch_add(1, std::memory_order_relaxed);
+
+double Ratio(uint64_t part, uint64_t total) {
+  if (total == 0) {
+    return 0;
+  }
+  return std::min(1.0, static_cast<double>(part) / total);
+}
+}  // namespace
+
+/// ShardedCounter
+std::size_t ShardedCounter::ShardIndex() {
+  return tls_shard_index % kShards;
+}
+
+uint64_t ShardedCounter::Value() const {
+  uint64_t sum = 0;
+  for (std::size_t i = 0; i < kShards; ++i) {
+    sum += shards_[i].value.load(std::memory_order_relaxed);
+  }
+  return sum;
+}
+
+/// LatencyHistogram
+void LatencyHistogram::Record(std::chrono::nanoseconds cost) {
+  auto us = static_cast<uint64_t>(
+    std::chrono::duration_cast<std::chrono::microseconds>(cost).count());
+  std::size_t i = 0;
+  while (i < kBuckets - 1 && us >= BucketBound(i)) {
+    ++i;
+  }
+  buckets_[i].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+  total_us_.fetch_add(us, std::memory_order_relaxed);
+  if (us > max_us_.load(std::memory_order_relaxed)) {
+    max_us_.store(us, std::memory_order_relaxed);
+  }
+}
+
+uint64_t LatencyHistogram::PercentileUs(double p) const {
+  uint64_t counts[kBuckets];
+  uint64_t total = 0;
+  for (std::size_t i = 0; i < kBuckets; ++i) {
+    counts[i] = buckets_[i].load(std::memory_order_relaxed);
+    total += counts[i];
+  }
+  if (total == 0) {
+    return 0;
+  }
+  auto target = static_cast<uint64_t>(p * total);
+  uint64_t sum = 0;
+  for (std::size_t i = 0; i < kBuckets - 1; ++i) {
+    sum += counts[i];
+    if (sum > target) {
+      return BucketBound(i);
+    }
+  }
+  return MaxUs();
+}
+
+void LatencyHistogram::ToJson(Json::Value* out) const {
+  auto count = Count();
+  auto total = TotalUs();
+  (*out)["count"] = Json::UInt64(count);
+  (*out)["total_us"] = Json::UInt64(total);
+  (*out)["avg_us"] = Json::UInt64(count ? total / count : 0);
+  (*out)["max_us"] = Json::UInt64(MaxUs());
+  (*out)["p50_us"] = Json::UInt64(PercentileUs(0.5));
+  (*out)["p99_us"] = Json::UInt64(PercentileUs(0.99));
+  Json::Value hist(Json::objectValue);
+  for (std::size_t i = 0; i < kBuckets; ++i) {
+    auto n = buckets_[i].load(std::memory_order_relaxed);
+    if (n == 0) {
+      continue;
+    }
+    auto name = i < kBuckets - 1
+      ? "<" + std::to_string(BucketBound(i))
+      : ">=" + std::to_string(BucketBound(i - 1));
+    hist[name] = Json::UInt64(n);
+  }
+  (*out)["hist"] = hist;
+}
+
+/// ActorMetrics
+void ActorMetrics::OnProc(
+    std::size_t msg_in,
+    std::size_t msg_out,
+    std::chrono::nanoseconds cost) {
+  msg_in_.fetch_add(msg_in, std::memory_order_relaxed);
+  msg_out_.fetch_add(msg_out, std::memory_order_relaxed);
+  proc_time_.Record(cost);
+}
+
+/// WorkerMetrics
+WorkerMetrics::WorkerMetrics()
+  : start_tp_(Clock::now())
+  , last_tp_(start_tp_) {
+}
+
+void WorkerMetrics::ToJson(Json::Value* out) {
+  auto now = Clock::now();
+  auto busy_ns = busy_ns_.load(std::memory_order_relaxed);
+  auto uptime_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    now - start_tp_).count();
+  auto recent_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    now - last_tp_).count();
+  (*out)["proc_count"] = Json::UInt64(proc_cnt_.load());
+  (*out)["busy_ms"] = Json::UInt64(busy_ns / 1000000);
+  (*out)["busy_ratio"] = Ratio(busy_ns, uptime_ns);
+  (*out)["recent_busy_ratio"] = Ratio(busy_ns - last_busy_ns_, recent_ns);
+  last_tp_ = now;
+  last_busy_ns_ = busy_ns;
+}
+
+}  // namespace myframe
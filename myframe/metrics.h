@@ -0,0 +1,160 @@
+/****************************************************************************
+Copyright (c) 2019, 李柯鹏
+All rights reserved.
+
+Author: 李柯鹏 <likepeng0418@163.com>
+****************************************************************************/
+#pragma once
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>
+
+#include <json/json.h>
+
+#include "myframe/macros.h"
+
+namespace myframe {
+
+/**
+ * 按线程分片的计数器
+ *
+ *  每个线程固定写一个分片(按线程创建顺序轮流分配)，
+ *  多个线程同时计数时不会竞争同一个缓存行;
+ *  Value() 汇总所有分片，是近似值。
+ */
+class ShardedCounter final {
+ public:
+  static constexpr std::size_t kShards = 16;
+
+  ShardedCounter() = default;
+
+  void Add(uint64_t n = 1) {
+    shards_[ShardIndex()].value.fetch_add(n, std::memory_order_relaxed);
+  }
+  uint64_t Value() const;
+
+ private:
+  static std::size_t ShardIndex();
+
+  struct alignas(64) Shard {
+    std::atomic<uint64_t> value{0};
+  };
+  Shard shards_[kShards];
+
+  DISALLOW_COPY_AND_ASSIGN(ShardedCounter)
+};
+
+/**
+ * 耗时直方图
+ *
+ *  按2的幂划分桶(单位us): [0,1) [1,2) [2,4) ... [2^(kBuckets-2), +inf)
+ *  分位数按桶的上界估算。
+ */
+class LatencyHistogram final {
+ public:
+  static constexpr std::size_t kBuckets = 24;
+
+  LatencyHistogram() = default;
+
+  void Record(std::chrono::nanoseconds cost);
+
+  uint64_t Count() const { return count_.load(std::memory_order_relaxed); }
+  uint64_t TotalUs() const { return total_us_.load(std::memory_order_relaxed); }
+  uint64_t MaxUs() const { return max_us_.load(std::memory_order_relaxed); }
+  /* p: 0~1 */
+  uint64_t PercentileUs(double p) const;
+
+  /* {"count","total_us","avg_us","max_us","p50_us","p99_us",
+   *  "hist":{"<1":n,"<2":n,...}}, 只输出非0的桶 */
+  void ToJson(Json::Value* out) const;
+
+ private:
+  /* 第i个桶的上界(us) */
+  static uint64_t BucketBound(std::size_t i) { return 1ULL << i; }
+
+  std::atomic<uint64_t> buckets_[kBuckets] = {};
+  std::atomic<uint64_t> count_{0};
+  std::atomic<uint64_t> total_us_{0};
+  std::atomic<uint64_t> max_us_{0};
+
+  DISALLOW_COPY_AND_ASSIGN(LatencyHistogram)
+};
+
+/**
+ * actor运行指标
+ *
+ *  OnProc() 只在处理该actor的线程中调用(同一时刻只有一个线程);
+ *  收件箱深度由投递消息的线程更新，是近似值。
+ */
+class ActorMetrics final {
+ public:
+  ActorMetrics() = default;
+
+  /* 处理一批消息后调用 */
+  void OnProc(
+    std::size_t msg_in,
+    std::size_t msg_out,
+    std::chrono::nanoseconds cost);
+  /* 收件箱中等待处理的消息数 */
+  void SetDepth(std::size_t depth) {
+    depth_.store(depth, std::memory_order_relaxed);
+    UpdateMaxDepth(depth);
+  }
+  void UpdateMaxDepth(std::size_t depth) {
+    if (depth > max_depth_.load(std::memory_order_relaxed)) {
+      max_depth_.store(depth, std::memory_order_relaxed);
+    }
+  }
+
+  uint64_t MsgIn() const { return msg_in_.load(std::memory_order_relaxed); }
+  uint64_t MsgOut() const { return msg_out_.load(std::memory_order_relaxed); }
+  std::size_t Depth() const { return depth_.load(std::memory_order_relaxed); }
+  std::size_t MaxDepth() const {
+    return max_depth_.load(std::memory_order_relaxed);
+  }
+  const LatencyHistogram& ProcTime() const { return proc_time_; }
+
+ private:
+  std::atomic<uint64_t> msg_in_{0};
+  std::atomic<uint64_t> msg_out_{0};
+  std::atomic<std::size_t> depth_{0};
+  std::atomic<std::size_t> max_depth_{0};
+  /// 每次调度处理一批消息的耗时
+  LatencyHistogram proc_time_;
+
+  DISALLOW_COPY_AND_ASSIGN(ActorMetrics)
+};
+
+/**
+ * 工作线程运行指标
+ *
+ *  OnBusy() 只在该工作线程中调用;
+ *  ToJson() 由获取快照的线程调用，同时计算距上次快照的忙碌比例。
+ */
+class WorkerMetrics final {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  WorkerMetrics();
+
+  void OnBusy(std::chrono::nanoseconds cost) {
+    busy_ns_.fetch_add(cost.count(), std::memory_order_relaxed);
+    proc_cnt_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /* {"proc_count","busy_ms","busy_ratio","recent_busy_ratio"} */
+  void ToJson(Json::Value* out);
+
+ private:
+  Clock::time_point start_tp_;
+  std::atomic<uint64_t> busy_ns_{0};
+  std::atomic<uint64_t> proc_cnt_{0};
+  /// 上次快照
+  Clock::time_point last_tp_;
+  uint64_t last_busy_ns_{0};
+
+  DISALLOW_COPY_AND_ASSIGN(WorkerMetrics)
+};
+
+}  // namespace myframe
@@ -0,0 +1,74 @@
+/****************************************************************************
+Copyright (c) 2019, 李柯鹏
+All rights reserved.
+
+Author: 李柯鹏 <likepeng0418@163.com>
+****************************************************************************/
+#pragma once
+#include <atomic>
+#include <utility>
+
+#include "myframe/macros.h"
+
+namespace myframe {
+
+/**
+ * 无锁多生产者单消费者队列
+ *
+ *  Push() 可以在任意线程调用;
+ *  Pop() 只能在一个消费线程中调用。
+ */
+template <typename T>
+class MpscQueue final {
+ public:
+  MpscQueue() {
+    auto stub = new Node();
+    head_.store(stub, std::memory_order_relaxed);
+    tail_ = stub;
+  }
+
+  ~MpscQueue() {
+    T data;
+    while (Pop(&data)) {}
+    delete tail_;
+  }
+
+  void Push(T data) {
+    auto node = new Node(std::move(data));
+    auto prev = head_.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+  }
+
+  bool Pop(T* data) {
+    auto tail = tail_;
+    auto next = tail->next.load(std::memory_order_acquire);
+    if (next == nullptr) {
+      return false;
+    }
+    *data = std::move(next->data);
+    tail_ = next;
+    delete tail;
+    return true;
+  }
+
+  /* 只能在消费线程中调用，正在入队(还没有链接好)的元素也算在内 */
+  bool Empty() const {
+    return tail_->next.load(std::memory_order_acquire) == nullptr
+      && head_.load(std::memory_order_acquire) == tail_;
+  }
+
+ private:
+  struct Node {
+    Node() = default;
+    explicit Node(T&& d) : data(std::move(d)) {}
+    std::atomic<Node*> next{nullptr};
+    T data;
+  };
+
+  std::atomic<Node*> head_{nullptr};
+  Node* tail_{nullptr};
+
+  DISALLOW_COPY_AND_ASSIGN(MpscQueue)
+};
+
+}  // namespace myframe
@@ -23,17 +23,88 @@ Msg::Msg(const std::string& data) {
   SetData(data);
 }
 
+Msg::Msg(std::string&& data) {
+  SetData(std::move(data));
+}
+
+Msg::Msg(const Buffer& data) {
+  SetBuffer(data);
+}
+
+const std::string& Msg::GetData() const {
+  static const std::string empty;
+  auto str = data_.AsString();
+  if (str != nullptr) {
+    return *str;
+  }
+  if (data_.Empty()) {
+    return empty;
+  }
+  auto cache = std::atomic_load(&data_str_);
+  if (cache == nullptr) {
+    auto s = std::make_shared<const std::string>(data_.ToString());
+    if (std::atomic_compare_exchange_strong(&data_str_, &cache, s)) {
+      cache = s;
+    }
+  }
+  return *cache;
+}
+
+// 数据字符串没有被其它消息共享时复用，否则重新分配
 void Msg::SetData(const char* data, unsigned int len) {
-  data_.clear();
-  data_.append(data, len);
+  data_ = Buffer();
+  data_str_.reset();
+  if (own_data_ == nullptr || own_data_.use_count() != 1) {
+    own_data_ = std::make_shared<std::string>();
+  }
+  own_data_->assign(data, len);
+  data_ = Buffer(std::shared_ptr<const std::string>(own_data_));
 }
 void Msg::SetData(const std::string& data) {
   SetData(data.data(), data.size());
 }
+void Msg::SetData(std::string&& data) {
+  data_ = Buffer();
+  data_str_.reset();
+  if (own_data_ == nullptr || own_data_.use_count() != 1) {
+    own_data_ = std::make_shared<std::string>(std::move(data));
+  } else {
+    *own_data_ = std::move(data);
+  }
+  data_ = Buffer(std::shared_ptr<const std::string>(own_data_));
+}
+void Msg::SetBuffer(const Buffer& data) {
+  data_ = data;
+  data_str_.reset();
+}
 void Msg::SetAnyData(const std::any& any_data) {
   any_data_ = any_data;
 }
 
+void Msg::Reset() {
+  // 过大的数据缓存不保留
+  static const std::size_t kMaxKeepDataCapacity = 16 * 1024;
+  src_id_ = INVALID_ADDR_ID;
+  dst_id_ = INVALID_ADDR_ID;
+  priority_ = Priority::kNormal;
+  reply_ = false;
+  corr_id_ = 0;
+  src_.clear();
+  dst_.clear();
+  type_.clear();
+  desc_.clear();
+  data_ = Buffer();
+  data_str_.reset();
+  if (own_data_ != nullptr
+      && (own_data_.use_count() != 1
+        || own_data_->capacity() > kMaxKeepDataCapacity)) {
+    own_data_.reset();
+  } else if (own_data_ != nullptr) {
+    own_data_->clear();
+  }
+  any_data_.reset();
+}
+
 std::ostream& operator<<(std::ostream& out, const Msg& msg) {
   out << "[" << msg.GetSrc() << " to "
     << msg.GetDst() << "](" << msg.GetType() << ")";
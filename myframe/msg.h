@@ -6,17 +6,38 @@ Author: 李柯鹏 <likepeng0418@163.com>
 ****************************************************************************/
 
 #pragma once
+#include <stdint.h>
+
+#include <atomic>
 #include <iostream>
 #include <any>
+#include <memory>
 #include <string>
 
 #include "myframe/export.h"
+#include "myframe/buffer.h"
 
 namespace myframe {
 
 /* 发送给框架的地址 */
 const char* const MAIN_ADDR = "main";
 
+/**
+ * 地址句柄
+ *  通过 Mailbox::Resolve() 将字符串地址转换为地址句柄,
+ *  使用 Mailbox::Send(addr_id_t, msg) 发送消息可以省去框架分发时的地址解析
+ */
+typedef uint32_t addr_id_t;
+const addr_id_t INVALID_ADDR_ID = 0;
+
+/**
+ * 定时器句柄
+ *  由 Actor::Timeout() 返回，用于O(1)取消或者重新设置定时器，
+ *  定时器超时(非周期)或者取消后句柄失效
+ */
+typedef uint64_t timer_handle_t;
+const timer_handle_t INVALID_TIMER_HANDLE = 0;
+
 /**
  * 发送给框架的命令
  * 发送示例:
@@ -29,13 +50,72 @@ const char* const MAIN_ADDR = "main";
  *  格式为 地址1\n地址2\n地址3
  */
 const char* const MAIN_CMD_ALL_USER_MOD_ADDR = "kAllUserModAddr";
+/**
+ * MAIN_CMD_METRICS:
+ *  返回框架运行指标快照(JSON)
+ *  通过msg->GetData()获得，包括:
+ *    main: 分发消息数/速率，外部发送消息数，地址句柄数
+ *    actors: 每个actor收发消息数、收件箱深度、处理耗时直方图
+ *    workers: 每个工作线程处理次数、忙碌比例
+ *  也可以在框架外使用 App::SendRequest(MAIN_ADDR, msg) 获取
+ */
+const char* const MAIN_CMD_METRICS = "kMetrics";
+
+/**
+ * 收件箱已满被拒绝的消息类型
+ *  目的地址配置了 "mailbox_policy": "reject" 且收件箱已满时,
+ *  发送者会收到该类型的消息: 源地址为拒绝的地址，desc和数据与原消息相同
+ */
+const char* const MSG_TYPE_REJECT = "REJECT";
+
+class Msg;
+/**
+ * 无锁消息队列节点
+ *  嵌入在Msg中，入队时不需要额外分配内存;
+ *  复制消息时不复制节点
+ */
+struct MsgNode {
+  MsgNode() = default;
+  MsgNode(const MsgNode&) {}
+  MsgNode& operator=(const MsgNode&) { return *this; }
+
+  std::atomic<MsgNode*> next{nullptr};
+  std::shared_ptr<Msg> msg{nullptr};
+  /* 嵌入节点是否已在队列中 */
+  std::atomic_bool in_use{false};
+  /* 是否是单独分配的节点 */
+  bool alloc{false};
+};
 
 class MYFRAME_EXPORT Msg final {
+  friend class Mailbox;
+  friend class MpscMsgQueue;
+  friend class MsgPool;
+  friend class App;
+  friend class ActorContext;
+  friend class TimerManager;
+  friend class EventConn;
+
  public:
   Msg() = default;
   Msg(const char* data);
   Msg(const char* data, int len);
   Msg(const std::string& data);
+  Msg(std::string&& data);
+  explicit Msg(const Buffer& data);
+
+  /**
+   * 消息优先级
+   *  收件箱按优先级分通道，高优先级的消息先处理，
+   *  收到高优先级消息的actor优先调度。
+   *  框架的控制消息(定时器/订阅/框架回复/拒绝)使用kHigh
+   */
+  enum class Priority : uint8_t {
+    kNormal = 0,
+    kHigh = 1,
+  };
+  /* 优先级通道数 */
+  static const std::size_t kPriorityLevels = 2;
 
   /**
    * @brief 获得消息源地址
@@ -45,6 +125,15 @@ class MYFRAME_EXPORT Msg final {
   const std::string& GetSrc() const { return src_; }
   const std::string& GetDst() const { return dst_; }
 
+  /**
+   * @brief 获得消息源/目的地址句柄
+   * @note 由框架填充，未解析时为 INVALID_ADDR_ID
+   * 回复消息时可以使用 mailbox->Send(msg->GetSrcId(), resp)
+   * @return addr_id_t 地址句柄
+   */
+  addr_id_t GetSrcId() const { return src_id_; }
+  addr_id_t GetDstId() const { return dst_id_; }
+
   /**
    * @brief 消息类型
    * @note 目前使用到的 "TEXT", "TIMER";
@@ -61,32 +150,89 @@ class MYFRAME_EXPORT Msg final {
    */
   const std::string& GetDesc() const { return desc_; }
 
+  /**
+   * @brief 消息优先级
+   * @note 默认 Priority::kNormal
+   * @return Priority 优先级
+   */
+  Priority GetPriority() const { return priority_; }
+
+  /**
+   * @brief 请求/回复的关联ID
+   * @note Actor::Request() 发送的请求及 Mailbox::Reply() 的回复由框架填充;
+   * 独立定时器(见 Actor::Timeout())的超时消息为定时器句柄;
+   * 其它消息为0
+   * @return uint64_t 关联ID
+   */
+  uint64_t GetCorrelationId() const { return corr_id_; }
+  /**
+   * @brief 是否是 Mailbox::Reply() 回复的消息
+   * @note 回复消息由请求者的回调处理，不会传给Proc()
+   */
+  bool IsReply() const { return reply_; }
+
   /**
    * @brief 数据
+   * @note 数据是子切片或者外部内存时，第一次调用会复制一份数据
    *
    * @return const std::string& 数据
    */
-  const std::string& GetData() const { return data_; }
+  const std::string& GetData() const;
+  /**
+   * @brief 数据缓冲区
+   * @note 转发/广播消息时使用 SetBuffer(msg->GetBuffer()) 共享数据，不复制
+   *
+   * @return const Buffer& 数据缓冲区
+   */
+  const Buffer& GetBuffer() const { return data_; }
   template <typename T>
   const T GetAnyData() const {
     return std::any_cast<T>(any_data_);
   }
 
-  void SetSrc(const std::string& src) { src_ = src; }
-  void SetDst(const std::string& dst) { dst_ = dst; }
+  void SetSrc(const std::string& src) {
+    src_ = src;
+    src_id_ = INVALID_ADDR_ID;
+  }
+  void SetDst(const std::string& dst) {
+    dst_ = dst;
+    dst_id_ = INVALID_ADDR_ID;
+  }
   void SetType(const std::string& type) { type_ = type; }
   void SetDesc(const std::string& desc) { desc_ = desc; }
+  void SetPriority(Priority priority) { priority_ = priority; }
   void SetData(const char* data, unsigned int len);
   void SetData(const std::string& data);
+  /* 接管字符串，不复制数据 */
+  void SetData(std::string&& data);
+  /* 共享缓冲区，不复制数据 */
+  void SetBuffer(const Buffer& data);
   void SetAnyData(const std::any& any_data);
 
  private:
+  void SetSrcId(addr_id_t id) { src_id_ = id; }
+  void SetDstId(addr_id_t id) { dst_id_ = id; }
+  void SetCorrelationId(uint64_t id) { corr_id_ = id; }
+  void SetReply(bool reply) { reply_ = reply; }
+  /* 清空消息内容，保留字符串容量，用于消息池复用 */
+  void Reset();
+
+  addr_id_t src_id_{INVALID_ADDR_ID};
+  addr_id_t dst_id_{INVALID_ADDR_ID};
+  Priority priority_{Priority::kNormal};
+  bool reply_{false};
+  uint64_t corr_id_{0};
   std::string src_;
   std::string dst_;
   std::string type_;
   std::string desc_;
-  std::string data_;
+  Buffer data_;
+  /// 本消息分配的数据字符串，没有被共享时可以复用
+  std::shared_ptr<std::string> own_data_{nullptr};
+  /// 数据不是完整的字符串时，GetData()生成的字符串
+  mutable std::shared_ptr<const std::string> data_str_{nullptr};
   std::any any_data_;
+  MsgNode node_;
 };
 
 MYFRAME_EXPORT std::ostream& operator<<(std::ostream& out, const Msg& msg);
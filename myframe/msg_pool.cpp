@@ -0,0 +1,155 @@
+/****************************************************************************
+Copyright (c) 2019, 李柯鹏
+All rights reserved.
+
+Author: 李柯鹏 <likepeng0418@163.com>
+****************************************************************************/
+
+#include "myframe/msg_pool.h"
+
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace myframe {
+
+namespace {
+
+/**
+ * 线程缓存的空闲链表
+ *
+ *  本线程缓存超过kMaxLocal时将一半归还到全局链表，
+ *  本线程缓存为空时从全局链表批量获取。
+ *  全局链表不释放，避免程序退出时仍有消息在使用。
+ */
+template <typename T>
+class FreeList final {
+ public:
+  static constexpr std::size_t kMaxLocal = 256;
+  static constexpr std::size_t kBatch = kMaxLocal / 2;
+  static constexpr std::size_t kMaxCentral = 64 * 1024;
+
+  static T* Get() {
+    auto& local = Local().items;
+    if (local.empty()) {
+      Central()->Take(&local, kBatch);
+    }
+    if (local.empty()) {
+      return nullptr;
+    }
+    auto p = local.back();
+    local.pop_back();
+    return p;
+  }
+
+  /* 返回false表示缓存已满，由调用者释放 */
+  static bool Put(T* p) {
+    auto& local = Local().items;
+    if (local.size() >= kMaxLocal) {
+      Central()->Give(&local, kBatch);
+    }
+    if (local.size() >= kMaxLocal) {
+      return false;
+    }
+    local.push_back(p);
+    return true;
+  }
+
+ private:
+  struct LocalCache {
+    LocalCache() { items.reserve(kMaxLocal); }
+    ~LocalCache() { Central()->Give(&items, items.size()); }
+    std::vector<T*> items;
+  };
+
+  struct CentralCache {
+    void Take(std::vector<T*>* dst, std::size_t n) {
+      std::lock_guard<std::mutex> lk(mtx);
+      while (n-- > 0 && !items.empty()) {
+        dst->push_back(items.back());
+        items.pop_back();
+      }
+    }
+    void Give(std::vector<T*>* src, std::size_t n) {
+      std::lock_guard<std::mutex> lk(mtx);
+      while (n-- > 0 && !src->empty() && items.size() < kMaxCentral) {
+        items.push_back(src->back());
+        src->pop_back();
+      }
+    }
+    std::mutex mtx;
+    std::vector<T*> items;
+  };
+
+  static LocalCache& Local() {
+    thread_local LocalCache local;
+    return local;
+  }
+  static CentralCache* Central() {
+    static CentralCache* central = new CentralCache();
+    return central;
+  }
+};
+
+/**
+ * shared_ptr控制块分配器
+ *
+ *  控制块使用线程缓存的空闲链表分配
+ */
+template <typename T>
+struct BlockAllocator {
+  typedef T value_type;
+  typedef std::aligned_storage_t<sizeof(T), alignof(T)> Block;
+
+  BlockAllocator() = default;
+  template <typename U>
+  BlockAllocator(const BlockAllocator<U>&) {}  // NOLINT
+
+  T* allocate(std::size_t n) {
+    if (n == 1) {
+      auto p = FreeList<Block>::Get();
+      if (p != nullptr) {
+        return reinterpret_cast<T*>(p);
+      }
+    }
+    return static_cast<T*>(::operator new(n * sizeof(T)));
+  }
+
+  void deallocate(T* p, std::size_t n) {
+    if (n == 1 && FreeList<Block>::Put(reinterpret_cast<Block*>(p))) {
+      return;
+    }
+    ::operator delete(p);
+  }
+
+  template <typename U>
+  bool operator==(const BlockAllocator<U>&) const { return true; }
+  template <typename U>
+  bool operator!=(const BlockAllocator<U>&) const { return false; }
+};
+
+}  // namespace
+
+MsgPool* MsgPool::Instance() {
+  static MsgPool* pool = new MsgPool();
+  return pool;
+}
+
+void MsgPool::Recycler::operator()(Msg* msg) const {
+  msg->Reset();
+  if (!FreeList<Msg>::Put(msg)) {
+    delete msg;
+  }
+}
+
+std::shared_ptr<Msg> MsgPool::Get() {
+  auto msg = FreeList<Msg>::Get();
+  if (msg == nullptr) {
+    alloc_cnt_.fetch_add(1, std::memory_order_relaxed);
+    msg = new Msg();
+  }
+  return std::shared_ptr<Msg>(msg, Recycler(), BlockAllocator<Msg>());
+}
+
+}  // namespace myframe
@@ -0,0 +1,48 @@
+/****************************************************************************
+Copyright (c) 2019, 李柯鹏
+All rights reserved.
+
+Author: 李柯鹏 <likepeng0418@163.com>
+****************************************************************************/
+
+#pragma once
+#include <atomic>
+#include <memory>
+
+#include "myframe/macros.h"
+#include "myframe/msg.h"
+
+namespace myframe {
+
+/**
+ * 消息对象池
+ *
+ *  每个线程有自己的空闲消息链表，消息引用计数为0时
+ *  归还到释放线程的空闲链表，超出上限的部分批量归还到全局链表，
+ *  供其它线程复用(生产者/消费者不在同一线程时消息会跨线程流动)。
+ *  复用的消息保留字符串容量，减少内存分配。
+ */
+class MsgPool final {
+ public:
+  static MsgPool* Instance();
+
+  /* 获得一个空消息，可以在任意线程调用 */
+  std::shared_ptr<Msg> Get();
+
+  /* 新分配的消息数(池中没有可复用的消息时分配) */
+  uint64_t AllocCount() const { return alloc_cnt_.load(); }
+
+ private:
+  MsgPool() = default;
+  ~MsgPool() = default;
+
+  struct Recycler {
+    void operator()(Msg* msg) const;
+  };
+
+  std::atomic<uint64_t> alloc_cnt_{0};
+
+  DISALLOW_COPY_AND_ASSIGN(MsgPool)
+};
+
+}  // namespace myframe
@@ -0,0 +1,195 @@
+/****************************************************************************
+Copyright (c) 2019, 李柯鹏
+All rights reserved.
+
+Author: 李柯鹏 <likepeng0418@163.com>
+****************************************************************************/
+
+#include "myframe/msg_queue.h"
+
+namespace myframe {
+
+std::shared_ptr<MsgQueue> MsgQueue::Create(Type type) {
+  if (type == Type::kLocked) {
+    return std::make_shared<LockedMsgQueue>();
+  }
+  return std::make_shared<MpscMsgQueue>();
+}
+
+bool MsgQueue::ParseType(const std::string& name, Type* type) {
+  if (name == "mpsc") {
+    *type = Type::kMpsc;
+  } else if (name == "locked") {
+    *type = Type::kLocked;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+std::size_t MsgQueue::PopBatch(
+  std::vector<std::shared_ptr<const Msg>>* msgs,
+  std::size_t max) {
+  std::size_t cnt = 0;
+  std::shared_ptr<Msg> msg;
+  while (cnt < max && (msg = Pop()) != nullptr) {
+    msgs->emplace_back(std::move(msg));
+    ++cnt;
+  }
+  return cnt;
+}
+
+void MsgQueue::PushBatch(std::vector<std::shared_ptr<Msg>>* msgs) {
+  for (auto& msg : *msgs) {
+    Push(std::move(msg));
+  }
+  msgs->clear();
+}
+
+/// MpscMsgQueue
+MpscMsgQueue::MpscMsgQueue()
+  : head_(&stub_)
+  , tail_(&stub_) {
+}
+
+MpscMsgQueue::~MpscMsgQueue() {
+  while (Pop() != nullptr) {}
+}
+
+void MpscMsgQueue::PushNode(MsgNode* node) {
+  node->next.store(nullptr, std::memory_order_relaxed);
+  PushNodes(node, node);
+}
+
+// first到last已经链接好，消费者看到first时整条链都可见
+void MpscMsgQueue::PushNodes(MsgNode* first, MsgNode* last) {
+  auto prev = head_.exchange(last, std::memory_order_acq_rel);
+  prev->next.store(first, std::memory_order_release);
+}
+
+// 节点出队后不再被队列引用(stub节点除外)
+MsgNode* MpscMsgQueue::PopNode() {
+  auto tail = tail_;
+  auto next = tail->next.load(std::memory_order_acquire);
+  if (tail == &stub_) {
+    if (next == nullptr) {
+      return nullptr;
+    }
+    tail_ = next;
+    tail = next;
+    next = next->next.load(std::memory_order_acquire);
+  }
+  if (next != nullptr) {
+    tail_ = next;
+    return tail;
+  }
+  // 有生产者正在入队
+  if (tail != head_.load(std::memory_order_acquire)) {
+    return nullptr;
+  }
+  PushNode(&stub_);
+  next = tail->next.load(std::memory_order_acquire);
+  if (next != nullptr) {
+    tail_ = next;
+    return tail;
+  }
+  return nullptr;
+}
+
+MsgNode* MpscMsgQueue::GetNode(std::shared_ptr<Msg> msg) {
+  MsgNode* node = &msg->node_;
+  if (node->in_use.exchange(true, std::memory_order_acquire)) {
+    node = new MsgNode();
+    node->alloc = true;
+  }
+  node->msg = std::move(msg);
+  return node;
+}
+
+void MpscMsgQueue::Push(std::shared_ptr<Msg> msg) {
+  PushNode(GetNode(std::move(msg)));
+}
+
+void MpscMsgQueue::PushBatch(std::vector<std::shared_ptr<Msg>>* msgs) {
+  MsgNode* first = nullptr;
+  MsgNode* last = nullptr;
+  for (auto& msg : *msgs) {
+    auto node = GetNode(std::move(msg));
+    node->next.store(nullptr, std::memory_order_relaxed);
+    if (last == nullptr) {
+      first = node;
+    } else {
+      last->next.store(node, std::memory_order_relaxed);
+    }
+    last = node;
+  }
+  msgs->clear();
+  if (first != nullptr) {
+    PushNodes(first, last);
+  }
+}
+
+std::shared_ptr<Msg> MpscMsgQueue::Pop() {
+  auto node = PopNode();
+  if (node == nullptr) {
+    return nullptr;
+  }
+  auto msg = std::move(node->msg);
+  if (node->alloc) {
+    delete node;
+  } else {
+    node->in_use.store(false, std::memory_order_release);
+  }
+  return msg;
+}
+
+bool MpscMsgQueue::Empty() const {
+  if (tail_ != &stub_) {
+    return false;
+  }
+  return stub_.next.load(std::memory_order_acquire) == nullptr;
+}
+
+/// LockedMsgQueue
+void LockedMsgQueue::Push(std::shared_ptr<Msg> msg) {
+  std::lock_guard<std::mutex> lk(mtx_);
+  msgs_.emplace_back(std::move(msg));
+}
+
+void LockedMsgQueue::PushBatch(std::vector<std::shared_ptr<Msg>>* msgs) {
+  std::lock_guard<std::mutex> lk(mtx_);
+  for (auto& msg : *msgs) {
+    msgs_.emplace_back(std::move(msg));
+  }
+  msgs->clear();
+}
+
+std::shared_ptr<Msg> LockedMsgQueue::Pop() {
+  std::lock_guard<std::mutex> lk(mtx_);
+  if (msgs_.empty()) {
+    return nullptr;
+  }
+  auto msg = std::move(msgs_.front());
+  msgs_.pop_front();
+  return msg;
+}
+
+std::size_t LockedMsgQueue::PopBatch(
+  std::vector<std::shared_ptr<const Msg>>* msgs,
+  std::size_t max) {
+  std::lock_guard<std::mutex> lk(mtx_);
+  std::size_t cnt = 0;
+  while (cnt < max && !msgs_.empty()) {
+    msgs->emplace_back(std::move(msgs_.front()));
+    msgs_.pop_front();
+    ++cnt;
+  }
+  return cnt;
+}
+
+bool LockedMsgQueue::Empty() const {
+  std::lock_guard<std::mutex> lk(mtx_);
+  return msgs_.empty();
+}
+
+}  // namespace myframe
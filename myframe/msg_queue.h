@@ -0,0 +1,103 @@
+/****************************************************************************
+Copyright (c) 2019, 李柯鹏
+All rights reserved.
+
+Author: 李柯鹏 <likepeng0418@163.com>
+****************************************************************************/
+
+#pragma once
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "myframe/macros.h"
+#include "myframe/msg.h"
+
+namespace myframe {
+
+/**
+ * actor收件箱消息队列
+ *
+ *  Push() 可以在任意线程调用;
+ *  Pop()/PopBatch()/Empty() 只能在处理该actor的线程中调用。
+ */
+class MsgQueue {
+ public:
+  enum class Type : int {
+    kMpsc,    ///< 无锁多生产者单消费者队列(默认)
+    kLocked,  ///< 互斥锁队列
+  };
+
+  MsgQueue() = default;
+  virtual ~MsgQueue() = default;
+
+  static std::shared_ptr<MsgQueue> Create(Type type = Type::kMpsc);
+  /* 解析配置中的队列类型: "mpsc", "locked"，未知类型返回false */
+  static bool ParseType(const std::string& name, Type* type);
+
+  virtual void Push(std::shared_ptr<Msg> msg) = 0;
+  /* 按顺序放入一批消息，放入后清空msgs */
+  virtual void PushBatch(std::vector<std::shared_ptr<Msg>>* msgs);
+  virtual std::shared_ptr<Msg> Pop() = 0;
+  /* 最多取出max个消息追加到msgs，返回取出的消息数 */
+  virtual std::size_t PopBatch(
+    std::vector<std::shared_ptr<const Msg>>* msgs,
+    std::size_t max);
+  virtual bool Empty() const = 0;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(MsgQueue)
+};
+
+/**
+ * 侵入式无锁多生产者单消费者队列
+ *
+ *  使用Msg中嵌入的节点，同一个消息同时在多个队列中时
+ *  才分配额外的节点。
+ */
+class MpscMsgQueue final : public MsgQueue {
+ public:
+  MpscMsgQueue();
+  virtual ~MpscMsgQueue();
+
+  void Push(std::shared_ptr<Msg> msg) override;
+  /* 整批消息先链接好，只做一次原子交换 */
+  void PushBatch(std::vector<std::shared_ptr<Msg>>* msgs) override;
+  std::shared_ptr<Msg> Pop() override;
+  bool Empty() const override;
+
+ private:
+  MsgNode* GetNode(std::shared_ptr<Msg> msg);
+  void PushNode(MsgNode* node);
+  void PushNodes(MsgNode* first, MsgNode* last);
+  MsgNode* PopNode();
+
+  /// 生产者端
+  std::atomic<MsgNode*> head_;
+  /// 消费者端
+  MsgNode* tail_;
+  MsgNode stub_;
+};
+
+class LockedMsgQueue final : public MsgQueue {
+ public:
+  LockedMsgQueue() = default;
+  virtual ~LockedMsgQueue() = default;
+
+  void Push(std::shared_ptr<Msg> msg) override;
+  void PushBatch(std::vector<std::shared_ptr<Msg>>* msgs) override;
+  std::shared_ptr<Msg> Pop() override;
+  std::size_t PopBatch(
+    std::vector<std::shared_ptr<const Msg>>* msgs,
+    std::size_t max) override;
+  bool Empty() const override;
+
+ private:
+  mutable std::mutex mtx_;
+  std::deque<std::shared_ptr<Msg>> msgs_;
+};
+
+}  // namespace myframe
@@ -0,0 +1,121 @@
+/****************************************************************************
+Copyright (c) 2019, 李柯鹏
+All rights reserved.
+
+Author: 李柯鹏 <likepeng0418@163.com>
+****************************************************************************/
+
+#include "myframe/pending_msg_cache.h"
+
+#include <algorithm>
+
+#include "myframe/log.h"
+
+namespace myframe {
+
+void PendingMsgCache::SetTtl(std::chrono::milliseconds ttl) {
+  if (ttl.count() <= 0) {
+    LOG(WARNING) << "invalid cache msg ttl " << ttl.count()
+      << "ms, use " << ttl_.count() << "ms";
+    return;
+  }
+  ttl_ = ttl;
+}
+
+void PendingMsgCache::SetMaxSize(std::size_t max_size) {
+  if (max_size == 0) {
+    LOG(WARNING) << "invalid cache msg max size 0, use " << max_size_;
+    return;
+  }
+  max_size_ = max_size;
+}
+
+void PendingMsgCache::Start(Clock::time_point now) {
+  if (started_) {
+    return;
+  }
+  started_ = true;
+  start_tp_ = now;
+}
+
+void PendingMsgCache::Push(
+    addr_id_t dst,
+    std::shared_ptr<Msg> msg,
+    std::list<std::shared_ptr<Msg>>* evicted,
+    Clock::time_point now) {
+  auto seq = ++seq_;
+  pending_[dst].push_back(Entry{seq, std::move(msg)});
+  order_.push_back(Order{seq, dst, now});
+  ++size_;
+  ++cached_cnt_;
+  // 超出容量时挤出最早缓存的消息
+  std::shared_ptr<Msg> oldest;
+  while (size_ > max_size_ && !order_.empty()) {
+    auto order = order_.front();
+    order_.pop_front();
+    if (Take(order, &oldest)) {
+      ++evicted_cnt_;
+      evicted->emplace_back(std::move(oldest));
+    }
+  }
+}
+
+std::size_t PendingMsgCache::Pop(
+    addr_id_t dst,
+    std::list<std::shared_ptr<Msg>>* msgs) {
+  auto it = pending_.find(dst);
+  if (it == pending_.end()) {
+    return 0;
+  }
+  auto n = it->second.size();
+  for (auto& entry : it->second) {
+    msgs->emplace_back(std::move(entry.msg));
+  }
+  pending_.erase(it);
+  size_ -= n;
+  delivered_cnt_ += n;
+  // 超时队列中剩下的都是已经取走的记录
+  if (size_ == 0) {
+    order_.clear();
+  }
+  return n;
+}
+
+std::size_t PendingMsgCache::Expire(
+    std::list<std::shared_ptr<Msg>>* msgs,
+    Clock::time_point now) {
+  if (!started_) {
+    return 0;
+  }
+  std::size_t n = 0;
+  std::shared_ptr<Msg> msg;
+  while (!order_.empty()) {
+    auto& order = order_.front();
+    if (std::max(order.tp, start_tp_) + ttl_ > now) {
+      break;
+    }
+    if (Take(order, &msg)) {
+      msgs->emplace_back(std::move(msg));
+      ++n;
+    }
+    order_.pop_front();
+  }
+  expired_cnt_ += n;
+  return n;
+}
+
+bool PendingMsgCache::Take(const Order& order, std::shared_ptr<Msg>* msg) {
+  auto it = pending_.find(order.dst);
+  if (it == pending_.end() || it->second.front().seq != order.seq) {
+    return false;
+  }
+  *msg = std::move(it->second.front().msg);
+  it->second.pop_front();
+  if (it->second.empty()) {
+    pending_.erase(it);
+  }
+  --size_;
+  return true;
+}
+
+}  // namespace myframe
@@ -0,0 +1,100 @@
+/****************************************************************************
+Copyright (c) 2019, 李柯鹏
+All rights reserved.
+
+Author: 李柯鹏 <likepeng0418@163.com>
+****************************************************************************/
+#pragma once
+#include <chrono>
+#include <deque>
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+#include "myframe/macros.h"
+#include "myframe/msg.h"
+
+namespace myframe {
+
+/**
+ * 目的地址未注册的消息缓存
+ *
+ *  按目的地址句柄索引，地址注册后只取出发给它的消息(O(k));
+ *  另外按缓存顺序记录一份超时队列，超时(ttl)或者超出容量的消息
+ *  从队首取出，交给调用者按原来的方式分发(比如转发给node)。
+ *  Start() 之前缓存的消息从 Start() 开始计时，
+ *  避免启动时加载大量actor导致消息提前超时。
+ *  非线程安全，由调用者加锁。
+ */
+class PendingMsgCache final {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  PendingMsgCache() = default;
+  ~PendingMsgCache() = default;
+
+  /* 超时时间及容量(缓存的消息数) */
+  void SetTtl(std::chrono::milliseconds ttl);
+  void SetMaxSize(std::size_t max_size);
+  std::chrono::milliseconds GetTtl() const { return ttl_; }
+  std::size_t GetMaxSize() const { return max_size_; }
+
+  /* 开始计时 */
+  void Start(Clock::time_point now = Clock::now());
+
+  /* 缓存发给dst的消息，超出容量时最早的消息放到evicted */
+  void Push(
+    addr_id_t dst,
+    std::shared_ptr<Msg> msg,
+    std::list<std::shared_ptr<Msg>>* evicted,
+    Clock::time_point now = Clock::now());
+  /* 取出发给dst的所有消息，返回取出的消息数 */
+  std::size_t Pop(addr_id_t dst, std::list<std::shared_ptr<Msg>>* msgs);
+  /* 取出超时的消息，返回取出的消息数 */
+  std::size_t Expire(
+    std::list<std::shared_ptr<Msg>>* msgs,
+    Clock::time_point now = Clock::now());
+
+  std::size_t Size() const { return size_; }
+  bool Empty() const { return size_ == 0; }
+
+  /// 统计
+  uint64_t CachedCount() const { return cached_cnt_; }
+  uint64_t DeliveredCount() const { return delivered_cnt_; }
+  uint64_t ExpiredCount() const { return expired_cnt_; }
+  uint64_t EvictedCount() const { return evicted_cnt_; }
+
+ private:
+  struct Entry {
+    uint64_t seq{0};
+    std::shared_ptr<Msg> msg{nullptr};
+  };
+  struct Order {
+    uint64_t seq{0};
+    addr_id_t dst{INVALID_ADDR_ID};
+    Clock::time_point tp;
+  };
+  /* 取出记录对应的消息，消息已经被Pop()取走时返回false */
+  bool Take(const Order& order, std::shared_ptr<Msg>* msg);
+
+  std::chrono::milliseconds ttl_{1000};
+  std::size_t max_size_{10000};
+  bool started_{false};
+  Clock::time_point start_tp_;
+
+  uint64_t seq_{0};
+  std::size_t size_{0};
+  /// key: 目的地址句柄, value: 按缓存顺序排列的消息
+  std::unordered_map<addr_id_t, std::deque<Entry>> pending_;
+  /// 缓存顺序(超时时间相同，也是超时顺序)
+  std::deque<Order> order_;
+
+  uint64_t cached_cnt_{0};
+  uint64_t delivered_cnt_{0};
+  uint64_t expired_cnt_{0};
+  uint64_t evicted_cnt_{0};
+
+  DISALLOW_COPY_AND_ASSIGN(PendingMsgCache)
+};
+
+}  // namespace myframe
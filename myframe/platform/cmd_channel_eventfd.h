@@ -0,0 +1,223 @@
+/****************************************************************************
+Copyright (c) 2019, 李柯鹏
+All rights reserved.
+
+Author: 李柯鹏 <likepeng0418@163.com>
+****************************************************************************/
+#pragma once
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "myframe/log.h"
+#include "myframe/macros.h"
+#include "myframe/event.h"
+#include "myframe/cmd_channel.h"
+
+namespace myframe {
+
+/**
+ * 基于eventfd的命令通道
+ *
+ *  每个方向一个原子命令槽和一个eventfd，命令直接写入命令槽，
+ *  只有接收方已经取完命令(可能在等待)时才写eventfd通知，
+ *  接收方取完命令时读取eventfd，eventfd可以注册到poller中。
+ *  接收方自旋等待期间不需要通知，收发都不需要系统调用;
+ *  超时等待使用poll()，不需要修改fd的阻塞属性。
+ */
+class CmdChannelEventfd final : public CmdChannel {
+ public:
+  explicit CmdChannelEventfd(std::shared_ptr<Poller>);
+  virtual ~CmdChannelEventfd();
+
+  ev_handle_t GetOwnerHandle() const override;
+  ev_handle_t GetMainHandle() const override;
+
+  int SendToOwner(const Cmd& cmd) override;
+  int RecvFromOwner(Cmd* cmd) override;
+
+  int SendToMain(const Cmd& cmd) override;
+  int RecvFromMain(Cmd* cmd, int timeout_ms = -1) override;
+
+ private:
+  /**
+   * 命令槽状态
+   *  低48位按顺序保存未读取的命令(每个命令1字节)，48~51位为命令数;
+   *  kArmed: 接收方已经取完命令，下一个命令需要写eventfd通知;
+   *  kSignaled: eventfd已经(或即将)写入，还没有读取
+   */
+  static constexpr int kCmdBits = 48;
+  static constexpr uint64_t kCmdMask = (1ULL << kCmdBits) - 1;
+  static constexpr uint64_t kMaxCmds = kCmdBits / 8;
+  static constexpr uint64_t kSignaled = 1ULL << 62;
+  static constexpr uint64_t kArmed = 1ULL << 63;
+  static uint64_t CmdCount(uint64_t state) {
+    return (state >> kCmdBits) & 0xf;
+  }
+
+  struct Channel {
+    ev_handle_t fd{-1};
+    std::atomic<uint64_t> state{kArmed};
+  };
+  int Send(Channel* ch, const Cmd& cmd);
+  int Recv(Channel* ch, Cmd* cmd, int timeout_ms, SpinWait* spin);
+  /* 取出一个命令，没有命令时返回0 */
+  int TryPop(Channel* ch, Cmd* cmd);
+
+  /// 主线程发给owner的命令
+  Channel to_owner_;
+  /// owner发给主线程的命令
+  Channel to_main_;
+
+  DISALLOW_COPY_AND_ASSIGN(CmdChannelEventfd)
+};
+
+CmdChannelEventfd::CmdChannelEventfd(std::shared_ptr<Poller> poller)
+  : CmdChannel(poller) {
+  to_owner_.fd = eventfd(0, EFD_CLOEXEC);
+  if (-1 == to_owner_.fd) {
+    LOG(ERROR) << "create owner eventfd failed, " << strerror(errno);
+  }
+  to_main_.fd = eventfd(0, EFD_CLOEXEC);
+  if (-1 == to_main_.fd) {
+    LOG(ERROR) << "create main eventfd failed, " << strerror(errno);
+  }
+}
+
+CmdChannelEventfd::~CmdChannelEventfd() {
+  if (to_owner_.fd != -1 && close(to_owner_.fd)) {
+    LOG(ERROR) << "close owner eventfd: " << strerror(errno);
+  }
+  if (to_main_.fd != -1 && close(to_main_.fd)) {
+    LOG(ERROR) << "close main eventfd: " << strerror(errno);
+  }
+}
+
+ev_handle_t CmdChannelEventfd::GetOwnerHandle() const {
+  return to_owner_.fd;
+}
+
+ev_handle_t CmdChannelEventfd::GetMainHandle() const {
+  return to_main_.fd;
+}
+
+// 命令放入命令槽，接收方等待通知时才写eventfd
+int CmdChannelEventfd::Send(Channel* ch, const Cmd& cmd) {
+  auto state = ch->state.load();
+  uint64_t next;
+  do {
+    auto cnt = CmdCount(state);
+    if (cnt >= kMaxCmds) {
+      LOG(ERROR) << "eventfd " << ch->fd << " has too many cmds";
+      return -1;
+    }
+    next = (state & kCmdMask)
+      | (static_cast<uint64_t>(static_cast<uint8_t>(cmd)) << (cnt * 8))
+      | ((cnt + 1) << kCmdBits)
+      | (state & kSignaled);
+    if (state & kArmed) {
+      next |= kSignaled;
+    }
+  } while (!ch->state.compare_exchange_weak(state, next));
+  if ((state & kArmed) && -1 == eventfd_write(ch->fd, 1)) {
+    LOG(ERROR) << "write eventfd " << ch->fd << " failed, " << strerror(errno);
+    return -1;
+  }
+  return 1;
+}
+
+// 取完命令时读取通知并等待下一个通知，
+// 还有命令时保持eventfd可读，poller会再次通知
+int CmdChannelEventfd::TryPop(Channel* ch, Cmd* cmd) {
+  auto state = ch->state.load();
+  uint64_t next;
+  uint64_t cnt;
+  do {
+    cnt = CmdCount(state);
+    if (cnt == 0) {
+      return 0;
+    }
+    next = ((state & kCmdMask) >> 8)
+      | ((cnt - 1) << kCmdBits)
+      | (cnt == 1 ? kArmed : kSignaled);
+  } while (!ch->state.compare_exchange_weak(state, next));
+  *cmd = static_cast<Cmd>(static_cast<char>(state & 0xff));
+  eventfd_t val;
+  if (cnt == 1 && (state & kSignaled)
+      && -1 == eventfd_read(ch->fd, &val)) {
+    LOG(ERROR) << "read eventfd " << ch->fd << " failed, " << strerror(errno);
+    return -1;
+  }
+  // 自旋期间或者读取通知后收到多个命令
+  if (cnt > 1 && !(state & kSignaled)
+      && -1 == eventfd_write(ch->fd, 1)) {
+    LOG(ERROR) << "write eventfd " << ch->fd << " failed, " << strerror(errno);
+    return -1;
+  }
+  return 1;
+}
+
+int CmdChannelEventfd::Recv(
+    Channel* ch, Cmd* cmd, int timeout_ms, SpinWait* spin) {
+  bool spun = timeout_ms == 0 || spin == nullptr || !spin->IsEnabled();
+  while (true) {
+    auto ret = TryPop(ch, cmd);
+    if (ret != 0) {
+      return ret;
+    }
+    if (!spun) {
+      // 自旋期间发送方不需要写eventfd
+      spun = true;
+      uint64_t state = kArmed;
+      if (ch->state.compare_exchange_strong(state, 0)) {
+        spin->Spin([ch]() { return CmdCount(ch->state.load()) > 0; });
+        state = 0;
+        ch->state.compare_exchange_strong(state, kArmed);
+      }
+      continue;
+    }
+    if (timeout_ms == 0) {
+      return -1;
+    }
+    if (timeout_ms > 0) {
+      struct pollfd pfd = {ch->fd, POLLIN, 0};
+      ret = poll(&pfd, 1, timeout_ms);
+      if (ret <= 0) {
+        LOG_IF(ERROR, ret < 0) << "poll eventfd failed, " << strerror(errno);
+        return -1;
+      }
+      continue;
+    }
+    eventfd_t val;
+    if (-1 == eventfd_read(ch->fd, &val)) {
+      LOG(ERROR) << "read eventfd " << ch->fd << " failed, "
+        << strerror(errno);
+      return -1;
+    }
+    // 通知已经读取
+    ch->state.fetch_and(~kSignaled);
+  }
+}
+
+int CmdChannelEventfd::SendToOwner(const Cmd& cmd) {
+  return Send(&to_owner_, cmd);
+}
+
+int CmdChannelEventfd::RecvFromOwner(Cmd* cmd) {
+  return Recv(&to_main_, cmd, -1, nullptr);
+}
+
+int CmdChannelEventfd::SendToMain(const Cmd& cmd) {
+  return Send(&to_main_, cmd);
+}
+
+int CmdChannelEventfd::RecvFromMain(Cmd* cmd, int timeout_ms) {
+  return Recv(&to_owner_, cmd, timeout_ms, &spin_);
+}
+
+}  // namespace myframe
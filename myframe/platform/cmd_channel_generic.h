@@ -39,6 +39,8 @@ class CmdChannelGeneric final : public CmdChannel {
 
   std::mutex mtx_;
   std::list<Cmd> to_owner_cmd_;
+  /// to_owner_cmd_ 的长度，用于自旋等待
+  std::atomic<std::size_t> to_owner_cmd_size_{0};
   std::condition_variable cv_;
 
   DISALLOW_COPY_AND_ASSIGN(CmdChannelGeneric)
@@ -63,6 +65,7 @@ ev_handle_t CmdChannelGeneric::GetMainHandle() const {
 int CmdChannelGeneric::SendToOwner(const Cmd& cmd) {
   std::lock_guard<std::mutex> lk(mtx_);
   to_owner_cmd_.push_back(cmd);
+  to_owner_cmd_size_.store(to_owner_cmd_.size());
   cv_.notify_one();
   return 0;
 }
@@ -75,6 +78,7 @@ int CmdChannelGeneric::RecvFromOwner(Cmd* cmd) {
 }
 
 int CmdChannelGeneric::RecvFromMain(Cmd* cmd, int timeout_ms) {
+  spin_.Spin([this]() { return to_owner_cmd_size_.load() > 0; });
   std::unique_lock<std::mutex> lk(mtx_);
   using namespace std::chrono_literals;  // NOLINT
   if (timeout_ms > 0) {
@@ -92,6 +96,7 @@ int CmdChannelGeneric::RecvFromMain(Cmd* cmd, int timeout_ms) {
   }
   *cmd = to_owner_cmd_.front();
   to_owner_cmd_.pop_front();
+  to_owner_cmd_size_.store(to_owner_cmd_.size());
   return 0;
 }
 
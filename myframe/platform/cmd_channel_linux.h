@@ -110,7 +110,13 @@ int CmdChannelLinux::RecvFromOwner(Cmd* cmd) {
 }
 
 int CmdChannelLinux::RecvFromMain(Cmd* cmd, int timeout_ms) {
-  (void)timeout_ms;
+  char cmd_char;
+  if (timeout_ms != 0 && spin_.Spin([this, &cmd_char]() {
+      return 1 == recv(sockpair_[0], &cmd_char, 1, MSG_DONTWAIT);
+    })) {
+    *cmd = static_cast<Cmd>(cmd_char);
+    return 1;
+  }
   if (timeout_ms < 0) {
     // block
     if (!IsBlockFd(sockpair_[0])) {
@@ -125,7 +131,6 @@ int CmdChannelLinux::RecvFromMain(Cmd* cmd, int timeout_ms) {
     // timeout
     SetSockRecvTimeout(sockpair_[0], timeout_ms);
   }
-  char cmd_char;
   int ret = read(sockpair_[0], &cmd_char, 1);
   if (ret < 0) {
     LOG(ERROR) << "read 0 cmd failed, " << strerror(errno);
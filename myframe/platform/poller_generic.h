@@ -27,8 +27,12 @@ class PollerGeneric final : public Poller {
   bool Init() override;
   int Wait(std::vector<ev_handle_t>* evs, int timeout_ms = 100) override;
   void Notify(ev_handle_t h) override;
+  void Wakeup() override;
 
  private:
+  bool wakeup_{false};
+  /// 是否有事件或唤醒，用于自旋等待
+  std::atomic_bool ready_{false};
   std::vector<ev_handle_t> evs_;
   std::mutex mtx_;
   std::condition_variable cv_;
@@ -46,13 +50,17 @@ bool PollerGeneric::Init() {
 
 int PollerGeneric::Wait(std::vector<ev_handle_t>* evs, int timeout_ms) {
   evs->clear();
+  spin_.Spin([this]() { return ready_.load(); });
   using namespace std::chrono_literals;  // NOLINT
   std::unique_lock<std::mutex> lk(mtx_);
   if (timeout_ms > 0) {
-    cv_.wait_for(lk, timeout_ms * 1ms, [this](){ return !evs_.empty(); });
+    cv_.wait_for(lk, timeout_ms * 1ms,
+      [this](){ return !evs_.empty() || wakeup_; });
   } else {
-    cv_.wait(lk, [this](){ return !evs_.empty(); });
+    cv_.wait(lk, [this](){ return !evs_.empty() || wakeup_; });
   }
+  wakeup_ = false;
+  ready_.store(false);
   for (auto it = evs_.begin(); it != evs_.end(); ++it) {
       evs->push_back(*it);
   }
@@ -63,6 +71,14 @@ int PollerGeneric::Wait(std::vector<ev_handle_t>* evs, int timeout_ms) {
 void PollerGeneric::Notify(ev_handle_t h) {
   std::lock_guard<std::mutex> lk(mtx_);
   evs_.push_back(h);
+  ready_.store(true);
+  cv_.notify_one();
+}
+
+void PollerGeneric::Wakeup() {
+  std::lock_guard<std::mutex> lk(mtx_);
+  wakeup_ = true;
+  ready_.store(true);
   cv_.notify_one();
 }
 
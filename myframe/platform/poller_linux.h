@@ -8,6 +8,7 @@ Author: 李柯鹏 <likepeng0418@163.com>
 #pragma once
 #include <errno.h>
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
 
 #include <memory>
 #include <atomic>
@@ -31,10 +32,13 @@ class PollerLinux final : public Poller {
   bool Add(const std::shared_ptr<Event>&) const override;
   bool Del(const std::shared_ptr<Event>&) const override;
   int Wait(std::vector<ev_handle_t>* evs, int timeout_ms = 100) override;
+  void Wakeup() override;
 
  private:
   std::atomic_bool init_{false};
   int poll_fd_{-1};
+  /// 用于唤醒Wait()的eventfd
+  int wakeup_fd_{-1};
   size_t max_ev_count_{64};
   struct epoll_event* evs_{nullptr};
 
@@ -42,6 +46,10 @@ class PollerLinux final : public Poller {
 };
 
 PollerLinux::~PollerLinux() {
+  if (wakeup_fd_ != -1) {
+    close(wakeup_fd_);
+    wakeup_fd_ = -1;
+  }
   if (poll_fd_ != -1) {
     close(poll_fd_);
     poll_fd_ = -1;
@@ -63,6 +71,18 @@ bool PollerLinux::Init() {
     return false;
   }
   LOG(INFO) << "Create epoll fd " << poll_fd_;
+  wakeup_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (-1 == wakeup_fd_) {
+    LOG(ERROR) << "poller create wakeup fd failed, " << strerror(errno);
+    return false;
+  }
+  struct epoll_event event;
+  event.data.fd = wakeup_fd_;
+  event.events = EPOLLIN;
+  if (-1 == epoll_ctl(poll_fd_, EPOLL_CTL_ADD, wakeup_fd_, &event)) {
+    LOG(ERROR) << "poller add wakeup fd failed, " << strerror(errno);
+    return false;
+  }
   auto void_evs = malloc(sizeof(struct epoll_event) * max_ev_count_);
   evs_ = reinterpret_cast<struct epoll_event*>(void_evs);
   init_.store(true);
@@ -111,10 +131,18 @@ int PollerLinux::Wait(std::vector<ev_handle_t>* evs, int timeout_ms) {
     return -1;
   }
   evs->clear();
-  int ev_count = epoll_wait(poll_fd_,
-    evs_,
-    static_cast<int>(max_ev_count_),
-    timeout_ms);
+  int ev_count = 0;
+  // 先忙轮询一段时间，没有事件再阻塞等待
+  if (timeout_ms == 0 || !spin_.Spin([this, &ev_count]() {
+      ev_count = epoll_wait(poll_fd_,
+        evs_, static_cast<int>(max_ev_count_), 0);
+      return ev_count != 0;
+    })) {
+    ev_count = epoll_wait(poll_fd_,
+      evs_,
+      static_cast<int>(max_ev_count_),
+      timeout_ms);
+  }
   if (0 > ev_count) {
     LOG(WARNING) << "epoll wait error: " << strerror(errno);
     return -1;
@@ -124,9 +152,23 @@ int PollerLinux::Wait(std::vector<ev_handle_t>* evs, int timeout_ms) {
       LOG(WARNING) << "epoll event " << evs_[i].events << " continue";
       continue;
     }
+    if (evs_[i].data.fd == wakeup_fd_) {
+      eventfd_t val;
+      eventfd_read(wakeup_fd_, &val);
+      continue;
+    }
     evs->push_back(evs_[i].data.fd);
   }
   return ev_count;
 }
 
+void PollerLinux::Wakeup() {
+  if (!init_.load()) {
+    return;
+  }
+  if (-1 == eventfd_write(wakeup_fd_, 1)) {
+    LOG(ERROR) << "poller wakeup failed, " << strerror(errno);
+  }
+}
+
 }  // namespace myframe
@@ -13,6 +13,7 @@ Author: 李柯鹏 <likepeng0418@163.com>
 #include "myframe/export.h"
 #include "myframe/macros.h"
 #include "myframe/event.h"
+#include "myframe/spin_wait.h"
 
 namespace myframe {
 
@@ -28,6 +29,14 @@ class MYFRAME_EXPORT Poller {
   virtual bool Del(const std::shared_ptr<Event>&) const { return true; }
   virtual int Wait(std::vector<ev_handle_t>* evs, int timeout_ms = 100) = 0;
   virtual void Notify(ev_handle_t) {}
+  /* 唤醒阻塞在Wait()中的线程，可以在任意线程调用 */
+  virtual void Wakeup() = 0;
+
+  /* Wait()阻塞之前的自旋等待设置及统计 */
+  SpinWait* GetSpinWait() { return &spin_; }
+
+ protected:
+  SpinWait spin_;
 
  private:
   DISALLOW_COPY_AND_ASSIGN(Poller)
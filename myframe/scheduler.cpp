@@ -0,0 +1,202 @@
+/****************************************************************************
+Copyright (c) 2019, 李柯鹏
+All rights reserved.
+
+Author: 李柯鹏 <likepeng0418@163.com>
+****************************************************************************/
+
+#include "myframe/scheduler.h"
+
+#include <algorithm>
+
+#include "myframe/actor_context.h"
+
+namespace myframe {
+
+namespace {
+/// 当前线程绑定的调度器及工作线程序号
+thread_local Scheduler* tls_scheduler = nullptr;
+thread_local std::size_t tls_index = 0;
+}  // namespace
+
+Scheduler::Scheduler(std::size_t worker_count) {
+  if (worker_count == 0) {
+    worker_count = 1;
+  }
+  for (std::size_t i = 0; i < worker_count; ++i) {
+    locals_.emplace_back(new RunQueue());
+  }
+}
+
+void Scheduler::Bind(std::size_t index) {
+  tls_scheduler = this;
+  tls_index = index % locals_.size();
+}
+
+void Scheduler::Push(std::shared_ptr<ActorContext> ctx, bool high) {
+  auto rq = &inject_;
+  bool bound = !ctx->GetWorkerAffinity().empty();
+  if (bound) {
+    // 当前线程不在绑定集合中时放入绑定的第一个工作线程
+    auto index = ctx->GetWorkerAffinity().front() % locals_.size();
+    if (tls_scheduler == this && ctx->IsAllowedWorker(tls_index)) {
+      index = tls_index;
+    }
+    rq = locals_[index].get();
+  } else {
+    if (tls_scheduler == this) {
+      rq = locals_[tls_index].get();
+    }
+    pending_.fetch_add(1);
+  }
+  {
+    std::lock_guard<std::mutex> lk(rq->mtx);
+    if (high) {
+      rq->q.push_front(std::move(ctx));
+    } else {
+      rq->q.push_back(std::move(ctx));
+    }
+    rq->size.fetch_add(1);
+  }
+  // 绑定的actor只能由指定线程处理，需要唤醒所有等待的线程
+  Notify(bound);
+}
+
+void Scheduler::Notify(bool all) {
+  if (sleepers_.load() == 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> lk(park_mtx_);
+  if (all) {
+    park_cv_.notify_all();
+  } else {
+    park_cv_.notify_one();
+  }
+}
+
+std::shared_ptr<ActorContext> Scheduler::PopLocal(std::size_t index) {
+  auto rq = locals_[index].get();
+  std::lock_guard<std::mutex> lk(rq->mtx);
+  if (rq->q.empty()) {
+    return nullptr;
+  }
+  auto ctx = std::move(rq->q.front());
+  rq->q.pop_front();
+  rq->size.fetch_sub(1);
+  return ctx;
+}
+
+// 从注入队列取一个actor，并按工作线程数均分搬运一批到本地队列
+std::shared_ptr<ActorContext> Scheduler::PopInject(std::size_t index) {
+  std::deque<std::shared_ptr<ActorContext>> batch;
+  {
+    std::lock_guard<std::mutex> lk(inject_.mtx);
+    if (inject_.q.empty()) {
+      return nullptr;
+    }
+    auto n = std::min(
+      inject_.q.size(), inject_.q.size() / locals_.size() + 1);
+    for (std::size_t i = 0; i < n; ++i) {
+      batch.push_back(std::move(inject_.q.front()));
+      inject_.q.pop_front();
+    }
+    inject_.size.fetch_sub(n);
+  }
+  auto ctx = std::move(batch.front());
+  batch.pop_front();
+  if (!batch.empty()) {
+    auto rq = locals_[index].get();
+    std::lock_guard<std::mutex> lk(rq->mtx);
+    for (auto& c : batch) {
+      rq->q.push_back(std::move(c));
+    }
+    rq->size.fetch_add(batch.size());
+  }
+  return ctx;
+}
+
+// 从其它工作线程的队列尾部窃取一半，跳过不能在本线程运行的actor
+std::shared_ptr<ActorContext> Scheduler::Steal(std::size_t index) {
+  auto sz = locals_.size();
+  for (std::size_t i = 1; i < sz; ++i) {
+    auto victim = locals_[(index + i) % sz].get();
+    std::deque<std::shared_ptr<ActorContext>> batch;
+    {
+      std::lock_guard<std::mutex> lk(victim->mtx);
+      if (victim->q.empty()) {
+        continue;
+      }
+      auto n = (victim->q.size() + 1) / 2;
+      auto it = victim->q.end();
+      while (it != victim->q.begin() && batch.size() < n) {
+        --it;
+        if (!(*it)->IsAllowedWorker(index)) {
+          continue;
+        }
+        batch.push_front(std::move(*it));
+        it = victim->q.erase(it);
+      }
+      victim->size.fetch_sub(batch.size());
+    }
+    if (batch.empty()) {
+      continue;
+    }
+    auto ctx = std::move(batch.front());
+    batch.pop_front();
+    if (!batch.empty()) {
+      auto rq = locals_[index].get();
+      std::lock_guard<std::mutex> lk(rq->mtx);
+      for (auto& c : batch) {
+        rq->q.push_back(std::move(c));
+      }
+      rq->size.fetch_add(batch.size());
+    }
+    return ctx;
+  }
+  return nullptr;
+}
+
+std::shared_ptr<ActorContext> Scheduler::Pop(SpinWait* spin) {
+  auto index = tls_scheduler == this ? tls_index : 0;
+  while (!stop_.load()) {
+    std::shared_ptr<ActorContext> ctx = PopLocal(index);
+    if (ctx == nullptr) {
+      ctx = PopInject(index);
+    }
+    if (ctx == nullptr) {
+      ctx = Steal(index);
+    }
+    if (ctx != nullptr) {
+      if (ctx->GetWorkerAffinity().empty()) {
+        pending_.fetch_sub(1);
+      }
+      return ctx;
+    }
+    // 没有可运行的actor，等待新的actor放入
+    auto local = locals_[index].get();
+    if (spin != nullptr && spin->Spin([this, local]() {
+        return pending_.load() > 0 || local->size.load() > 0 || stop_.load();
+      })) {
+      continue;
+    }
+    std::unique_lock<std::mutex> lk(park_mtx_);
+    sleepers_.fetch_add(1);
+    park_cv_.wait(lk, [this, local](){
+      return pending_.load() > 0 || local->size.load() > 0 || stop_.load();
+    });
+    sleepers_.fetch_sub(1);
+  }
+  return nullptr;
+}
+
+void Scheduler::Stop() {
+  {
+    std::lock_guard<std::mutex> lk(park_mtx_);
+    stop_.store(true);
+  }
+  park_cv_.notify_all();
+  std::lock_guard<std::mutex> lk(inject_.mtx);
+  inject_.q.clear();
+}
+
+}  // namespace myframe
@@ -0,0 +1,79 @@
+/****************************************************************************
+Copyright (c) 2019, 李柯鹏
+All rights reserved.
+
+Author: 李柯鹏 <likepeng0418@163.com>
+****************************************************************************/
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "myframe/macros.h"
+#include "myframe/spin_wait.h"
+
+namespace myframe {
+
+class ActorContext;
+/**
+ * actor调度器(直接分发模式)
+ *
+ *  工作线程直接从调度器获得可运行的actor，
+ *  actor收到消息时由发送线程放入调度器，不经过主线程。
+ *
+ *  每个工作线程有自己的运行队列，工作线程中产生的可运行actor
+ *  放入本线程队列，其它线程(主线程等)产生的放入全局注入队列;
+ *  工作线程本地队列为空时先从注入队列获取，再从其它工作线程窃取。
+ *
+ *  绑定了工作线程的actor只放入绑定线程的本地队列，
+ *  也只会被绑定集合中的其它工作线程窃取。
+ */
+class Scheduler final {
+ public:
+  explicit Scheduler(std::size_t worker_count);
+  virtual ~Scheduler() = default;
+
+  /* 将当前线程绑定为第index个工作线程，在工作线程中调用 */
+  void Bind(std::size_t index);
+
+  /* 将可运行的actor放入调度队列，可以在任意线程调用
+   * high为true(actor有高优先级消息)时放入队列头部优先调度 */
+  void Push(std::shared_ptr<ActorContext> ctx, bool high = false);
+  /* 获得一个可运行的actor，调度器停止后返回nullptr，在工作线程中调用
+   * 没有可运行的actor时，先使用spin自旋等待再睡眠 */
+  std::shared_ptr<ActorContext> Pop(SpinWait* spin = nullptr);
+
+  void Stop();
+  bool IsStop() const { return stop_.load(); }
+
+ private:
+  struct RunQueue {
+    std::mutex mtx;
+    std::deque<std::shared_ptr<ActorContext>> q;
+    std::atomic<std::size_t> size{0};
+  };
+  std::shared_ptr<ActorContext> PopLocal(std::size_t index);
+  std::shared_ptr<ActorContext> PopInject(std::size_t index);
+  std::shared_ptr<ActorContext> Steal(std::size_t index);
+  void Notify(bool all);
+
+  std::atomic_bool stop_{false};
+  /// 所有队列中可以在任意线程运行的actor数
+  std::atomic<std::size_t> pending_{0};
+  /// 等待中的工作线程数
+  std::atomic<std::size_t> sleepers_{0};
+  std::mutex park_mtx_;
+  std::condition_variable park_cv_;
+  /// 全局注入队列
+  RunQueue inject_;
+  /// 工作线程本地队列
+  std::vector<std::unique_ptr<RunQueue>> locals_;
+
+  DISALLOW_COPY_AND_ASSIGN(Scheduler)
+};
+
+}  // namespace myframe
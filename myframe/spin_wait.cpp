@@ -0,0 +1,67 @@
+/****************************************************************************
+Copyright (c) 2019, 李柯鹏
+All rights reserved.
+
+Author: 李柯鹏 <likepeng0418@163.com>
+****************************************************************************/
+
+#include "myframe/spin_wait.h"
+
+#include <algorithm>
+#include <thread>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace myframe {
+
+SpinWait::SpinWait(int max_spin_us) {
+  SetMaxSpinTime(max_spin_us);
+}
+
+void SpinWait::SetMaxSpinTime(int max_spin_us) {
+  max_spin_ns_ = std::max(0, max_spin_us) * 1000LL;
+  spin_ns_ = max_spin_ns_;
+}
+
+int SpinWait::GetMaxSpinTime() const {
+  return static_cast<int>(max_spin_ns_ / 1000);
+}
+
+uint64_t SpinWait::GetSpinCount() const {
+  return spin_count_.load(std::memory_order_relaxed);
+}
+
+uint64_t SpinWait::GetHitCount() const {
+  return hit_count_.load(std::memory_order_relaxed);
+}
+
+double SpinWait::GetHitRate() const {
+  auto spin_count = GetSpinCount();
+  if (spin_count == 0) {
+    return 0.0;
+  }
+  return static_cast<double>(GetHitCount()) / spin_count;
+}
+
+void SpinWait::CpuRelax() {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+  asm volatile("yield" ::: "memory");
+#else
+  std::this_thread::yield();
+#endif
+}
+
+void SpinWait::Adjust(bool hit) {
+  if (hit) {
+    spin_ns_ = std::min(max_spin_ns_, spin_ns_ * 2);
+  } else {
+    spin_ns_ = std::max(max_spin_ns_ / 16, spin_ns_ / 2);
+  }
+}
+
+}  // namespace myframe
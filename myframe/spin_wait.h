@@ -0,0 +1,79 @@
+/****************************************************************************
+Copyright (c) 2019, 李柯鹏
+All rights reserved.
+
+Author: 李柯鹏 <likepeng0418@163.com>
+****************************************************************************/
+
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "myframe/export.h"
+#include "myframe/macros.h"
+
+namespace myframe {
+
+/**
+ * 自适应自旋等待
+ *
+ *  阻塞等待之前先自旋一段时间，条件在自旋期间满足时可以省去一次
+ *  线程睡眠/唤醒。自旋时间在 [最大自旋时间/16, 最大自旋时间] 之间自适应:
+ *  命中后加倍，未命中减半。最大自旋时间为0时不自旋(默认)。
+ *  Spin() 只能在等待线程中调用，统计数据可以在任意线程读取。
+ */
+class MYFRAME_EXPORT SpinWait final {
+ public:
+  explicit SpinWait(int max_spin_us = 0);
+  ~SpinWait() = default;
+
+  void SetMaxSpinTime(int max_spin_us);
+  int GetMaxSpinTime() const;
+  bool IsEnabled() const { return max_spin_ns_ > 0; }
+
+  /**
+   * Spin() - 自旋等待条件满足
+   * @ready: 检查条件的函数，不能阻塞
+   *
+   * @return: 自旋期间条件满足返回true，超过自旋时间返回false
+   */
+  template <typename F>
+  bool Spin(F&& ready) {
+    if (max_spin_ns_ <= 0) {
+      return false;
+    }
+    spin_count_.fetch_add(1, std::memory_order_relaxed);
+    auto deadline = std::chrono::steady_clock::now()
+      + std::chrono::nanoseconds(spin_ns_);
+    while (!ready()) {
+      CpuRelax();
+      if (std::chrono::steady_clock::now() >= deadline) {
+        Adjust(false);
+        return false;
+      }
+    }
+    hit_count_.fetch_add(1, std::memory_order_relaxed);
+    Adjust(true);
+    return true;
+  }
+
+  /// 统计
+  uint64_t GetSpinCount() const;
+  uint64_t GetHitCount() const;
+  /* 自旋命中率 [0, 1] */
+  double GetHitRate() const;
+
+ private:
+  static void CpuRelax();
+  void Adjust(bool hit);
+
+  int64_t max_spin_ns_{0};
+  int64_t spin_ns_{0};
+  std::atomic<uint64_t> spin_count_{0};
+  std::atomic<uint64_t> hit_count_{0};
+
+  DISALLOW_COPY_AND_ASSIGN(SpinWait)
+};
+
+}  // namespace myframe
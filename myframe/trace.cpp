@@ -0,0 +1,266 @@
+/****************************************************************************
+Copyright (c) 2019, 李柯鹏
+All rights reserved.
+
+Author: 李柯鹏 <likepeng0418@163.com>
+****************************************************************************/
+
+#include "myframe/trace.h"
+
+#include <algorithm>
+#include <fstream>
+#include <unordered_map>
+#include <utility>
+
+#include "myframe/log.h"
+
+namespace myframe {
+
+struct TraceEvent {
+  int64_t ts_ns{0};
+  /// 时间段事件的耗时，瞬时事件为-1
+  int64_t dur_ns{-1};
+  uint64_t arg{0};
+  addr_id_t id{INVALID_ADDR_ID};
+  Tracer::Event ev{Tracer::Event::kDispatch};
+};
+
+/**
+ * 线程的事件缓冲区
+ *  只有所属线程写入，head_递增，按 head_ & mask_ 覆盖写
+ */
+class TraceRing final {
+ public:
+  explicit TraceRing(uint32_t tid) : tid_(tid) {}
+
+  void Resize(std::size_t capacity) {
+    events_.resize(capacity);
+    mask_ = capacity - 1;
+    head_.store(0, std::memory_order_release);
+  }
+
+  void Push(const TraceEvent& e) {
+    auto h = head_.load(std::memory_order_relaxed);
+    events_[h & mask_] = e;
+    head_.store(h + 1, std::memory_order_release);
+  }
+
+  uint32_t tid_;
+  std::string name_;
+  std::vector<TraceEvent> events_;
+  std::size_t mask_{0};
+  std::atomic<uint64_t> head_{0};
+};
+
+namespace {
+thread_local TraceRing* tls_ring = nullptr;
+/// 线程数超过上限时不再尝试创建缓冲区
+thread_local bool tls_ring_full = false;
+
+struct EventInfo {
+  const char* name;
+  const char* arg_name;
+};
+
+const EventInfo& GetEventInfo(Tracer::Event ev) {
+  static const EventInfo infos[] = {
+    {"send", "msgs"},
+    {"dispatch", nullptr},
+    {"enqueue", "depth"},
+    {"schedule", "worker"},
+    {"proc", "msgs"},
+    {"timer", "timers"},
+  };
+  return infos[static_cast<std::size_t>(ev)];
+}
+
+std::string Escape(const std::string& s) {
+  std::string res;
+  res.reserve(s.size());
+  for (auto c : s) {
+    if (c == '"' || c == '\\') {
+      res.push_back('\\');
+      res.push_back(c);
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      res.push_back(' ');
+    } else {
+      res.push_back(c);
+    }
+  }
+  return res;
+}
+
+/* ns转换为us，保留3位小数 */
+void WriteUs(std::ostream& out, int64_t ns) {
+  auto frac = std::to_string(1000 + ns % 1000).substr(1);
+  out << ns / 1000 << "." << frac;
+}
+}  // namespace
+
+std::atomic_bool Tracer::enabled_{false};
+
+Tracer* Tracer::Instance() {
+  static Tracer* tracer = new Tracer();
+  return tracer;
+}
+
+void Tracer::Start(std::size_t events_per_thread) {
+  std::lock_guard<std::mutex> lk(mtx_);
+  if (enabled_.load()) {
+    return;
+  }
+  if (capacity_ == 0) {
+    capacity_ = 1024;
+    while (capacity_ < events_per_thread) {
+      capacity_ <<= 1;
+    }
+  } else if (events_per_thread != capacity_) {
+    LOG(WARNING) << "trace buffer size already set to " << capacity_;
+  }
+  // 未开始记录时没有线程写入，可以重置缓冲区
+  for (auto& ring : rings_) {
+    ring->Resize(capacity_);
+  }
+  enabled_.store(true);
+  LOG(INFO) << "trace start, " << capacity_ << " events per thread";
+}
+
+void Tracer::Stop() {
+  enabled_.store(false);
+  LOG(INFO) << "trace stop";
+}
+
+void Tracer::SetThreadName(const std::string& name) {
+  auto ring = GetRing();
+  if (ring == nullptr) {
+    return;
+  }
+  std::lock_guard<std::mutex> lk(mtx_);
+  ring->name_ = name;
+}
+
+TraceRing* Tracer::GetRing() {
+  if (tls_ring != nullptr || tls_ring_full) {
+    return tls_ring;
+  }
+  std::lock_guard<std::mutex> lk(mtx_);
+  if (rings_.size() >= kMaxRings) {
+    tls_ring_full = true;
+    return nullptr;
+  }
+  auto ring = std::make_unique<TraceRing>(rings_.size() + 1);
+  ring->name_ = "thread." + std::to_string(ring->tid_);
+  if (capacity_ > 0) {
+    ring->Resize(capacity_);
+  }
+  tls_ring = ring.get();
+  rings_.emplace_back(std::move(ring));
+  return tls_ring;
+}
+
+void Tracer::Write(
+    Event ev,
+    addr_id_t id,
+    Clock::time_point begin,
+    Clock::time_point end,
+    uint64_t arg) {
+  auto ring = GetRing();
+  if (ring == nullptr || ring->events_.empty()) {
+    return;
+  }
+  TraceEvent e;
+  e.ts_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    begin.time_since_epoch()).count();
+  if (end != Clock::time_point()) {
+    e.dur_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      end - begin).count();
+  }
+  e.arg = arg;
+  e.id = id;
+  e.ev = ev;
+  ring->Push(e);
+}
+
+bool Tracer::Dump(
+    const std::string& file,
+    const std::function<std::string(addr_id_t)>& addr_name) {
+  std::ofstream out(file, std::ios::out | std::ios::trunc);
+  if (!out.is_open()) {
+    LOG(ERROR) << "open trace file " << file << " failed";
+    return false;
+  }
+  std::unordered_map<addr_id_t, std::string> names;
+  auto get_name = [&](addr_id_t id) -> const std::string& {
+    auto it = names.find(id);
+    if (it == names.end()) {
+      it = names.emplace(id, Escape(addr_name(id))).first;
+    }
+    return it->second;
+  };
+
+  std::lock_guard<std::mutex> lk(mtx_);
+  std::size_t cnt = 0;
+  out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+  out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,"
+    << "\"args\":{\"name\":\"myframe\"}}";
+  std::vector<TraceEvent> events;
+  for (auto& ring : rings_) {
+    out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+      << ring->tid_ << ",\"args\":{\"name\":\"" << Escape(ring->name_)
+      << "\"}}";
+    auto cap = ring->events_.size();
+    if (cap == 0) {
+      continue;
+    }
+    auto head = ring->head_.load(std::memory_order_acquire);
+    auto begin = head > cap ? head - cap : 0;
+    events.clear();
+    for (auto i = begin; i < head; ++i) {
+      events.emplace_back(ring->events_[i & ring->mask_]);
+    }
+    // 跳过复制期间被覆盖的事件
+    auto new_head = ring->head_.load(std::memory_order_acquire);
+    auto skip = new_head > cap + begin ? new_head - cap - begin : 0;
+    for (auto i = std::min<std::size_t>(skip, events.size());
+        i < events.size(); ++i) {
+      auto& e = events[i];
+      auto& info = GetEventInfo(e.ev);
+      out << ",\n{\"name\":\"";
+      if (e.ev == Event::kProc && e.id != INVALID_ADDR_ID) {
+        out << get_name(e.id);
+      } else {
+        out << info.name;
+      }
+      out << "\",\"cat\":\"" << info.name << "\",\"pid\":1,\"tid\":"
+        << ring->tid_ << ",\"ts\":";
+      WriteUs(out, e.ts_ns);
+      if (e.dur_ns >= 0) {
+        out << ",\"ph\":\"X\",\"dur\":";
+        WriteUs(out, e.dur_ns);
+      } else {
+        out << ",\"ph\":\"i\",\"s\":\"t\"";
+      }
+      out << ",\"args\":{";
+      bool has_arg = false;
+      if (e.id != INVALID_ADDR_ID) {
+        out << "\"addr\":\"" << get_name(e.id) << "\"";
+        has_arg = true;
+      }
+      if (info.arg_name != nullptr) {
+        out << (has_arg ? "," : "") << "\"" << info.arg_name << "\":" << e.arg;
+      }
+      out << "}}";
+      ++cnt;
+    }
+  }
+  out << "\n]}\n";
+  out.close();
+  if (!out) {
+    LOG(ERROR) << "write trace file " << file << " failed";
+    return false;
+  }
+  LOG(INFO) << "dump " << cnt << " trace events to " << file;
+  return true;
+}
+
+}  // namespace myframe
@@ -0,0 +1,123 @@
+/****************************************************************************
+Copyright (c) 2019, 李柯鹏
+All rights reserved.
+
+Author: 李柯鹏 <likepeng0418@163.com>
+****************************************************************************/
+#pragma once
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "myframe/macros.h"
+#include "myframe/msg.h"
+
+namespace myframe {
+
+class TraceRing;
+/**
+ * 运行轨迹记录
+ *
+ *  记录消息发送/分发/投递、actor调度及处理耗时、定时器超时事件，
+ *  导出为Chrome trace格式(JSON)，可以用 chrome://tracing 或者 Perfetto 打开。
+ *  每个线程写自己的环形缓冲区(单写者，不加锁)，缓冲区满后覆盖最早的事件;
+ *  未开始记录时每个记录点只有一次原子读。
+ *  时间戳使用 steady_clock(单调时钟)。
+ */
+class Tracer final {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /* 事件类型 */
+  enum class Event : uint8_t {
+    kSend,       ///< 外部线程发送消息(App::Send)
+    kDispatch,   ///< 分发消息
+    kEnqueue,    ///< 消息放入actor收件箱
+    kSchedule,   ///< actor交给工作线程处理
+    kProc,       ///< actor处理一批消息
+    kTimer,      ///< 定时器超时
+  };
+
+  static Tracer* Instance();
+
+  static bool Enabled() {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  /* 瞬时事件: id为相关地址句柄(没有时为 INVALID_ADDR_ID) */
+  static void Instant(Event ev, addr_id_t id, uint64_t arg = 0) {
+    if (Enabled()) {
+      Instance()->Write(ev, id, Clock::now(), Clock::time_point(), arg);
+    }
+  }
+  /* 时间段事件 */
+  static void Span(
+      Event ev,
+      addr_id_t id,
+      Clock::time_point begin,
+      Clock::time_point end,
+      uint64_t arg = 0) {
+    if (Enabled()) {
+      Instance()->Write(ev, id, begin, end, arg);
+    }
+  }
+
+  /**
+   * Start() - 开始记录
+   * @events_per_thread: 每个线程缓冲区的事件数(向上取2的幂),
+   *                     只在第一次开始记录时生效
+   *
+   *      清空之前记录的事件。
+   */
+  void Start(std::size_t events_per_thread = kDefaultCapacity);
+  /* 停止记录，已记录的事件保留到下一次 Start() */
+  void Stop();
+
+  /* 设置当前线程的名称，导出时用于标识线程 */
+  void SetThreadName(const std::string& name);
+
+  /**
+   * Dump() - 导出Chrome trace格式文件
+   * @addr_name: 地址句柄转换为地址名
+   *
+   *      建议在 Stop() 之后导出，记录中导出时正在覆盖的事件被跳过。
+   *
+   * @return:         成功返回: true, 失败返回: false
+   */
+  bool Dump(
+    const std::string& file,
+    const std::function<std::string(addr_id_t)>& addr_name);
+
+ private:
+  static constexpr std::size_t kDefaultCapacity = 32768;
+  /* 最多记录的线程数，超出的线程不记录 */
+  static constexpr std::size_t kMaxRings = 256;
+
+  Tracer() = default;
+  ~Tracer() = default;
+
+  void Write(
+    Event ev,
+    addr_id_t id,
+    Clock::time_point begin,
+    Clock::time_point end,
+    uint64_t arg);
+  /* 当前线程的缓冲区，第一次调用时创建 */
+  TraceRing* GetRing();
+
+  static std::atomic_bool enabled_;
+
+  std::mutex mtx_;
+  std::size_t capacity_{0};
+  std::vector<std::unique_ptr<TraceRing>> rings_;
+
+  DISALLOW_COPY_AND_ASSIGN(Tracer)
+};
+
+}  // namespace myframe
@@ -7,9 +7,14 @@ Author: 李柯鹏 <likepeng0418@163.com>
 
 #include "myframe/worker_common.h"
 
+#include <chrono>
+
 #include "myframe/log.h"
 #include "myframe/msg.h"
 #include "myframe/actor_context.h"
+#include "myframe/scheduler.h"
+#include "myframe/app.h"
+#include "myframe/trace.h"
 
 namespace myframe {
 
@@ -22,14 +27,54 @@ void WorkerCommon::Idle() {
 }
 
 void WorkerCommon::Run() {
+  if (scheduler_ != nullptr && !scheduler_->IsStop()) {
+    RunDirect();
+    return;
+  }
   if (-1 == DispatchMsg()) {
     return;
   }
   Work();
 }
 
+// actor发送的消息由工作线程直接投递给目的actor,
+// 其它消息交给主线程分发
+void WorkerCommon::RunDirect() {
+  auto ctx = scheduler_->Pop(GetCmdChannel()->GetSpinWait());
+  if (ctx == nullptr) {
+    return;
+  }
+  auto app = GetApp();
+  if (app == nullptr) {
+    return;
+  }
+  context_ = ctx;
+  Tracer::Instant(
+    Tracer::Event::kSchedule, ctx->GetMailbox()->AddrId(), index_);
+  if (ctx->PopInbox(&batch_msgs_, ctx->GetMaxBatchSize()) > 0) {
+    auto begin = std::chrono::steady_clock::now();
+    // 收件箱降到低水位后恢复被限流的发送者
+    auto limit = ctx->GetMailboxLimit();
+    if (limit->HasMuted() && ctx->InboxSize() <= limit->GetLowWatermark()) {
+      limit->UnmuteAll();
+    }
+    ctx->ProcBatch(batch_msgs_);
+    batch_msgs_.clear();
+    app->DirectDispatchMsg(ctx);
+    metrics_.OnBusy(std::chrono::steady_clock::now() - begin);
+  }
+  context_.reset();
+  // 被限流的actor等待Unmute()重新调度
+  if (!ctx->Park()) {
+    ctx->Yield();
+  }
+}
+
 void WorkerCommon::Init() {
   LOG(INFO) << "Worker " << GetWorkerName() << " init";
+  if (scheduler_ != nullptr) {
+    scheduler_->Bind(index_);
+  }
 }
 
 void WorkerCommon::Exit() {
@@ -42,10 +87,17 @@ int WorkerCommon::Work() {
     LOG(ERROR) << "context is nullptr";
     return -1;
   }
-  while (!GetMailbox()->RecvEmpty()) {
-    ctx->Proc(GetMailbox()->PopRecv());
+  auto begin = std::chrono::steady_clock::now();
+  auto mailbox = GetMailbox();
+  auto max_batch_size = ctx->GetMaxBatchSize();
+  while (!mailbox->RecvEmpty()) {
+    while (!mailbox->RecvEmpty() && batch_msgs_.size() < max_batch_size) {
+      batch_msgs_.emplace_back(mailbox->PopRecv());
+    }
+    ctx->ProcBatch(batch_msgs_);
+    batch_msgs_.clear();
   }
-
+  metrics_.OnBusy(std::chrono::steady_clock::now() - begin);
   return 0;
 }
 
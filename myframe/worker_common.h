@@ -7,15 +7,19 @@ Author: 李柯鹏 <likepeng0418@163.com>
 
 #pragma once
 #include <memory>
+#include <vector>
 
 #include "myframe/worker.h"
+#include "myframe/metrics.h"
 
 namespace myframe {
 
 class Msg;
 class ActorContext;
+class Scheduler;
 class WorkerCommon final : public Worker {
   friend class App;
+  friend class DispatchShard;
 
  public:
   WorkerCommon() = default;
@@ -36,14 +40,33 @@ class WorkerCommon final : public Worker {
     return context_.lock();
   }
 
+  /* 工作线程序号 */
+  std::size_t GetIndex() const { return index_; }
+
+  /* 运行指标 */
+  WorkerMetrics* GetMetrics() { return &metrics_; }
+
  private:
   /* 工作线程消息处理 */
   int Work();
   /* 工作线程进入空闲链表之前进行的操作 */
   void Idle();
+  /* 直接分发模式: 从调度器获得actor并处理消息 */
+  void RunDirect();
+  void SetScheduler(std::shared_ptr<Scheduler> scheduler) {
+    scheduler_ = scheduler;
+  }
+  void SetIndex(std::size_t index) { index_ = index; }
 
   /// 当前执行actor的指针
   std::weak_ptr<ActorContext> context_;
+  /// 直接分发模式的调度器
+  std::shared_ptr<Scheduler> scheduler_{nullptr};
+  std::size_t index_{0};
+  /// 每次调度批量处理的消息
+  std::vector<std::shared_ptr<const Msg>> batch_msgs_;
+  /// 运行指标
+  WorkerMetrics metrics_;
 };
 
 }  // namespace myframe
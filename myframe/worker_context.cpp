@@ -13,6 +13,7 @@ Author: 李柯鹏 <likepeng0418@163.com>
 #include "myframe/msg.h"
 #include "myframe/worker.h"
 #include "myframe/app.h"
+#include "myframe/trace.h"
 
 namespace myframe {
 
@@ -27,6 +28,8 @@ WorkerContext::WorkerContext(
 }
 
 WorkerContext::~WorkerContext() {
+  LOG_IF(INFO, mailbox_limit_.IsBounded())
+    << worker_->GetWorkerName() << " mailbox " << mailbox_limit_;
   LOG(INFO) << worker_->GetWorkerName() << " deconstruct";
 }
 
@@ -60,7 +63,13 @@ void WorkerContext::Join() {
 }
 
 void WorkerContext::Initialize() {
-  mailbox_.SetAddr(worker_->GetWorkerName());
+  if (!cpus_.empty() && Common::SetThreadAffinity(cpus_)) {
+    std::string cpus;
+    for (auto cpu : cpus_) {
+      cpus += " " + std::to_string(cpu);
+    }
+    LOG(INFO) << worker_->GetWorkerName() << " bind to cpu" << cpus;
+  }
   worker_->Init();
 }
 
@@ -68,11 +77,16 @@ void WorkerContext::ListenThread() {
   if (worker_ == nullptr) {
     return;
   }
+  Tracer::Instance()->SetThreadName(worker_->GetWorkerName());
   Initialize();
   while (runing_.load()) {
     worker_->Run();
   }
   worker_->Exit();
+  auto spin = cmd_channel_->GetSpinWait();
+  LOG_IF(INFO, spin->IsEnabled())
+    << worker_->GetWorkerName() << " spin " << spin->GetSpinCount()
+    << ", hit rate " << spin->GetHitRate();
   cmd_channel_->SendToMain(CmdChannel::Cmd::kQuit);
 }
 
@@ -11,10 +11,12 @@ Author: 李柯鹏 <likepeng0418@163.com>
 #include <memory>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include "myframe/macros.h"
 #include "myframe/event.h"
 #include "myframe/mailbox.h"
+#include "myframe/mailbox_limit.h"
 #include "myframe/cmd_channel.h"
 
 namespace myframe {
@@ -40,6 +42,8 @@ class WorkerContext final : public Event {
   void Join();
   bool IsRuning() { return runing_.load(); }
   std::thread::id GetThreadId() { return th_.get_id(); }
+  /* 线程绑定的cpu集合，在Start()之前设置 */
+  void SetCpuAffinity(const std::vector<int>& cpus) { cpus_ = cpus; }
 
   /// event 相关函数
   ev_handle_t GetHandle() const override;
@@ -47,6 +51,8 @@ class WorkerContext final : public Event {
   std::string GetName() const override;
 
   Mailbox* GetMailbox();
+  /* 接收缓存容量限制 */
+  MailboxLimit* GetMailboxLimit() { return &mailbox_limit_; }
 
   CmdChannel* GetCmdChannel();
 
@@ -92,6 +98,7 @@ class WorkerContext final : public Event {
 
   /// recv cache list
   std::list<std::shared_ptr<Msg>> cache_;
+  MailboxLimit mailbox_limit_;
 
   /// mailbox
   Mailbox mailbox_;
@@ -101,6 +108,7 @@ class WorkerContext final : public Event {
 
   /// thread
   std::thread th_;
+  std::vector<int> cpus_;
 
   DISALLOW_COPY_AND_ASSIGN(WorkerContext)
 };
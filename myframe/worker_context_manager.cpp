@@ -12,6 +12,7 @@ Author: 李柯鹏 <likepeng0418@163.com>
 #include "myframe/worker.h"
 #include "myframe/worker_context.h"
 #include "myframe/event_manager.h"
+#include "myframe/app.h"
 
 namespace myframe {
 
@@ -36,6 +37,14 @@ bool WorkerContextManager::Add(std::shared_ptr<WorkerContext> worker_ctx) {
   if (!ev_mgr_->Add(worker_ctx)) {
     return false;
   }
+  auto id = worker_ctx->GetMailbox()->AddrId();
+  if (id != INVALID_ADDR_ID) {
+    std::unique_lock<std::shared_mutex> lk(rw_);
+    if (id >= id_workers_ctx_.size()) {
+      id_workers_ctx_.resize(id + 1);
+    }
+    id_workers_ctx_[id] = worker_ctx;
+  }
   cur_worker_count_.fetch_add(1);
   return true;
 }
@@ -45,41 +54,14 @@ void WorkerContextManager::Del(std::shared_ptr<WorkerContext> worker_ctx) {
     return;
   }
   std::unique_lock<std::shared_mutex> lk(rw_);
+  auto id = worker_ctx->GetMailbox()->AddrId();
+  if (id < id_workers_ctx_.size()) {
+    id_workers_ctx_[id] = nullptr;
+  }
   stoped_workers_ctx_.push_back(worker_ctx);
   cur_worker_count_.fetch_sub(1);
 }
 
-int WorkerContextManager::IdleWorkerSize() {
-  int sz = 0;
-  std::shared_lock<std::shared_mutex> lk(rw_);
-  sz = idle_workers_ctx_.size();
-  return sz;
-}
-
-std::shared_ptr<WorkerContext> WorkerContextManager::FrontIdleWorker() {
-  std::shared_ptr<WorkerContext> w = nullptr;
-  std::shared_lock<std::shared_mutex> lk(rw_);
-  if (idle_workers_ctx_.empty()) {
-    return nullptr;
-  }
-  w = idle_workers_ctx_.front().lock();
-  return w;
-}
-
-void WorkerContextManager::PopFrontIdleWorker() {
-  std::unique_lock<std::shared_mutex> lk(rw_);
-  if (idle_workers_ctx_.empty()) {
-    return;
-  }
-  idle_workers_ctx_.pop_front();
-}
-
-void WorkerContextManager::PushBackIdleWorker(
-  std::shared_ptr<WorkerContext> worker) {
-  std::unique_lock<std::shared_mutex> lk(rw_);
-  idle_workers_ctx_.emplace_back(worker);
-}
-
 std::vector<std::string> WorkerContextManager::GetAllUserWorkerAddr() {
   std::vector<std::string> res;
   std::shared_lock<std::shared_mutex> lk(rw_);
@@ -138,6 +120,10 @@ void WorkerContextManager::WeakupWorker() {
       continue;
     }
     worker_ctx->GetMailbox()->Recv(worker_ctx->GetCache());
+    // 缓存已经交给工作线程，恢复被限流的发送者
+    if (worker_ctx->GetMailboxLimit()->HasMuted()) {
+      worker_ctx->GetMailboxLimit()->UnmuteAll();
+    }
     it = weakup_workers_ctx_.erase(it);
     worker_ctx->SetCtrlOwnerFlag(WorkerContext::CtrlOwner::kWorker);
     worker_ctx->SetWaitMsgQueueFlag(false);
@@ -146,22 +132,40 @@ void WorkerContextManager::WeakupWorker() {
   }
 }
 
-void WorkerContextManager::DispatchWorkerMsg(
+bool WorkerContextManager::DispatchWorkerMsg(
     std::shared_ptr<Msg> msg,
-    const std::string& dst) {
-  std::string worker_name = dst.empty() ? msg->GetDst() : dst;
-  if (!ev_mgr_->Has(worker_name)) {
-    LOG(ERROR) << "can't find worker " << worker_name << ", drop msg: from "
-               << msg->GetSrc() << " to " << msg->GetDst();
-    return;
+    addr_id_t dst) {
+  std::shared_ptr<WorkerContext> worker_ctx = nullptr;
+  {
+    std::shared_lock<std::shared_mutex> lk(rw_);
+    if (dst < id_workers_ctx_.size()) {
+      worker_ctx = id_workers_ctx_[dst];
+    }
+  }
+  if (worker_ctx == nullptr) {
+    return false;
   }
-  auto worker_ctx = ev_mgr_->Get<WorkerContext>(worker_name);
-  auto worker = worker_ctx->GetWorker<Worker>();
-  auto worker_type = worker->GetType();
+  auto worker_type = worker_ctx->GetType();
   if (worker_type == Event::Type::kWorkerTimer ||
       worker_type == Event::Type::kWorkerCommon) {
-    LOG(WARNING) << worker_name << " unsupport recv msg, drop it";
-    return;
+    LOG(WARNING) << worker_ctx->GetName() << " unsupport recv msg, drop it";
+    return true;
+  }
+  // 接收缓存容量限制
+  auto limit = worker_ctx->GetMailboxLimit();
+  if (limit->IsBounded()) {
+    auto app = worker_ctx->GetApp();
+    if (app == nullptr) {
+      return false;
+    }
+    bool drop_oldest = false;
+    if (!app->CheckMailboxLimit(
+        limit, worker_ctx->CacheSize(), msg, dst, &drop_oldest)) {
+      return true;
+    }
+    if (drop_oldest) {
+      worker_ctx->GetCache()->pop_front();
+    }
   }
   worker_ctx->Cache(msg);
   LOG_IF(WARNING,
@@ -170,11 +174,12 @@ void WorkerContextManager::DispatchWorkerMsg(
       << " msg not process!!!";
   if (worker_ctx->IsInWaitMsgQueue()) {
     VLOG(1) << *worker_ctx << " already in wait queue, return";
-    return;
+    return true;
   }
   worker_ctx->SetWaitMsgQueueFlag(true);
   std::unique_lock<std::shared_mutex> lk(rw_);
   weakup_workers_ctx_.emplace_back(worker_ctx);
+  return true;
 }
 
 }  // namespace myframe
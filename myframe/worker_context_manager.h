@@ -17,10 +17,10 @@ Author: 李柯鹏 <likepeng0418@163.com>
 
 #include "myframe/macros.h"
 #include "myframe/event.h"
+#include "myframe/msg.h"
 
 namespace myframe {
 
-class Msg;
 class EventManager;
 class WorkerContext;
 class WorkerContextManager final {
@@ -35,18 +35,13 @@ class WorkerContextManager final {
   bool Add(std::shared_ptr<WorkerContext> worker);
   void Del(std::shared_ptr<WorkerContext> worker);
 
-  // 内置工作线程池
-  int IdleWorkerSize();
-  std::shared_ptr<WorkerContext> FrontIdleWorker();
-  void PopFrontIdleWorker();
-  void PushBackIdleWorker(std::shared_ptr<WorkerContext> worker);
-
   // 用户工作线程
   void PushWaitWorker(std::shared_ptr<WorkerContext> worker);
   void WeakupWorker();
-  void DispatchWorkerMsg(
+  /* 分发消息给地址句柄对应的worker，worker不存在返回false */
+  bool DispatchWorkerMsg(
     std::shared_ptr<Msg> msg,
-    const std::string& dst = "");
+    addr_id_t dst);
 
   std::vector<std::string> GetAllUserWorkerAddr();
 
@@ -60,10 +55,10 @@ class WorkerContextManager final {
   std::atomic_int cur_worker_count_{0};
   /// 读写锁
   std::shared_mutex rw_;
-  /// 空闲线程链表
-  std::list<std::weak_ptr<WorkerContext>> idle_workers_ctx_;
   /// 有消息user线程
   std::list<std::weak_ptr<WorkerContext>> weakup_workers_ctx_;
+  /// index: addr id, value: worker context
+  std::vector<std::shared_ptr<WorkerContext>> id_workers_ctx_;
   /// 停止的线程列表
   std::list<std::shared_ptr<WorkerContext>> stoped_workers_ctx_;
   /// 事件管理对象
@@ -11,33 +11,60 @@ Author: 李柯鹏 <likepeng0418@163.com>
 #include <thread>
 
 #include "myframe/log.h"
+#include "myframe/msg_pool.h"
 #include "myframe/actor.h"
 #include "myframe/app.h"
+#include "myframe/trace.h"
 
 namespace myframe {
 
-uint64_t TimerManager::GetMonoTimeMs() {
-  auto now = std::chrono::steady_clock::now();
-  return now.time_since_epoch().count() / 1e6;
+uint64_t TimerManager::GetMonoTimeNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 
-TimerManager::TimerManager() {
+TimerManager::TimerManager() : time_(0) {
   tv_[0] = tv2_;
   tv_[1] = tv3_;
   tv_[2] = tv4_;
   tv_[3] = tv5_;
+  for (uint32_t i = 0; i < kMaxChunk; ++i) {
+    chunks_[i].store(nullptr, std::memory_order_relaxed);
+  }
+
+  cur_point_ = GetMonoTimeNs() / res_ns_;
+}
 
-  cur_point_ = GetMonoTimeMs() / 10;
+TimerManager::~TimerManager() {
+  // 先清空时间轮链表，再释放节点
+  for (auto& l : tv1_) { l.Clear(); }
+  for (int i = 0; i < 4; ++i) {
+    for (int j = 0; j < TVN_SIZE; ++j) {
+      tv_[i][j].Clear();
+    }
+  }
+  auto size = chunk_size_.load();
+  for (uint32_t i = 0; i < size; ++i) {
+    delete[] chunks_[i].load();
+  }
 }
 
-TimerManager::~TimerManager() {}
+void TimerManager::SetResolution(int resolution_us) {
+  if (resolution_us <= 0) {
+    LOG(WARNING) << "invalid timer resolution " << resolution_us
+      << "us, use " << GetResolution() << "us";
+    return;
+  }
+  res_ns_ = resolution_us * 1000ULL;
+  cur_point_ = GetMonoTimeNs() / res_ns_;
+}
 
 void TimerManager::_AddTimerNode(Timer* node) {
   uint32_t time = node->expire_;
   uint32_t cur_time = time_;
 
   if ((time | TVR_MASK) == (cur_time | TVR_MASK)) {
-    tv1_[time & TVR_MASK].AddTail(node);
+    node->list_ = &tv1_[time & TVR_MASK];
   } else {
     int i;
     uint32_t mask = TVR_SIZE << TVN_BITS;
@@ -47,26 +74,357 @@ void TimerManager::_AddTimerNode(Timer* node) {
       }
       mask <<= TVN_BITS;
     }
-    tv_[i][((time >> (TVR_BITS + i * TVN_BITS)) & TVN_MASK)].AddTail(node);
+    node->list_ =
+      &tv_[i][((time >> (TVR_BITS + i * TVN_BITS)) & TVN_MASK)];
+  }
+  node->list_->AddTail(node);
+}
+
+void TimerManager::_DelTimerNode(Timer* node) {
+  if (node->list_ != nullptr) {
+    node->list_->Del(node);
+    node->list_ = nullptr;
+  }
+}
+
+// 超时时刻对应的滴答, 至少为下一个滴答
+uint32_t TimerManager::_ToTick(uint64_t deadline_ns) {
+  uint64_t point = (deadline_ns + res_ns_ - 1) / res_ns_;
+  if (point <= cur_point_) {
+    return time_ + 1;
+  }
+  return time_ + static_cast<uint32_t>(point - cur_point_);
+}
+
+bool TimerManager::_Grow() {
+  std::lock_guard<std::mutex> lk(grow_mtx_);
+  if ((free_head_.load() & 0xffffffff) != 0) {
+    return true;
+  }
+  auto n = chunk_size_.load();
+  if (n >= kMaxChunk) {
+    LOG(ERROR) << "timer pool is full, capacity " << Capacity();
+    return false;
+  }
+  // 新块内的节点串成链表后整体放入空闲链表
+  auto chunk = new Timer[kChunkSize];
+  for (uint32_t i = 0; i < kChunkSize; ++i) {
+    chunk[i].index_ = n * kChunkSize + i;
+    chunk[i].fnext_.store(
+      i + 1 < kChunkSize ? chunk[i].index_ + 2 : 0,
+      std::memory_order_relaxed);
+  }
+  chunks_[n].store(chunk, std::memory_order_release);
+  chunk_size_.store(n + 1, std::memory_order_release);
+  auto last = &chunk[kChunkSize - 1];
+  uint64_t head = free_head_.load(std::memory_order_relaxed);
+  uint64_t new_head;
+  do {
+    last->fnext_.store(head & 0xffffffff, std::memory_order_relaxed);
+    new_head = (((head >> 32) + 1) << 32) | (chunk[0].index_ + 1);
+  } while (!free_head_.compare_exchange_weak(
+      head, new_head, std::memory_order_acq_rel, std::memory_order_relaxed));
+  VLOG(1) << "timer pool grow to " << Capacity();
+  return true;
+}
+
+Timer* TimerManager::_Alloc() {
+  uint64_t head = free_head_.load(std::memory_order_acquire);
+  while (true) {
+    uint32_t idx = head & 0xffffffff;
+    if (idx == 0) {
+      if (!_Grow()) {
+        return nullptr;
+      }
+      head = free_head_.load(std::memory_order_acquire);
+      continue;
+    }
+    auto node = _At(idx - 1);
+    uint64_t new_head = (((head >> 32) + 1) << 32)
+      | node->fnext_.load(std::memory_order_relaxed);
+    if (free_head_.compare_exchange_weak(
+        head, new_head,
+        std::memory_order_acq_rel, std::memory_order_acquire)) {
+      node->snext_ = nullptr;
+      return node;
+    }
+  }
+}
+
+void TimerManager::_Free(Timer* node) {
+  // 版本号加一，之前的句柄失效
+  node->gen_.fetch_add(1, std::memory_order_release);
+  uint64_t head = free_head_.load(std::memory_order_relaxed);
+  uint64_t new_head;
+  do {
+    node->fnext_.store(head & 0xffffffff, std::memory_order_relaxed);
+    new_head = (((head >> 32) + 1) << 32) | (node->index_ + 1);
+  } while (!free_head_.compare_exchange_weak(
+      head, new_head, std::memory_order_release, std::memory_order_relaxed));
+}
+
+Timer* TimerManager::_Get(timer_handle_t handle) {
+  uint32_t idx = static_cast<uint32_t>(handle & 0xffffffff);
+  if (idx == 0 || idx > Capacity()) {
+    return nullptr;
+  }
+  auto node = _At(idx - 1);
+  if (node->gen_.load(std::memory_order_acquire)
+      != static_cast<uint32_t>(handle >> 32)) {
+    return nullptr;
+  }
+  return node;
+}
+
+const std::string* TimerManager::_Intern(
+    const std::string& name,
+    uint32_t* id) {
+  {
+    std::shared_lock<std::shared_mutex> lk(names_mtx_);
+    auto it = name_ids_.find(name);
+    if (it != name_ids_.end()) {
+      *id = it->second;
+      return &names_[it->second];
+    }
+  }
+  std::unique_lock<std::shared_mutex> lk(names_mtx_);
+  auto it = name_ids_.find(name);
+  if (it != name_ids_.end()) {
+    *id = it->second;
+    return &names_[it->second];
+  }
+  *id = static_cast<uint32_t>(names_.size());
+  names_.emplace_back(name);
+  name_ids_.emplace(name, *id);
+  return &names_.back();
+}
+
+// 压入提交链表，比定时器线程的唤醒时刻早时提前唤醒
+void TimerManager::_Submit(Timer* node, uint64_t deadline_ns) {
+  node->deadline_ns_ = deadline_ns;
+  Timer* head = submit_head_.load(std::memory_order_relaxed);
+  do {
+    node->snext_ = head;
+  } while (!submit_head_.compare_exchange_weak(head, node));
+  if (deadline_ns != 0 && waiting_.load()
+      && deadline_ns < wake_ns_.load(std::memory_order_relaxed)) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (!notified_) {
+      notified_ = true;
+      cv_.notify_one();
+    }
+  }
+}
+
+timer_handle_t TimerManager::Timeout(
+    const std::string& actor_name,
+    const std::string& timer_name,
+    std::chrono::nanoseconds expired,
+    std::chrono::nanoseconds period,
+    bool named) {
+  if (expired.count() <= 0 || period.count() < 0) {
+    return INVALID_TIMER_HANDLE;
+  }
+  auto timer = _Alloc();
+  if (timer == nullptr) {
+    return INVALID_TIMER_HANDLE;
+  }
+  timer->actor_name_ = _Intern(actor_name, &timer->actor_id_);
+  timer->timer_name_ = _Intern(timer_name, &timer->name_id_);
+  timer->op_ = Timer::Op::kAdd;
+  timer->want_named_ = named;
+  timer->period_ns_ = period.count();
+  auto handle = _ToHandle(
+    timer, timer->gen_.load(std::memory_order_relaxed));
+  _Submit(timer, GetMonoTimeNs() + expired.count());
+  return handle;
+}
+
+int TimerManager::Reset(
+    timer_handle_t handle,
+    std::chrono::nanoseconds expired) {
+  if (expired.count() <= 0 || _Get(handle) == nullptr) {
+    return -1;
+  }
+  auto cmd = _Alloc();
+  if (cmd == nullptr) {
+    return -1;
   }
+  cmd->op_ = Timer::Op::kReset;
+  cmd->target_ = handle;
+  _Submit(cmd, GetMonoTimeNs() + expired.count());
+  return 0;
 }
 
-int TimerManager::Timeout(
+int TimerManager::Cancel(
     const std::string& actor_name,
-    const std::string& timer_name, int time) {
-  if (time <= 0) return -1;
-  Timer* timer = new Timer();
-  timer->actor_name_ = actor_name;
-  timer->timer_name_ = timer_name;
-
-  // add node
-  mtx_.lock();
-  timer->expire_ = time + time_;
-  _AddTimerNode(timer);
-  mtx_.unlock();
+    const std::string& timer_name) {
+  uint32_t actor_id;
+  uint32_t name_id;
+  {
+    std::shared_lock<std::shared_mutex> lk(names_mtx_);
+    auto actor_it = name_ids_.find(actor_name);
+    auto name_it = name_ids_.find(timer_name);
+    if (actor_it == name_ids_.end() || name_it == name_ids_.end()) {
+      return -1;
+    }
+    actor_id = actor_it->second;
+    name_id = name_it->second;
+  }
+  auto cmd = _Alloc();
+  if (cmd == nullptr) {
+    return -1;
+  }
+  cmd->op_ = Timer::Op::kCancelName;
+  cmd->actor_id_ = actor_id;
+  cmd->name_id_ = name_id;
+  _Submit(cmd, 0);
+  return 0;
+}
+
+int TimerManager::Cancel(timer_handle_t handle) {
+  if (_Get(handle) == nullptr) {
+    return -1;
+  }
+  auto cmd = _Alloc();
+  if (cmd == nullptr) {
+    return -1;
+  }
+  cmd->op_ = Timer::Op::kCancel;
+  cmd->target_ = handle;
+  _Submit(cmd, 0);
   return 0;
 }
 
+// 取出提交链表，按提交顺序处理
+void TimerManager::_Drain() {
+  Timer* node = submit_head_.exchange(nullptr, std::memory_order_acquire);
+  Timer* prev = nullptr;
+  while (node != nullptr) {
+    auto next = node->snext_;
+    node->snext_ = prev;
+    prev = node;
+    node = next;
+  }
+  while (prev != nullptr) {
+    // 节点处理后可能被归还并被其它线程取走
+    auto next = prev->snext_;
+    _Apply(prev);
+    prev = next;
+  }
+}
+
+void TimerManager::_Apply(Timer* node) {
+  Timer* timer = nullptr;
+  switch (node->op_) {
+    case Timer::Op::kAdd:
+      if (node->want_named_) {
+        _Link(node);
+      }
+      active_size_.fetch_add(1, std::memory_order_relaxed);
+      _Schedule(node, node->deadline_ns_);
+      return;
+    case Timer::Op::kReset:
+      timer = _Get(node->target_);
+      if (timer != nullptr && timer->list_ != nullptr) {
+        _DelTimerNode(timer);
+        _Schedule(timer, node->deadline_ns_);
+      }
+      break;
+    case Timer::Op::kCancel:
+      timer = _Get(node->target_);
+      if (timer != nullptr && timer->list_ != nullptr) {
+        _Release(timer);
+      }
+      break;
+    case Timer::Op::kCancelName:
+      while ((timer = _Find(node->actor_id_, node->name_id_)) != nullptr) {
+        _Release(timer);
+      }
+      break;
+  }
+  _Release(node);
+}
+
+void TimerManager::_Schedule(Timer* node, uint64_t deadline_ns) {
+  node->deadline_ns_ = deadline_ns;
+  node->expire_ = _ToTick(deadline_ns);
+  _AddTimerNode(node);
+}
+
+void TimerManager::_Release(Timer* node) {
+  if (node->op_ == Timer::Op::kAdd) {
+    active_size_.fetch_sub(1, std::memory_order_relaxed);
+  }
+  _DelTimerNode(node);
+  if (node->named_) {
+    _Unlink(node);
+  }
+  node->period_ns_ = 0;
+  _Free(node);
+}
+
+uint32_t& TimerManager::_Bucket(uint32_t actor_id, uint32_t name_id) {
+  uint32_t h = (actor_id * 0x9E3779B1u) ^ (name_id * 0x85EBCA6Bu);
+  return buckets_[h & (buckets_.size() - 1)];
+}
+
+Timer* TimerManager::_Find(uint32_t actor_id, uint32_t name_id) {
+  if (buckets_.empty()) {
+    return nullptr;
+  }
+  auto idx = _Bucket(actor_id, name_id);
+  while (idx != 0) {
+    auto node = _At(idx - 1);
+    if (node->actor_id_ == actor_id && node->name_id_ == name_id) {
+      return node;
+    }
+    idx = node->hnext_;
+  }
+  return nullptr;
+}
+
+void TimerManager::_Link(Timer* node) {
+  if (named_size_ >= buckets_.size()) {
+    _Rehash();
+  }
+  auto& head = _Bucket(node->actor_id_, node->name_id_);
+  node->hnext_ = head;
+  head = node->index_ + 1;
+  node->named_ = true;
+  ++named_size_;
+}
+
+void TimerManager::_Unlink(Timer* node) {
+  auto p = &_Bucket(node->actor_id_, node->name_id_);
+  while (*p != 0) {
+    if (*p == node->index_ + 1) {
+      *p = node->hnext_;
+      break;
+    }
+    p = &_At(*p - 1)->hnext_;
+  }
+  node->hnext_ = 0;
+  node->named_ = false;
+  --named_size_;
+}
+
+// 哈希表容量翻倍，重新链接所有同名索引的定时器
+void TimerManager::_Rehash() {
+  std::size_t size = buckets_.empty() ? 64 : buckets_.size() * 2;
+  buckets_.assign(size, 0);
+  auto cap = static_cast<uint32_t>(Capacity());
+  for (uint32_t i = 0; i < cap; ++i) {
+    auto node = _At(i);
+    if (!node->named_) {
+      continue;
+    }
+    auto& head = _Bucket(node->actor_id_, node->name_id_);
+    node->hnext_ = head;
+    head = node->index_ + 1;
+  }
+}
+
 void TimerManager::_Dispath(List* cur) {
   Timer* timer;
   ListNode* begin;
@@ -78,14 +436,34 @@ void TimerManager::_Dispath(List* cur) {
   for (; begin != end;) {
     temp = begin->next;
     cur->Del(begin);
-    timer = dynamic_cast<Timer*>(begin);
-    auto msg = std::make_shared<Msg>();
+    timer = static_cast<Timer*>(begin);
+    timer->list_ = nullptr;
+    auto msg = MsgPool::Instance()->Get();
     msg->SetSrc("worker.timer");
-    msg->SetDst(timer->actor_name_);
-    msg->SetDesc(timer->timer_name_);
+    msg->SetDst(*timer->actor_name_);
+    msg->SetDesc(*timer->timer_name_);
     msg->SetType("TIMER");
-    delete begin;
+    msg->SetPriority(Msg::Priority::kHigh);
+    // 独立定时器带上句柄，用于匹配超时消息
+    if (!timer->want_named_) {
+      msg->SetCorrelationId(
+        _ToHandle(timer, timer->gen_.load(std::memory_order_relaxed)));
+    }
     timeout_list_.emplace_back(msg);
+    if (timer->period_ns_ > 0) {
+      // 周期定时器按上一次的超时时刻计算下一次超时，避免误差累积;
+      // 错过的周期直接跳过
+      timer->deadline_ns_ += timer->period_ns_;
+      auto now = cur_point_ * res_ns_;
+      if (timer->deadline_ns_ <= now) {
+        auto missed = (now - timer->deadline_ns_) / timer->period_ns_ + 1;
+        timer->deadline_ns_ += missed * timer->period_ns_;
+      }
+      timer->expire_ = _ToTick(timer->deadline_ns_);
+      _AddTimerNode(timer);
+    } else {
+      _Release(timer);
+    }
     begin = temp;
   }
 }
@@ -108,7 +486,7 @@ void TimerManager::_MoveList(int level, int idx) {
   for (; begin != end;) {
     temp = begin->next;
     cur->Del(begin);
-    timer = dynamic_cast<Timer*>(begin);
+    timer = static_cast<Timer*>(begin);
     _AddTimerNode(timer);
     begin = temp;
   }
@@ -116,6 +494,7 @@ void TimerManager::_MoveList(int level, int idx) {
 void TimerManager::_Shift() {
   int mask = TVR_SIZE;
   uint32_t ct = ++time_;
+  ++cur_point_;
   if (ct == 0) {
     _MoveList(3, 0);
   } else {
@@ -135,43 +514,77 @@ void TimerManager::_Shift() {
   }
 }
 void TimerManager::_Updatetime() {
-  mtx_.lock();
   _Execute();
   _Shift();
   _Execute();
-  mtx_.unlock();
 }
 std::list<std::shared_ptr<Msg>>* TimerManager::Updatetime() {
-  uint64_t cp = GetMonoTimeMs() / MY_RESOLUTION_MS;
+  _Drain();
+  uint64_t cp = GetMonoTimeNs() / res_ns_;
   if (cp < cur_point_) {
     LOG(ERROR) << "Future time: " << cp << ":" << cur_point_;
     cur_point_ = cp;
-  } else if (cp != cur_point_) {
-    uint32_t diff = static_cast<uint32_t>(cp - cur_point_);
-    cur_point_ = cp;
-    for (std::size_t i = 0; i < diff; ++i) {
+  } else {
+    while (cur_point_ < cp) {
       _Updatetime();
     }
   }
   return &timeout_list_;
 }
 
+// 距离下一个需要处理的滴答数: tv1中下一个有定时器的滴答，
+// 或者下一次需要重新分配定时器区间的滴答
+uint32_t TimerManager::_NextTick() {
+  uint32_t remain = TVR_SIZE - (time_ & TVR_MASK);
+  for (uint32_t i = 1; i < remain; ++i) {
+    if (!tv1_[(time_ + i) & TVR_MASK].IsEmpty()) {
+      return i;
+    }
+  }
+  return remain;
+}
+
+void TimerManager::WaitUntil(std::chrono::steady_clock::time_point tp) {
+  _Drain();
+  auto next_tp = std::chrono::steady_clock::time_point(
+    std::chrono::nanoseconds((cur_point_ + _NextTick()) * res_ns_));
+  if (next_tp < tp) {
+    tp = next_tp;
+  }
+  wake_ns_.store(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(
+      tp.time_since_epoch()).count(),
+    std::memory_order_relaxed);
+  std::unique_lock<std::mutex> lk(mtx_);
+  waiting_.store(true);
+  // 设置等待标志之后还有提交，不睡眠
+  if (submit_head_.load() == nullptr) {
+    cv_.wait_until(lk, tp, [this]() { return notified_; });
+  }
+  waiting_.store(false);
+  notified_ = false;
+}
+
 //////////////////////////////////////////////////////
 
 WorkerTimer::~WorkerTimer() {}
 
+// 处理超时的定时器后睡眠到下一个定时器超时;
+// 空闲时至少每 dispatch_timeout_ 与主线程交互一次，以便响应退出
 void WorkerTimer::Run() {
   int dispatch = Work();
-  if (dispatch || cur_us_ >= dispatch_timeout_us_) {
+  auto now = std::chrono::steady_clock::now();
+  if (dispatch || now - last_dispatch_ >= dispatch_timeout_) {
     DispatchMsg();
-    cur_us_ = 0;
+    last_dispatch_ = now;
   }
-  std::this_thread::sleep_for(std::chrono::microseconds(sleep_us_));
-  cur_us_ += sleep_us_;
+  timer_mgr_.WaitUntil(last_dispatch_ + dispatch_timeout_);
 }
 
 void WorkerTimer::Init() {
-  LOG(INFO) << "timer worker " << GetWorkerName() << " init";
+  last_dispatch_ = std::chrono::steady_clock::now();
+  LOG(INFO) << "timer worker " << GetWorkerName() << " init, resolution "
+    << timer_mgr_.GetResolution() << "us";
 }
 
 void WorkerTimer::Exit() {
@@ -182,13 +595,56 @@ int WorkerTimer::SetTimeout(
   const std::string& actor_name,
   const std::string& timer_name,
   int time) {
+  return SetTimeout(actor_name, timer_name,
+    std::chrono::milliseconds(time * MY_RESOLUTION_MS));
+}
+
+int WorkerTimer::SetTimeout(
+  const std::string& actor_name,
+  const std::string& timer_name,
+  std::chrono::nanoseconds expired,
+  std::chrono::nanoseconds period) {
+  VLOG(1) << actor_name << " set timeout(" << timer_name
+    << "): " << expired.count() << "ns, period " << period.count() << "ns";
+  auto handle = timer_mgr_.Timeout(actor_name, timer_name, expired, period);
+  return handle == INVALID_TIMER_HANDLE ? -1 : 0;
+}
+
+int WorkerTimer::SetTimeout(
+  const std::string& actor_name,
+  const std::string& timer_name,
+  std::chrono::nanoseconds expired,
+  timer_handle_t* handle) {
   VLOG(1) << actor_name << " set timeout(" << timer_name
-             << "): " << (time * 10) << "ms";
-  return timer_mgr_.Timeout(actor_name, timer_name, time);
+    << "): " << expired.count() << "ns";
+  *handle = timer_mgr_.Timeout(
+    actor_name, timer_name, expired, std::chrono::nanoseconds(0), false);
+  return *handle == INVALID_TIMER_HANDLE ? -1 : 0;
+}
+
+int WorkerTimer::ResetTimeout(
+  timer_handle_t handle,
+  std::chrono::nanoseconds expired) {
+  return timer_mgr_.Reset(handle, expired);
+}
+
+int WorkerTimer::CancelTimeout(timer_handle_t handle) {
+  return timer_mgr_.Cancel(handle);
+}
+
+int WorkerTimer::CancelTimeout(
+  const std::string& actor_name,
+  const std::string& timer_name) {
+  VLOG(1) << actor_name << " cancel timeout(" << timer_name << ")";
+  return timer_mgr_.Cancel(actor_name, timer_name);
 }
 
 int WorkerTimer::Work() {
   auto timeout_list = timer_mgr_.Updatetime();
+  if (!timeout_list->empty()) {
+    Tracer::Instant(
+      Tracer::Event::kTimer, INVALID_ADDR_ID, timeout_list->size());
+  }
   GetMailbox()->Send(timeout_list);
   return GetMailbox()->SendSize();
 }
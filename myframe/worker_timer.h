@@ -6,10 +6,17 @@ Author: 李柯鹏 <likepeng0418@163.com>
 ****************************************************************************/
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <list>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "myframe/list.h"
 #include "myframe/msg.h"
@@ -22,7 +29,10 @@ Author: 李柯鹏 <likepeng0418@163.com>
 #define TVN_MASK (TVN_SIZE - 1)
 #define TVR_MASK (TVR_SIZE - 1)
 
+/// Actor::Timeout(timer_name, int) 的时间单位
 #define MY_RESOLUTION_MS 10
+/// 定时器默认精度
+#define MY_TIMER_RESOLUTION_US 1000
 
 namespace myframe {
 
@@ -33,32 +43,158 @@ class Timer final : public ListNode {
   Timer() {}
   virtual ~Timer() {}
 
-  std::string actor_name_;
-  std::string timer_name_;
+  /// 提交给定时器线程的操作
+  enum class Op : uint8_t {
+    kAdd,         ///< 新定时器(节点本身)
+    kReset,       ///< 重新设置target_
+    kCancel,      ///< 取消target_
+    kCancelName,  ///< 按名字取消
+  };
+
+  /// 驻留的actor名/定时器名，字符串在TimerManager中地址不变
+  uint32_t actor_id_{0};
+  uint32_t name_id_{0};
+  const std::string* actor_name_{nullptr};
+  const std::string* timer_name_{nullptr};
+  /// 在节点池中的位置及版本号，组成定时器句柄
+  uint32_t index_{0};
+  std::atomic<uint32_t> gen_{0};
+  /// 空闲链表的下一个节点(index + 1, 0表示没有)
+  std::atomic<uint32_t> fnext_{0};
+  /// 提交链表的下一个节点
+  Timer* snext_{nullptr};
+  Op op_{Op::kAdd};
+  timer_handle_t target_{INVALID_TIMER_HANDLE};
+  /// 是否按名字索引(kAdd)
+  bool want_named_{false};
+  /// 同名索引哈希链表的下一个节点(index + 1, 0表示没有)
+  uint32_t hnext_{0};
+  /// 是否加入同名索引
+  bool named_{false};
+  /// 所在的时间轮链表
+  List* list_{nullptr};
   uint32_t expire_;  // interval
-  bool run_;
+  /// 周期定时器的周期及下一次的超时时刻(单调时钟，单位ns)
+  uint64_t period_ns_{0};
+  uint64_t deadline_ns_{0};
 };
 
+/**
+ * 定时器管理
+ *
+ *  定时器节点从按块分配的节点池中获取，超时/取消后归还，
+ *  actor名/定时器名驻留为整数id，设置和超时都不需要分配内存。
+ *  设置定时器返回句柄(节点位置+版本号)，可以O(1)取消或者重新设置;
+ *  按名字设置的定时器通过侵入式哈希表索引，同名定时器可以同时存在多个，
+ *  按名字取消时全部取消。
+ *
+ *  时间轮只由定时器线程访问：其它线程从无锁空闲链表取节点，
+ *  填好后压入无锁提交链表，由定时器线程在推进时间轮之前按提交顺序处理，
+ *  设置定时器不需要等待时间轮推进。
+ */
 class TimerManager final {
  public:
   TimerManager();
   virtual ~TimerManager();
 
-  int Timeout(
+  /* 设置定时器精度，在定时器线程启动之前调用 */
+  void SetResolution(int resolution_us);
+  int GetResolution() const { return static_cast<int>(res_ns_ / 1000); }
+
+  /* 设置定时器, period > 0 时为周期定时器
+   * 每次都是新的定时器，不会替换同名定时器;
+   * named 为 true 时可以按名字取消，否则只能通过句柄取消
+   * 失败返回 INVALID_TIMER_HANDLE */
+  timer_handle_t Timeout(
     const std::string& actor_name,
     const std::string& timer_name,
-    int time);
+    std::chrono::nanoseconds expired,
+    std::chrono::nanoseconds period = std::chrono::nanoseconds(0),
+    bool named = true);
+  /* 重新设置未超时的定时器，周期不变
+   * 句柄已失效返回-1, 提交时恰好超时的定时器不会被重新设置 */
+  int Reset(timer_handle_t handle, std::chrono::nanoseconds expired);
+  /* 取消未超时的定时器, 按名字取消时取消该actor所有同名的定时器 */
+  int Cancel(
+    const std::string& actor_name,
+    const std::string& timer_name);
+  int Cancel(timer_handle_t handle);
 
+  /* 以下函数只能在定时器线程调用 */
   std::list<std::shared_ptr<Msg>>* Updatetime();
 
+  /* 睡眠直到下一个定时器超时、有更早的定时器提交或者到达tp */
+  void WaitUntil(std::chrono::steady_clock::time_point tp);
+
+  /* 节点池容量/未超时的定时器数 */
+  std::size_t Capacity() const {
+    return chunk_size_.load(std::memory_order_acquire) * kChunkSize;
+  }
+  std::size_t Size() const { return active_size_.load(); }
+
  private:
+  static constexpr uint32_t kChunkSize = 1024;
+  /// 每个TimerManager最多 kMaxChunk * kChunkSize 个节点
+  static constexpr uint32_t kMaxChunk = 4096;
+
   void _AddTimerNode(Timer* node);
+  void _DelTimerNode(Timer* node);
+  uint32_t _NextTick();
+  uint32_t _ToTick(uint64_t deadline_ns);
   void _Updatetime();
   void _Execute();
   void _MoveList(int level, int idx);
   void _Shift();
   void _Dispath(List* cur);
-  uint64_t GetMonoTimeMs();
+  uint64_t GetMonoTimeNs();
+
+  /// 节点池(无锁, 任意线程)
+  Timer* _At(uint32_t index) const {
+    return &chunks_[index / kChunkSize].load(
+      std::memory_order_acquire)[index % kChunkSize];
+  }
+  Timer* _Alloc();
+  void _Free(Timer* node);
+  bool _Grow();
+  Timer* _Get(timer_handle_t handle);
+  timer_handle_t _ToHandle(Timer* node, uint32_t gen) const {
+    return (static_cast<timer_handle_t>(gen) << 32) | (node->index_ + 1);
+  }
+  /// 名字驻留(任意线程)
+  const std::string* _Intern(const std::string& name, uint32_t* id);
+  /// 提交(任意线程)
+  void _Submit(Timer* node, uint64_t deadline_ns);
+
+  /// 以下函数只在定时器线程调用
+  void _Drain();
+  void _Apply(Timer* node);
+  void _Schedule(Timer* node, uint64_t deadline_ns);
+  void _Release(Timer* node);
+  uint32_t& _Bucket(uint32_t actor_id, uint32_t name_id);
+  Timer* _Find(uint32_t actor_id, uint32_t name_id);
+  void _Link(Timer* node);
+  void _Unlink(Timer* node);
+  void _Rehash();
+
+  /// 节点池，块在TimerManager析构前不释放
+  std::atomic<Timer*> chunks_[kMaxChunk];
+  std::atomic<uint32_t> chunk_size_{0};
+  std::mutex grow_mtx_;
+  /// 空闲链表头: 高32位为版本号(避免ABA), 低32位为 index + 1
+  std::atomic<uint64_t> free_head_{0};
+  std::atomic<std::size_t> active_size_{0};
+
+  /// 驻留的名字, std::deque保证扩容后元素地址不变
+  std::shared_mutex names_mtx_;
+  std::deque<std::string> names_;
+  std::unordered_map<std::string, uint32_t> name_ids_;
+
+  /// 提交链表(后进先出，处理时反转)
+  std::atomic<Timer*> submit_head_{nullptr};
+
+  /// 同名索引
+  std::vector<uint32_t> buckets_;
+  std::size_t named_size_{0};
 
   List tv1_[TVR_SIZE];
   List tv2_[TVN_SIZE];
@@ -69,9 +205,17 @@ class TimerManager final {
 
   uint32_t time_;
   uint64_t cur_point_;
+  /// 定时器精度(ns)
+  uint64_t res_ns_{MY_TIMER_RESOLUTION_US * 1000};
 
   std::list<std::shared_ptr<Msg>> timeout_list_;
+  /// 定时器线程睡眠等待
   std::mutex mtx_;
+  std::condition_variable cv_;
+  std::atomic_bool waiting_{false};
+  bool notified_{false};
+  /// 定时器线程的唤醒时刻(ns)
+  std::atomic<uint64_t> wake_ns_{0};
 };
 
 class WorkerTimer final : public Worker {
@@ -85,6 +229,25 @@ class WorkerTimer final : public Worker {
     const std::string& actor_name,
     const std::string& timer_name,
     int time);
+  int SetTimeout(
+    const std::string& actor_name,
+    const std::string& timer_name,
+    std::chrono::nanoseconds expired,
+    std::chrono::nanoseconds period = std::chrono::nanoseconds(0));
+  int SetTimeout(
+    const std::string& actor_name,
+    const std::string& timer_name,
+    std::chrono::nanoseconds expired,
+    timer_handle_t* handle);
+  int ResetTimeout(timer_handle_t handle, std::chrono::nanoseconds expired);
+  int CancelTimeout(
+    const std::string& actor_name,
+    const std::string& timer_name);
+  int CancelTimeout(timer_handle_t handle);
+
+  /* 未超时的定时器数/定时器池容量 */
+  std::size_t GetTimerSize() const { return timer_mgr_.Size(); }
+  std::size_t GetTimerCapacity() const { return timer_mgr_.Capacity(); }
 
   void Init() override;
   void Run() override;
@@ -95,9 +258,8 @@ class WorkerTimer final : public Worker {
 
  private:
   int Work();
-  int sleep_us_{2500};
-  int cur_us_{0};
-  int dispatch_timeout_us_{1000000};
+  std::chrono::steady_clock::time_point last_dispatch_;
+  std::chrono::microseconds dispatch_timeout_{1000000};
   TimerManager timer_mgr_;
 };
 
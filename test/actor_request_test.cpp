@@ -0,0 +1,217 @@
+/****************************************************************************
+Copyright (c) 2019, 李柯鹏
+All rights reserved.
+
+Author: 李柯鹏 <likepeng0418@163.com>
+****************************************************************************/
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <json/json.h>
+
+#include "myframe/msg.h"
+#include "myframe/actor.h"
+#include "myframe/mod_manager.h"
+#include "myframe/app.h"
+
+namespace {
+
+std::mutex g_mtx;
+std::vector<std::string> g_results;
+std::atomic<int> g_held{0};
+
+void Record(const std::string& res) {
+  std::lock_guard<std::mutex> lk(g_mtx);
+  g_results.emplace_back(res);
+}
+
+std::vector<std::string> GetResults() {
+  std::lock_guard<std::mutex> lk(g_mtx);
+  return g_results;
+}
+
+/* 收到 "hold:x" 后保存请求，收到 "flush" 后按相反顺序回复所有请求 */
+class ResponderActorTest : public myframe::Actor {
+ public:
+  int Init(const char*) override { return 0; }
+
+  void Proc(const std::shared_ptr<const myframe::Msg>& msg) override {
+    if (msg->GetData().compare(0, 5, "hold:") == 0) {
+      reqs_.emplace_back(msg);
+      g_held.fetch_add(1);
+      return;
+    }
+    if (msg->GetData() != "flush") {
+      return;
+    }
+    for (auto it = reqs_.rbegin(); it != reqs_.rend(); ++it) {
+      GetMailbox()->Reply(*it,
+        std::make_shared<myframe::Msg>((*it)->GetData().substr(5)));
+    }
+    reqs_.clear();
+  }
+
+ private:
+  std::vector<std::shared_ptr<const myframe::Msg>> reqs_;
+};
+
+/**
+ * 收到 "<timeout_ms>:<a>,<b>,..." 后给ResponderActorTest逐个发送请求，
+ * 回调记录 "请求:回复"，超时记录 "请求:timeout";
+ * 其它传给Proc()的消息记录为 "proc:数据"
+ */
+class RequesterActorTest : public myframe::Actor {
+ public:
+  int Init(const char*) override { return 0; }
+
+  void Proc(const std::shared_ptr<const myframe::Msg>& msg) override {
+    auto& data = msg->GetData();
+    auto pos = data.find(':');
+    if (msg->GetSrc() == kResponder || pos == std::string::npos) {
+      Record("proc:" + data);
+      return;
+    }
+    std::chrono::milliseconds timeout(std::stoi(data.substr(0, pos)));
+    std::string names = data.substr(pos + 1);
+    std::size_t begin = 0;
+    while (begin <= names.size()) {
+      auto end = names.find(',', begin);
+      if (end == std::string::npos) {
+        end = names.size();
+      }
+      auto name = names.substr(begin, end - begin);
+      begin = end + 1;
+      auto req = std::make_shared<myframe::Msg>("hold:" + name);
+      auto ret = Request(kResponder, req, timeout,
+        [name](const std::shared_ptr<const myframe::Msg>& resp) {
+          Record(name + ":" + (resp == nullptr ? "timeout" : resp->GetData()));
+        });
+      if (ret != 0) {
+        Record(name + ":failed");
+      }
+    }
+  }
+
+  static constexpr const char* kResponder = "actor.ResponderActorTest.1";
+};
+
+bool WaitFor(const std::function<bool()>& cond, int timeout_ms = 3000) {
+  auto deadline = std::chrono::steady_clock::now()
+    + std::chrono::milliseconds(timeout_ms);
+  while (!cond()) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+class ActorRequestTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    {
+      std::lock_guard<std::mutex> lk(g_mtx);
+      g_results.clear();
+    }
+    g_held.store(0);
+    app_ = std::make_shared<myframe::App>();
+    ASSERT_TRUE(app_->Init("lib", 2));
+    auto& mod = app_->GetModManager();
+    mod->RegActor("RequesterActorTest", [](const std::string&) {
+      return std::make_shared<RequesterActorTest>();
+    });
+    mod->RegActor("ResponderActorTest", [](const std::string&) {
+      return std::make_shared<ResponderActorTest>();
+    });
+    ASSERT_TRUE(app_->AddActor(
+      "1", "", mod->CreateActorInst("class", "RequesterActorTest")));
+    ASSERT_TRUE(app_->AddActor(
+      "1", "", mod->CreateActorInst("class", "ResponderActorTest")));
+    th_ = std::thread([this]() { app_->Exec(); });
+  }
+
+  void TearDown() override {
+    if (app_ != nullptr) {
+      app_->Quit();
+    }
+    if (th_.joinable()) {
+      th_.join();
+    }
+    app_.reset();
+  }
+
+  void Send(const std::string& dst, const std::string& data) {
+    auto msg = std::make_shared<myframe::Msg>(data);
+    msg->SetDst(dst);
+    ASSERT_EQ(0, app_->Send(msg));
+  }
+
+  /* 从框架获取请求者未完成的请求数 */
+  uint64_t GetPendingRequest() {
+    auto req = std::make_shared<myframe::Msg>(myframe::MAIN_CMD_METRICS);
+    req->SetDst(myframe::MAIN_ADDR);
+    auto resp = app_->SendRequest(req);
+    Json::Value root;
+    Json::Reader reader;
+    if (resp == nullptr || !reader.parse(resp->GetData(), root)) {
+      return 0;
+    }
+    for (auto& actor : root["actors"]) {
+      if (actor["name"].asString() == kRequester) {
+        return actor["pending_request"].asUInt64();
+      }
+    }
+    return 0;
+  }
+
+  static constexpr const char* kRequester = "actor.RequesterActorTest.1";
+  std::shared_ptr<myframe::App> app_;
+  std::thread th_;
+};
+
+}  // namespace
+
+// 同时发出多个请求，乱序到达的回复按关联ID交给对应的回调
+TEST_F(ActorRequestTest, ReplyMatched) {
+  Send(kRequester, "3000:a,b,c");
+  ASSERT_TRUE(WaitFor([]() { return g_held.load() == 3; }));
+  Send(RequesterActorTest::kResponder, "flush");
+  ASSERT_TRUE(WaitFor([]() { return GetResults().size() == 3; }));
+  EXPECT_EQ((std::vector<std::string>{"c:c", "b:b", "a:a"}), GetResults());
+  EXPECT_EQ(0u, GetPendingRequest());
+}
+
+// 超时后回调收到nullptr，之后到达的回复被丢弃，也不会传给Proc()
+TEST_F(ActorRequestTest, Timeout) {
+  Send(kRequester, "50:a");
+  ASSERT_TRUE(WaitFor([]() { return GetResults().size() == 1; }));
+  EXPECT_EQ("a:timeout", GetResults()[0]);
+  EXPECT_EQ(0u, GetPendingRequest());
+  Send(RequesterActorTest::kResponder, "flush");
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_EQ((std::vector<std::string>{"a:timeout"}), GetResults());
+}
+
+// 已回复的请求的超时定时器被取消，回调只调用一次
+TEST_F(ActorRequestTest, CallbackOnce) {
+  Send(kRequester, "100:a");
+  ASSERT_TRUE(WaitFor([]() { return g_held.load() == 1; }));
+  Send(RequesterActorTest::kResponder, "flush");
+  ASSERT_TRUE(WaitFor([]() { return GetResults().size() == 1; }));
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  EXPECT_EQ((std::vector<std::string>{"a:a"}), GetResults());
+}
+
+TEST_F(ActorRequestTest, InvalidTimeout) {
+  Send(kRequester, "0:a");
+  ASSERT_TRUE(WaitFor([]() { return GetResults().size() == 1; }));
+  EXPECT_EQ("a:failed", GetResults()[0]);
+}
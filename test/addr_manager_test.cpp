@@ -0,0 +1,186 @@
+/****************************************************************************
+Copyright (c) 2019, 李柯鹏
+All rights reserved.
+
+Author: 李柯鹏 <likepeng0418@163.com>
+****************************************************************************/
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <json/json.h>
+
+#include "myframe/msg.h"
+#include "myframe/actor.h"
+#include "myframe/mod_manager.h"
+#include "myframe/app.h"
+#include "myframe/addr_manager.h"
+
+using myframe::AddrManager;
+
+TEST(AddrManagerTest, InternReturnsSameId) {
+  AddrManager mgr;
+  auto id = mgr.Intern("actor.echo.1");
+  EXPECT_NE(myframe::INVALID_ADDR_ID, id);
+  EXPECT_EQ(id, mgr.Intern("actor.echo.1"));
+  EXPECT_EQ(id, mgr.Find("actor.echo.1"));
+  EXPECT_EQ("actor.echo.1", mgr.GetAddr(id));
+  EXPECT_NE(id, mgr.Intern("actor.echo.2"));
+}
+
+TEST(AddrManagerTest, FindUnknown) {
+  AddrManager mgr;
+  auto size = mgr.Size();
+  EXPECT_EQ(myframe::INVALID_ADDR_ID, mgr.Find("actor.unknown.1"));
+  EXPECT_EQ(size, mgr.Size());
+  // 无效句柄对应空地址
+  EXPECT_EQ("", mgr.GetAddr(myframe::INVALID_ADDR_ID));
+  EXPECT_EQ("", mgr.GetAddr(10000));
+  EXPECT_EQ(AddrManager::Type::kInvalid, mgr.GetType(10000));
+}
+
+TEST(AddrManagerTest, ParseType) {
+  AddrManager mgr;
+  EXPECT_EQ(AddrManager::Type::kMain,
+    mgr.GetType(mgr.Find(myframe::MAIN_ADDR)));
+  EXPECT_EQ(AddrManager::Type::kActor,
+    mgr.GetType(mgr.Intern("actor.echo.1")));
+  EXPECT_EQ(AddrManager::Type::kWorker,
+    mgr.GetType(mgr.Intern("worker.timer.0")));
+  EXPECT_EQ(AddrManager::Type::kEventConn,
+    mgr.GetType(mgr.Intern("event.conn.0")));
+  EXPECT_EQ(AddrManager::Type::kInvalid,
+    mgr.GetType(mgr.Intern("event.send")));
+  EXPECT_EQ(AddrManager::Type::kInvalid,
+    mgr.GetType(mgr.Intern("noaddr")));
+  EXPECT_EQ(AddrManager::Type::kOther,
+    mgr.GetType(mgr.Intern("node.x.1")));
+}
+
+// 多个线程同时解析同一批地址，每个地址只分配一个句柄
+TEST(AddrManagerTest, ConcurrentIntern) {
+  AddrManager mgr;
+  const int kAddrs = 1000;
+  const int kThreads = 4;
+  std::vector<std::vector<myframe::addr_id_t>> ids(
+    kThreads, std::vector<myframe::addr_id_t>(kAddrs));
+  std::vector<std::thread> ths;
+  for (int t = 0; t < kThreads; ++t) {
+    ths.emplace_back([&, t]() {
+      for (int i = 0; i < kAddrs; ++i) {
+        ids[t][i] = mgr.Intern("actor.test." + std::to_string(i));
+      }
+    });
+  }
+  for (auto& th : ths) {
+    th.join();
+  }
+  for (int t = 1; t < kThreads; ++t) {
+    EXPECT_EQ(ids[0], ids[t]);
+  }
+  for (int i = 0; i < kAddrs; ++i) {
+    EXPECT_EQ("actor.test." + std::to_string(i), mgr.GetAddr(ids[0][i]));
+  }
+}
+
+namespace {
+
+std::atomic_bool g_marked{false};
+
+/* 收到 "fwd" 后给未知地址发送消息再回复，收到 "mark" 后设置标记 */
+class ForwardActorTest : public myframe::Actor {
+ public:
+  int Init(const char*) override { return 0; }
+
+  void Proc(const std::shared_ptr<const myframe::Msg>& msg) override {
+    if (msg->GetData() == "mark") {
+      g_marked.store(true);
+      return;
+    }
+    for (int i = 0; i < 10; ++i) {
+      GetMailbox()->Send("actor.unknown." + std::to_string(i),
+        std::make_shared<myframe::Msg>("x"));
+      GetMailbox()->Send("node.unknown." + std::to_string(i),
+        std::make_shared<myframe::Msg>("x"));
+    }
+    GetMailbox()->Reply(msg, std::make_shared<myframe::Msg>("ok"));
+  }
+};
+
+class AddrManagerAppTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    g_marked.store(false);
+    app_ = std::make_shared<myframe::App>();
+    ASSERT_TRUE(app_->Init("lib", 2));
+    auto& mod = app_->GetModManager();
+    mod->RegActor("ForwardActorTest", [](const std::string&) {
+      return std::make_shared<ForwardActorTest>();
+    });
+    ASSERT_TRUE(app_->AddActor(
+      "1", "", mod->CreateActorInst("class", "ForwardActorTest")));
+    th_ = std::thread([this]() { app_->Exec(); });
+  }
+
+  void TearDown() override {
+    app_->Quit();
+    if (th_.joinable()) {
+      th_.join();
+    }
+    app_.reset();
+  }
+
+  /* 从框架获取地址句柄数 */
+  uint64_t GetAddrSize() {
+    auto req = std::make_shared<myframe::Msg>(myframe::MAIN_CMD_METRICS);
+    req->SetDst(myframe::MAIN_ADDR);
+    auto resp = app_->SendRequest(req);
+    Json::Value root;
+    Json::Reader reader;
+    if (resp == nullptr || !reader.parse(resp->GetData(), root)) {
+      return 0;
+    }
+    return root["main"]["addrs"].asUInt64();
+  }
+
+  static constexpr const char* kActor = "actor.ForwardActorTest.1";
+  std::shared_ptr<myframe::App> app_;
+  std::thread th_;
+};
+
+}  // namespace
+
+// 发给未知地址以及来自未知地址的消息不分配地址句柄
+TEST_F(AddrManagerAppTest, UnknownAddrNotInterned) {
+  auto size = GetAddrSize();
+  ASSERT_NE(0u, size);
+  for (int i = 0; i < 10; ++i) {
+    auto msg = std::make_shared<myframe::Msg>("x");
+    msg->SetSrc("ext.src." + std::to_string(i));
+    msg->SetDst("actor.missing." + std::to_string(i));
+    ASSERT_EQ(0, app_->Send(msg));
+    auto cmd = std::make_shared<myframe::Msg>(myframe::MAIN_CMD_METRICS);
+    cmd->SetSrc("ext.src." + std::to_string(i));
+    cmd->SetDst(myframe::MAIN_ADDR);
+    ASSERT_EQ(0, app_->Send(cmd));
+  }
+  auto mark = std::make_shared<myframe::Msg>("mark");
+  mark->SetDst(kActor);
+  ASSERT_EQ(0, app_->Send(mark));
+  auto fwd = std::make_shared<myframe::Msg>("fwd");
+  fwd->SetDst(kActor);
+  auto resp = app_->SendRequest(fwd);
+  ASSERT_NE(nullptr, resp);
+  EXPECT_EQ("ok", resp->GetData());
+  // 外部发送的消息按顺序分发，收到mark时之前的消息已经分发
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(3);
+  while (!g_marked.load() && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  ASSERT_TRUE(g_marked.load());
+  EXPECT_EQ(size, GetAddrSize());
+}
@@ -0,0 +1,96 @@
+/****************************************************************************
+Copyright (c) 2019, 李柯鹏
+All rights reserved.
+
+Author: 李柯鹏 <likepeng0418@163.com>
+****************************************************************************/
+#include <poll.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "myframe/cmd_channel.h"
+
+using myframe::CmdChannel;
+
+namespace {
+
+bool Readable(int fd) {
+  struct pollfd pfd = {fd, POLLIN, 0};
+  return poll(&pfd, 1, 0) == 1;
+}
+
+}  // namespace
+
+// 多个未读取的命令按顺序取出，取完之前eventfd保持可读
+TEST(CmdChannelEventfdTest, PendingCmds) {
+  auto ch = CmdChannel::Create(nullptr);
+  EXPECT_FALSE(Readable(ch->GetOwnerHandle()));
+  EXPECT_EQ(1, ch->SendToOwner(CmdChannel::Cmd::kRunWithMsg));
+  EXPECT_EQ(1, ch->SendToOwner(CmdChannel::Cmd::kQuit));
+  EXPECT_TRUE(Readable(ch->GetOwnerHandle()));
+  CmdChannel::Cmd cmd;
+  EXPECT_EQ(1, ch->RecvFromMain(&cmd));
+  EXPECT_EQ(CmdChannel::Cmd::kRunWithMsg, cmd);
+  EXPECT_TRUE(Readable(ch->GetOwnerHandle()));
+  EXPECT_EQ(1, ch->RecvFromMain(&cmd));
+  EXPECT_EQ(CmdChannel::Cmd::kQuit, cmd);
+  EXPECT_FALSE(Readable(ch->GetOwnerHandle()));
+  // 主线程方向
+  EXPECT_EQ(1, ch->SendToMain(CmdChannel::Cmd::kIdle));
+  EXPECT_TRUE(Readable(ch->GetMainHandle()));
+  EXPECT_EQ(1, ch->RecvFromOwner(&cmd));
+  EXPECT_EQ(CmdChannel::Cmd::kIdle, cmd);
+  EXPECT_FALSE(Readable(ch->GetMainHandle()));
+}
+
+TEST(CmdChannelEventfdTest, RecvTimeout) {
+  auto ch = CmdChannel::Create(nullptr);
+  CmdChannel::Cmd cmd;
+  EXPECT_EQ(-1, ch->RecvFromMain(&cmd, 0));
+  EXPECT_EQ(-1, ch->RecvFromMain(&cmd, 10));
+  EXPECT_EQ(1, ch->SendToOwner(CmdChannel::Cmd::kRun));
+  EXPECT_EQ(1, ch->RecvFromMain(&cmd, 10));
+  EXPECT_EQ(CmdChannel::Cmd::kRun, cmd);
+  EXPECT_FALSE(Readable(ch->GetOwnerHandle()));
+}
+
+// 一问一答，分别测试阻塞等待和自旋等待
+void PingPong(CmdChannel* ch) {
+  const int kRounds = 20000;
+  std::thread owner([ch]() {
+    CmdChannel::Cmd cmd;
+    for (int i = 0; i < kRounds; ++i) {
+      ASSERT_EQ(1, ch->SendToMain(CmdChannel::Cmd::kIdle));
+      ASSERT_EQ(1, ch->RecvFromMain(&cmd));
+      ASSERT_EQ(CmdChannel::Cmd::kRun, cmd);
+    }
+  });
+  CmdChannel::Cmd cmd;
+  for (int i = 0; i < kRounds; ++i) {
+    // 主线程等待eventfd可读后读取，与poller相同
+    struct pollfd pfd = {ch->GetMainHandle(), POLLIN, 0};
+    ASSERT_EQ(1, poll(&pfd, 1, 3000)) << i;
+    ASSERT_EQ(1, ch->RecvFromOwner(&cmd));
+    ASSERT_EQ(CmdChannel::Cmd::kIdle, cmd);
+    ASSERT_EQ(1, ch->SendToOwner(CmdChannel::Cmd::kRun));
+  }
+  owner.join();
+  EXPECT_FALSE(Readable(ch->GetMainHandle()));
+  EXPECT_FALSE(Readable(ch->GetOwnerHandle()));
+}
+
+TEST(CmdChannelEventfdTest, PingPongBlock) {
+  auto ch = CmdChannel::Create(nullptr);
+  PingPong(ch.get());
+}
+
+TEST(CmdChannelEventfdTest, PingPongSpin) {
+  auto ch = CmdChannel::Create(nullptr);
+  ch->GetSpinWait()->SetMaxSpinTime(50);
+  PingPong(ch.get());
+  EXPECT_LT(0u, ch->GetSpinWait()->GetSpinCount());
+}
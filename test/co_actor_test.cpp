@@ -0,0 +1,231 @@
+/****************************************************************************
+Copyright (c) 2019, 李柯鹏
+All rights reserved.
+
+Author: 李柯鹏 <likepeng0418@163.com>
+****************************************************************************/
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "myframe/msg.h"
+#include "myframe/actor.h"
+#include "myframe/co_actor.h"
+#include "myframe/mod_manager.h"
+#include "myframe/app.h"
+
+namespace {
+
+std::mutex g_mtx;
+std::vector<std::string> g_results;
+std::atomic_bool g_frame_destroyed{false};
+
+void Record(const std::string& res) {
+  std::lock_guard<std::mutex> lk(g_mtx);
+  g_results.emplace_back(res);
+}
+
+std::vector<std::string> GetResults() {
+  std::lock_guard<std::mutex> lk(g_mtx);
+  return g_results;
+}
+
+std::string RespData(const std::shared_ptr<const myframe::Msg>& resp) {
+  return resp == nullptr ? "null" : resp->GetData();
+}
+
+/* 立即回复请求，"drop"开头的请求不回复 */
+class EchoActorTest : public myframe::Actor {
+ public:
+  int Init(const char*) override { return 0; }
+
+  void Proc(const std::shared_ptr<const myframe::Msg>& msg) override {
+    if (msg->GetData().compare(0, 4, "drop") == 0) {
+      return;
+    }
+    GetMailbox()->Reply(msg,
+      std::make_shared<myframe::Msg>(msg->GetData()));
+  }
+};
+
+/* 协程结束或者被释放时设置标记 */
+struct FrameGuard {
+  ~FrameGuard() { g_frame_destroyed.store(true); }
+};
+
+/* 按收到的命令执行对应的协程流程，结果通过Record()记录 */
+class CoActorTest : public myframe::CoActor {
+ public:
+  int Init(const char*) override { return 0; }
+
+  myframe::CoTask CoProc(std::shared_ptr<const myframe::Msg> msg) override {
+    auto cmd = msg->GetData();
+    if (cmd == "request") {
+      auto resp = co_await CoRequest(kEcho,
+        std::make_shared<myframe::Msg>("a"), std::chrono::seconds(3));
+      Record("request:" + RespData(resp));
+    } else if (cmd == "timeout") {
+      auto resp = co_await CoRequest(kEcho,
+        std::make_shared<myframe::Msg>("drop"),
+        std::chrono::milliseconds(50));
+      Record("timeout:" + RespData(resp));
+    } else if (cmd == "all") {
+      std::vector<RequestItem> reqs;
+      reqs.emplace_back(kEcho, std::make_shared<myframe::Msg>("a"));
+      reqs.emplace_back(kEcho, std::make_shared<myframe::Msg>("drop"));
+      reqs.emplace_back(kEcho, std::make_shared<myframe::Msg>("c"));
+      auto resps = co_await CoRequestAll(
+        std::move(reqs), std::chrono::milliseconds(100));
+      std::string res = "all:";
+      for (auto& resp : resps) {
+        res += RespData(resp) + ",";
+      }
+      Record(res);
+    } else if (cmd == "sleep") {
+      auto begin = std::chrono::steady_clock::now();
+      auto ret = co_await CoSleep(std::chrono::milliseconds(100));
+      auto cost = std::chrono::steady_clock::now() - begin;
+      Record("sleep:" + std::to_string(ret) + ":"
+        + (cost >= std::chrono::milliseconds(90) ? "ok" : "short"));
+    } else if (cmd == "nested") {
+      co_await Nested();
+      Record("nested:done");
+    } else if (cmd == "pending") {
+      FrameGuard guard;
+      co_await CoSleep(std::chrono::seconds(30));
+      Record("pending:done");
+    }
+  }
+
+ private:
+  myframe::CoTask Nested() {
+    auto resp = co_await CoRequest(kEcho,
+      std::make_shared<myframe::Msg>("n"), std::chrono::seconds(3));
+    Record("nested:" + RespData(resp));
+  }
+
+  static constexpr const char* kEcho = "actor.EchoActorTest.1";
+};
+
+bool WaitFor(const std::function<bool()>& cond, int timeout_ms = 3000) {
+  auto deadline = std::chrono::steady_clock::now()
+    + std::chrono::milliseconds(timeout_ms);
+  while (!cond()) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+class CoActorAppTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    {
+      std::lock_guard<std::mutex> lk(g_mtx);
+      g_results.clear();
+    }
+    g_frame_destroyed.store(false);
+    app_ = std::make_shared<myframe::App>();
+    ASSERT_TRUE(app_->Init("lib", 2));
+    auto& mod = app_->GetModManager();
+    mod->RegActor("EchoActorTest", [](const std::string&) {
+      return std::make_shared<EchoActorTest>();
+    });
+    mod->RegActor("CoActorTest", [](const std::string&) {
+      return std::make_shared<CoActorTest>();
+    });
+    ASSERT_TRUE(app_->AddActor(
+      "1", "", mod->CreateActorInst("class", "EchoActorTest")));
+    ASSERT_TRUE(app_->AddActor(
+      "1", "", mod->CreateActorInst("class", "CoActorTest")));
+    th_ = std::thread([this]() { app_->Exec(); });
+  }
+
+  void TearDown() override {
+    Stop();
+  }
+
+  void Stop() {
+    if (app_ != nullptr) {
+      app_->Quit();
+    }
+    if (th_.joinable()) {
+      th_.join();
+    }
+    app_.reset();
+  }
+
+  void Send(const std::string& data) {
+    auto msg = std::make_shared<myframe::Msg>(data);
+    msg->SetDst(kCoActor);
+    ASSERT_EQ(0, app_->Send(msg));
+  }
+
+  static constexpr const char* kCoActor = "actor.CoActorTest.1";
+  std::shared_ptr<myframe::App> app_;
+  std::thread th_;
+};
+
+}  // namespace
+
+TEST_F(CoActorAppTest, CoRequest) {
+  Send("request");
+  ASSERT_TRUE(WaitFor([]() { return GetResults().size() == 1; }));
+  EXPECT_EQ("request:a", GetResults()[0]);
+}
+
+TEST_F(CoActorAppTest, CoRequestTimeout) {
+  Send("timeout");
+  ASSERT_TRUE(WaitFor([]() { return GetResults().size() == 1; }));
+  EXPECT_EQ("timeout:null", GetResults()[0]);
+}
+
+// 回复与请求按下标对应，未回复的请求超时后为nullptr
+TEST_F(CoActorAppTest, CoRequestAll) {
+  Send("all");
+  ASSERT_TRUE(WaitFor([]() { return GetResults().size() == 1; }));
+  EXPECT_EQ("all:a,null,c,", GetResults()[0]);
+}
+
+TEST_F(CoActorAppTest, CoSleep) {
+  Send("sleep");
+  ASSERT_TRUE(WaitFor([]() { return GetResults().size() == 1; }));
+  EXPECT_EQ("sleep:0:ok", GetResults()[0]);
+}
+
+// 子任务结束后恢复等待的协程
+TEST_F(CoActorAppTest, NestedTask) {
+  Send("nested");
+  ASSERT_TRUE(WaitFor([]() { return GetResults().size() == 2; }));
+  EXPECT_EQ((std::vector<std::string>{"nested:n", "nested:done"}),
+    GetResults());
+}
+
+// 协程等待期间actor继续处理后续消息
+TEST_F(CoActorAppTest, ProcWhileSuspended) {
+  Send("sleep");
+  Send("request");
+  ASSERT_TRUE(WaitFor([]() { return GetResults().size() == 2; }));
+  EXPECT_EQ((std::vector<std::string>{"request:a", "sleep:0:ok"}),
+    GetResults());
+}
+
+// actor销毁时释放未结束的协程
+TEST_F(CoActorAppTest, DestroyPending) {
+  Send("pending");
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(g_frame_destroyed.load());
+  Stop();
+  EXPECT_TRUE(g_frame_destroyed.load());
+  EXPECT_TRUE(GetResults().empty());
+}
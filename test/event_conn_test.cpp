@@ -0,0 +1,135 @@
+/****************************************************************************
+Copyright (c) 2019, 李柯鹏
+All rights reserved.
+
+Author: 李柯鹏 <likepeng0418@163.com>
+****************************************************************************/
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "myframe/msg.h"
+#include "myframe/actor.h"
+#include "myframe/mod_manager.h"
+#include "myframe/app.h"
+
+namespace {
+
+/* 使用Reply()回复收到的消息 */
+class EchoActorTest : public myframe::Actor {
+ public:
+  int Init(const char*) override { return 0; }
+
+  void Proc(const std::shared_ptr<const myframe::Msg>& msg) override {
+    GetMailbox()->Reply(msg,
+      std::make_shared<myframe::Msg>(msg->GetData()));
+  }
+};
+
+class EventConnAppTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    app_ = std::make_shared<myframe::App>();
+    ASSERT_TRUE(app_->Init("lib", 2));
+    auto& mod = app_->GetModManager();
+    mod->RegActor("EchoActorTest", [](const std::string&) {
+      return std::make_shared<EchoActorTest>();
+    });
+    ASSERT_TRUE(app_->AddActor(
+      "1", "", mod->CreateActorInst("class", "EchoActorTest")));
+    th_ = std::thread([this]() { app_->Exec(); });
+  }
+
+  void TearDown() override {
+    app_->Quit();
+    if (th_.joinable()) {
+      th_.join();
+    }
+    app_.reset();
+  }
+
+  static constexpr const char* kEcho = "actor.EchoActorTest.1";
+  std::shared_ptr<myframe::App> app_;
+  std::thread th_;
+};
+
+}  // namespace
+
+// 发给框架的命令在分发中直接回复，
+// 回复后立即发送的下一个请求不能丢失
+TEST_F(EventConnAppTest, MainCmdTightLoop) {
+  for (int i = 0; i < 2000; ++i) {
+    auto req = std::make_shared<myframe::Msg>(myframe::MAIN_CMD_METRICS);
+    req->SetDst(myframe::MAIN_ADDR);
+    auto resp = app_->SendRequest(req);
+    ASSERT_NE(nullptr, resp) << i;
+    EXPECT_EQ(myframe::MAIN_ADDR, resp->GetSrc());
+  }
+}
+
+// 框架命令与actor请求交替发送
+TEST_F(EventConnAppTest, MixedTightLoop) {
+  for (int i = 0; i < 2000; ++i) {
+    auto req = std::make_shared<myframe::Msg>(myframe::MAIN_CMD_METRICS);
+    req->SetDst(myframe::MAIN_ADDR);
+    ASSERT_NE(nullptr, app_->SendRequest(req)) << i;
+    auto echo = std::make_shared<myframe::Msg>(std::to_string(i));
+    echo->SetDst(kEcho);
+    auto resp = app_->SendRequest(echo);
+    ASSERT_NE(nullptr, resp) << i;
+    EXPECT_EQ(std::to_string(i), resp->GetData());
+  }
+}
+
+// 多个线程交替使用连接，连接释放后被其它线程复用，回复不能串到其它请求
+TEST_F(EventConnAppTest, ReuseAcrossThreads) {
+  const int kThreads = 6;
+  const int kLoops = 300;
+  std::atomic<int> mismatch{0};
+  std::vector<std::thread> ths;
+  for (int t = 0; t < kThreads; ++t) {
+    ths.emplace_back([&, t]() {
+      for (int i = 0; i < kLoops; ++i) {
+        auto data = std::to_string(t) + ":" + std::to_string(i);
+        auto echo = std::make_shared<myframe::Msg>(data);
+        echo->SetDst(kEcho);
+        auto resp = app_->SendRequest(echo);
+        if (resp == nullptr || resp->GetData() != data) {
+          mismatch.fetch_add(1);
+        }
+        if (i % 10 == 0) {
+          auto req = std::make_shared<myframe::Msg>(
+            myframe::MAIN_CMD_METRICS);
+          req->SetDst(myframe::MAIN_ADDR);
+          resp = app_->SendRequest(req);
+          if (resp == nullptr || resp->GetSrc() != myframe::MAIN_ADDR) {
+            mismatch.fetch_add(1);
+          }
+        }
+        if (i % 10 == 5) {
+          std::vector<std::shared_ptr<myframe::Msg>> reqs;
+          for (int j = 0; j < 3; ++j) {
+            reqs.emplace_back(
+              std::make_shared<myframe::Msg>(data + ":" + std::to_string(j)));
+            reqs.back()->SetDst(kEcho);
+          }
+          auto resps = app_->SendRequestBatch(reqs);
+          for (int j = 0; j < 3; ++j) {
+            if (resps[j] == nullptr
+                || resps[j]->GetData() != data + ":" + std::to_string(j)) {
+              mismatch.fetch_add(1);
+            }
+          }
+        }
+      }
+    });
+  }
+  for (auto& th : ths) {
+    th.join();
+  }
+  EXPECT_EQ(0, mismatch.load());
+}
@@ -0,0 +1,327 @@
+/****************************************************************************
+Copyright (c) 2019, 李柯鹏
+All rights reserved.
+
+Author: 李柯鹏 <likepeng0418@163.com>
+****************************************************************************/
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <json/json.h>
+
+#include "myframe/msg.h"
+#include "myframe/actor.h"
+#include "myframe/mod_manager.h"
+#include "myframe/app.h"
+#include "myframe/mailbox_limit.h"
+
+using myframe::MailboxLimit;
+
+namespace {
+
+std::atomic_bool g_blocked{false};
+std::atomic_bool g_release{false};
+std::atomic<int> g_rejected{0};
+std::mutex g_recv_mtx;
+std::vector<std::string> g_recv;
+
+/* 收到 "block" 后一直处理到 g_release 为 true，其它消息记录后回复 */
+class BlockActorTest : public myframe::Actor {
+ public:
+  int Init(const char*) override { return 0; }
+
+  void Proc(const std::shared_ptr<const myframe::Msg>& msg) override {
+    if (msg->GetData() == "block") {
+      g_blocked.store(true);
+      while (!g_release.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lk(g_recv_mtx);
+      g_recv.emplace_back(msg->GetData());
+    }
+    GetMailbox()->Reply(msg, std::make_shared<myframe::Msg>("resp"));
+  }
+};
+
+/* 收到 "send:n" 后给BlockActorTest连续发送n条消息，记录收到的拒绝消息 */
+class SenderActorTest : public myframe::Actor {
+ public:
+  int Init(const char*) override { return 0; }
+
+  void Proc(const std::shared_ptr<const myframe::Msg>& msg) override {
+    if (msg->GetType() == myframe::MSG_TYPE_REJECT) {
+      g_rejected.fetch_add(1);
+      return;
+    }
+    if (msg->GetData().compare(0, 5, "send:") != 0) {
+      return;
+    }
+    auto n = std::stoi(msg->GetData().substr(5));
+    for (int i = 0; i < n; ++i) {
+      GetMailbox()->Send("actor.BlockActorTest.1",
+        std::make_shared<myframe::Msg>(std::to_string(i)));
+    }
+  }
+};
+
+bool WaitFor(const std::function<bool()>& cond, int timeout_ms = 3000) {
+  auto deadline = std::chrono::steady_clock::now()
+    + std::chrono::milliseconds(timeout_ms);
+  while (!cond()) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+std::vector<std::string> GetRecv() {
+  std::lock_guard<std::mutex> lk(g_recv_mtx);
+  return g_recv;
+}
+
+class MailboxLimitAppTest : public ::testing::Test {
+ protected:
+  void Start(const std::string& policy, int capacity) {
+    g_blocked.store(false);
+    g_release.store(false);
+    g_rejected.store(0);
+    {
+      std::lock_guard<std::mutex> lk(g_recv_mtx);
+      g_recv.clear();
+    }
+    app_ = std::make_shared<myframe::App>();
+    ASSERT_TRUE(app_->Init("lib", 2));
+    auto& mod = app_->GetModManager();
+    mod->RegActor("BlockActorTest", [](const std::string&) {
+      return std::make_shared<BlockActorTest>();
+    });
+    mod->RegActor("SenderActorTest", [](const std::string&) {
+      return std::make_shared<SenderActorTest>();
+    });
+    Json::Value config;
+    config["mailbox_capacity"] = capacity;
+    config["mailbox_policy"] = policy;
+    ASSERT_TRUE(app_->AddActor(
+      "1", "", mod->CreateActorInst("class", "BlockActorTest"), config));
+    ASSERT_TRUE(app_->AddActor(
+      "1", "", mod->CreateActorInst("class", "SenderActorTest")));
+    th_ = std::thread([this]() { app_->Exec(); });
+  }
+
+  void TearDown() override {
+    g_release.store(true);
+    if (app_ != nullptr) {
+      app_->Quit();
+    }
+    if (th_.joinable()) {
+      th_.join();
+    }
+    app_.reset();
+  }
+
+  void Send(const std::string& dst, const std::string& data) {
+    auto msg = std::make_shared<myframe::Msg>(data);
+    msg->SetDst(dst);
+    ASSERT_EQ(0, app_->Send(msg));
+  }
+
+  /* 让actor阻塞在处理中 */
+  void Block() {
+    Send(kDst, "block");
+    ASSERT_TRUE(WaitFor([]() { return g_blocked.load(); }));
+  }
+
+  /* 从框架获取actor的收件箱统计 */
+  Json::Value GetLimitMetrics() {
+    auto req = std::make_shared<myframe::Msg>(myframe::MAIN_CMD_METRICS);
+    req->SetDst(myframe::MAIN_ADDR);
+    auto resp = app_->SendRequest(req);
+    Json::Value root;
+    Json::Reader reader;
+    if (resp == nullptr || !reader.parse(resp->GetData(), root)) {
+      return Json::Value();
+    }
+    for (auto& actor : root["actors"]) {
+      if (actor["name"].asString() == kDst) {
+        return actor["mailbox_limit"];
+      }
+    }
+    return Json::Value();
+  }
+
+  static constexpr const char* kDst = "actor.BlockActorTest.1";
+  static constexpr const char* kSender = "actor.SenderActorTest.1";
+  std::shared_ptr<myframe::App> app_;
+  std::thread th_;
+};
+
+class ExternalRequestTest
+  : public MailboxLimitAppTest
+  , public ::testing::WithParamInterface<const char*> {
+ protected:
+  void SetUp() override {
+    Start(GetParam(), 1);
+  }
+
+  /* 收件箱只有1条消息的容量，actor阻塞后再放入1条就满了 */
+  void FillMailbox() {
+    Block();
+    Send(kDst, "fill");
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+};
+
+}  // namespace
+
+TEST(MailboxLimitTest, Init) {
+  MailboxLimit limit;
+  EXPECT_FALSE(limit.IsBounded());
+  EXPECT_EQ(MailboxLimit::Result::kAccept, limit.Check(100000));
+
+  Json::Value config;
+  config["mailbox_capacity"] = 10;
+  config["mailbox_policy"] = "reject";
+  EXPECT_TRUE(limit.Init("actor.test.1", config));
+  EXPECT_TRUE(limit.IsBounded());
+  EXPECT_EQ(10u, limit.GetCapacity());
+  EXPECT_EQ(5u, limit.GetLowWatermark());
+  EXPECT_EQ(MailboxLimit::Policy::kReject, limit.GetPolicy());
+
+  // 配置错误时保持原配置
+  config["mailbox_capacity"] = -1;
+  EXPECT_FALSE(limit.Init("actor.test.1", config));
+  config["mailbox_capacity"] = 20;
+  config["mailbox_policy"] = "unknown";
+  EXPECT_FALSE(limit.Init("actor.test.1", config));
+  EXPECT_EQ(10u, limit.GetCapacity());
+  EXPECT_EQ(MailboxLimit::Policy::kReject, limit.GetPolicy());
+}
+
+TEST(MailboxLimitTest, CheckByPolicy) {
+  struct Case {
+    const char* policy;
+    MailboxLimit::Result result;
+  };
+  const Case cases[] = {
+    {"drop_newest", MailboxLimit::Result::kDropNewest},
+    {"drop_oldest", MailboxLimit::Result::kDropOldest},
+    {"reject", MailboxLimit::Result::kReject},
+    {"credit", MailboxLimit::Result::kThrottle},
+  };
+  for (auto& c : cases) {
+    MailboxLimit limit;
+    Json::Value config;
+    config["mailbox_capacity"] = 2;
+    config["mailbox_policy"] = c.policy;
+    ASSERT_TRUE(limit.Init("actor.test.1", config)) << c.policy;
+    EXPECT_EQ(MailboxLimit::Result::kAccept, limit.Check(1)) << c.policy;
+    EXPECT_EQ(c.result, limit.Check(2)) << c.policy;
+    EXPECT_EQ(c.result, limit.Check(3)) << c.policy;
+  }
+}
+
+TEST(MailboxLimitTest, MakeReject) {
+  myframe::Msg msg("data");
+  msg.SetSrc("actor.src.1");
+  msg.SetDesc("desc");
+  auto reject = MailboxLimit::MakeReject(msg, "actor.dst.1");
+  EXPECT_EQ(myframe::MSG_TYPE_REJECT, reject->GetType());
+  EXPECT_EQ("actor.dst.1", reject->GetSrc());
+  EXPECT_EQ("actor.src.1", reject->GetDst());
+  EXPECT_EQ("desc", reject->GetDesc());
+  EXPECT_EQ("data", reject->GetData());
+}
+
+TEST_F(MailboxLimitAppTest, DropNewest) {
+  Start("drop_newest", 2);
+  Block();
+  for (int i = 0; i < 5; ++i) {
+    Send(kDst, std::to_string(i));
+  }
+  ASSERT_TRUE(WaitFor([this]() {
+    return GetLimitMetrics()["drop_newest"].asUInt64() == 3;
+  }));
+  g_release.store(true);
+  ASSERT_TRUE(WaitFor([]() { return GetRecv().size() == 2; }));
+  EXPECT_EQ((std::vector<std::string>{"0", "1"}), GetRecv());
+}
+
+TEST_F(MailboxLimitAppTest, DropOldest) {
+  Start("drop_oldest", 2);
+  Block();
+  for (int i = 0; i < 5; ++i) {
+    Send(kDst, std::to_string(i));
+  }
+  ASSERT_TRUE(WaitFor([this]() {
+    return GetLimitMetrics()["drop_oldest"].asUInt64() == 3;
+  }));
+  g_release.store(true);
+  ASSERT_TRUE(WaitFor([]() { return GetRecv().size() == 2; }));
+  EXPECT_EQ((std::vector<std::string>{"3", "4"}), GetRecv());
+}
+
+TEST_F(MailboxLimitAppTest, RejectActorSender) {
+  Start("reject", 1);
+  Block();
+  Send(kSender, "send:3");
+  ASSERT_TRUE(WaitFor([]() { return g_rejected.load() == 2; }));
+  EXPECT_EQ(2u, GetLimitMetrics()["reject"].asUInt64());
+  g_release.store(true);
+  ASSERT_TRUE(WaitFor([]() { return GetRecv().size() == 1; }));
+  EXPECT_EQ("0", GetRecv()[0]);
+}
+
+TEST_F(MailboxLimitAppTest, CreditKeepsMsgs) {
+  Start("credit", 2);
+  Block();
+  Send(kSender, "send:5");
+  ASSERT_TRUE(WaitFor([this]() {
+    return GetLimitMetrics()["throttle"].asUInt64() >= 1;
+  }));
+  g_release.store(true);
+  ASSERT_TRUE(WaitFor([]() { return GetRecv().size() == 5; }));
+  EXPECT_EQ(0, g_rejected.load());
+}
+
+// 外部请求同步等待回复，收件箱满时需要收到拒绝消息而不是一直阻塞
+TEST_P(ExternalRequestTest, SendRequest) {
+  FillMailbox();
+  auto req = std::make_shared<myframe::Msg>("hello");
+  req->SetDst(kDst);
+  auto resp = app_->SendRequest(req);
+  ASSERT_NE(nullptr, resp);
+  EXPECT_EQ(myframe::MSG_TYPE_REJECT, resp->GetType());
+  EXPECT_EQ(kDst, resp->GetSrc());
+}
+
+TEST_P(ExternalRequestTest, SendRequestBatch) {
+  FillMailbox();
+  std::vector<std::shared_ptr<myframe::Msg>> reqs;
+  for (int i = 0; i < 3; ++i) {
+    auto req = std::make_shared<myframe::Msg>("hello");
+    req->SetDst(kDst);
+    reqs.emplace_back(req);
+  }
+  auto resps = app_->SendRequestBatch(reqs);
+  ASSERT_EQ(reqs.size(), resps.size());
+  for (auto& resp : resps) {
+    ASSERT_NE(nullptr, resp);
+    EXPECT_EQ(myframe::MSG_TYPE_REJECT, resp->GetType());
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+  MailboxLimitTest, ExternalRequestTest,
+  ::testing::Values("reject", "drop_newest"));
@@ -0,0 +1,80 @@
+/****************************************************************************
+Copyright (c) 2019, 李柯鹏
+All rights reserved.
+
+Author: 李柯鹏 <likepeng0418@163.com>
+****************************************************************************/
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "myframe/msg.h"
+#include "myframe/msg_pool.h"
+
+using myframe::Msg;
+using myframe::MsgPool;
+
+TEST(MsgPoolTest, RecycledMsgIsReset) {
+  auto pool = MsgPool::Instance();
+  const Msg* addr = nullptr;
+  {
+    auto msg = pool->Get();
+    addr = msg.get();
+    msg->SetSrc("actor.a.1");
+    msg->SetDst("actor.b.1");
+    msg->SetType("TEXT");
+    msg->SetDesc("desc");
+    msg->SetData("data");
+    msg->SetPriority(Msg::Priority::kHigh);
+  }
+  // 同一线程释放后再获取，复用刚归还的消息
+  auto msg = pool->Get();
+  EXPECT_EQ(addr, msg.get());
+  EXPECT_TRUE(msg->GetSrc().empty());
+  EXPECT_TRUE(msg->GetDst().empty());
+  EXPECT_TRUE(msg->GetType().empty());
+  EXPECT_TRUE(msg->GetDesc().empty());
+  EXPECT_TRUE(msg->GetData().empty());
+  EXPECT_EQ(Msg::Priority::kNormal, msg->GetPriority());
+}
+
+TEST(MsgPoolTest, ReuseWithoutAlloc) {
+  auto pool = MsgPool::Instance();
+  std::vector<std::shared_ptr<Msg>> msgs;
+  for (int i = 0; i < 100; ++i) {
+    msgs.emplace_back(pool->Get());
+  }
+  msgs.clear();
+  auto alloc = pool->AllocCount();
+  for (int i = 0; i < 100; ++i) {
+    msgs.emplace_back(pool->Get());
+  }
+  EXPECT_EQ(alloc, pool->AllocCount());
+}
+
+// 消息在生产者线程获取，在消费者线程释放
+TEST(MsgPoolTest, CrossThreadRecycle) {
+  auto pool = MsgPool::Instance();
+  const int kMsgs = 10000;
+  std::vector<std::shared_ptr<Msg>> msgs;
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < kMsgs; ++i) {
+      auto msg = pool->Get();
+      msg->SetData("x");
+      msgs.emplace_back(msg);
+    }
+    std::thread consumer([&msgs]() { msgs.clear(); });
+    consumer.join();
+  }
+  // 消费者线程的缓存归还到全局链表，之后的获取不需要全部新分配
+  auto alloc = pool->AllocCount();
+  for (int i = 0; i < kMsgs; ++i) {
+    msgs.emplace_back(pool->Get());
+  }
+  EXPECT_LT(pool->AllocCount() - alloc, static_cast<uint64_t>(kMsgs));
+  for (auto& msg : msgs) {
+    EXPECT_TRUE(msg->GetData().empty());
+  }
+}
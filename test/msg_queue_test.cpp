@@ -0,0 +1,137 @@
+/****************************************************************************
+Copyright (c) 2019, 李柯鹏
+All rights reserved.
+
+Author: 李柯鹏 <likepeng0418@163.com>
+****************************************************************************/
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "myframe/msg.h"
+#include "myframe/msg_queue.h"
+
+using myframe::Msg;
+using myframe::MsgQueue;
+
+namespace {
+
+std::shared_ptr<Msg> MakeMsg(const std::string& data) {
+  return std::make_shared<Msg>(data);
+}
+
+class MsgQueueTest : public ::testing::TestWithParam<MsgQueue::Type> {
+ protected:
+  void SetUp() override {
+    queue_ = MsgQueue::Create(GetParam());
+    ASSERT_NE(nullptr, queue_);
+  }
+
+  std::shared_ptr<MsgQueue> queue_;
+};
+
+}  // namespace
+
+TEST(MsgQueueTypeTest, ParseType) {
+  MsgQueue::Type type;
+  EXPECT_TRUE(MsgQueue::ParseType("mpsc", &type));
+  EXPECT_EQ(MsgQueue::Type::kMpsc, type);
+  EXPECT_TRUE(MsgQueue::ParseType("locked", &type));
+  EXPECT_EQ(MsgQueue::Type::kLocked, type);
+  EXPECT_FALSE(MsgQueue::ParseType("unknown", &type));
+}
+
+TEST_P(MsgQueueTest, Fifo) {
+  EXPECT_TRUE(queue_->Empty());
+  EXPECT_EQ(nullptr, queue_->Pop());
+  for (int i = 0; i < 10; ++i) {
+    queue_->Push(MakeMsg(std::to_string(i)));
+    EXPECT_FALSE(queue_->Empty());
+  }
+  for (int i = 0; i < 10; ++i) {
+    auto msg = queue_->Pop();
+    ASSERT_NE(nullptr, msg);
+    EXPECT_EQ(std::to_string(i), msg->GetData());
+  }
+  EXPECT_TRUE(queue_->Empty());
+  EXPECT_EQ(nullptr, queue_->Pop());
+  // 取空之后可以继续使用
+  queue_->Push(MakeMsg("again"));
+  auto msg = queue_->Pop();
+  ASSERT_NE(nullptr, msg);
+  EXPECT_EQ("again", msg->GetData());
+}
+
+TEST_P(MsgQueueTest, Batch) {
+  std::vector<std::shared_ptr<Msg>> msgs;
+  for (int i = 0; i < 5; ++i) {
+    msgs.emplace_back(MakeMsg(std::to_string(i)));
+  }
+  queue_->PushBatch(&msgs);
+  EXPECT_TRUE(msgs.empty());
+  std::vector<std::shared_ptr<const Msg>> out;
+  EXPECT_EQ(3u, queue_->PopBatch(&out, 3));
+  EXPECT_EQ(2u, queue_->PopBatch(&out, 10));
+  EXPECT_EQ(0u, queue_->PopBatch(&out, 10));
+  ASSERT_EQ(5u, out.size());
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(std::to_string(i), out[i]->GetData());
+  }
+}
+
+// 同一个消息同时在多个队列中(比如广播)
+TEST_P(MsgQueueTest, SameMsgInQueues) {
+  auto other = MsgQueue::Create(GetParam());
+  auto msg = MakeMsg("shared");
+  queue_->Push(msg);
+  other->Push(msg);
+  queue_->Push(msg);
+  EXPECT_EQ(msg, queue_->Pop());
+  EXPECT_EQ(msg, other->Pop());
+  EXPECT_EQ(msg, queue_->Pop());
+  EXPECT_TRUE(queue_->Empty());
+  EXPECT_TRUE(other->Empty());
+  // 出队后消息的节点可以再次使用
+  other->Push(msg);
+  EXPECT_EQ(msg, other->Pop());
+}
+
+// 多个生产者并发放入，每个生产者的消息保持顺序
+TEST_P(MsgQueueTest, MultiProducer) {
+  const int kProducers = 4;
+  const int kMsgs = 10000;
+  std::vector<std::thread> ths;
+  for (int p = 0; p < kProducers; ++p) {
+    ths.emplace_back([this, p]() {
+      for (int i = 0; i < kMsgs; ++i) {
+        auto msg = MakeMsg(std::to_string(i));
+        msg->SetDesc(std::to_string(p));
+        queue_->Push(msg);
+      }
+    });
+  }
+  std::vector<int> next(kProducers, 0);
+  int total = 0;
+  while (total < kProducers * kMsgs) {
+    auto msg = queue_->Pop();
+    if (msg == nullptr) {
+      std::this_thread::yield();
+      continue;
+    }
+    auto p = std::stoi(msg->GetDesc());
+    ASSERT_EQ(std::to_string(next[p]), msg->GetData());
+    ++next[p];
+    ++total;
+  }
+  for (auto& th : ths) {
+    th.join();
+  }
+  EXPECT_TRUE(queue_->Empty());
+}
+
+INSTANTIATE_TEST_SUITE_P(
+  Type, MsgQueueTest,
+  ::testing::Values(MsgQueue::Type::kMpsc, MsgQueue::Type::kLocked));
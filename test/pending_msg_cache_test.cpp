@@ -0,0 +1,127 @@
+/****************************************************************************
+Copyright (c) 2019, 李柯鹏
+All rights reserved.
+
+Author: 李柯鹏 <likepeng0418@163.com>
+****************************************************************************/
+#include <chrono>
+#include <list>
+#include <memory>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "myframe/msg.h"
+#include "myframe/pending_msg_cache.h"
+
+using myframe::Msg;
+using myframe::PendingMsgCache;
+using std::chrono::milliseconds;
+
+namespace {
+
+std::shared_ptr<Msg> MakeMsg(const std::string& data) {
+  return std::make_shared<Msg>(data);
+}
+
+std::string Join(const std::list<std::shared_ptr<Msg>>& msgs) {
+  std::string res;
+  for (auto& msg : msgs) {
+    res += msg->GetData();
+  }
+  return res;
+}
+
+}  // namespace
+
+TEST(PendingMsgCacheTest, PopByDst) {
+  PendingMsgCache cache;
+  std::list<std::shared_ptr<Msg>> evicted;
+  cache.Push(1, MakeMsg("a"), &evicted);
+  cache.Push(2, MakeMsg("b"), &evicted);
+  cache.Push(1, MakeMsg("c"), &evicted);
+  EXPECT_TRUE(evicted.empty());
+  EXPECT_EQ(3u, cache.Size());
+
+  std::list<std::shared_ptr<Msg>> msgs;
+  EXPECT_EQ(0u, cache.Pop(3, &msgs));
+  EXPECT_EQ(2u, cache.Pop(1, &msgs));
+  EXPECT_EQ("ac", Join(msgs));
+  EXPECT_EQ(1u, cache.Size());
+  msgs.clear();
+  EXPECT_EQ(1u, cache.Pop(2, &msgs));
+  EXPECT_EQ("b", Join(msgs));
+  EXPECT_TRUE(cache.Empty());
+  EXPECT_EQ(3u, cache.CachedCount());
+  EXPECT_EQ(3u, cache.DeliveredCount());
+}
+
+TEST(PendingMsgCacheTest, ExpireByTtl) {
+  PendingMsgCache cache;
+  cache.SetTtl(milliseconds(100));
+  auto now = PendingMsgCache::Clock::now();
+  cache.Start(now);
+  std::list<std::shared_ptr<Msg>> evicted;
+  cache.Push(1, MakeMsg("a"), &evicted, now);
+  cache.Push(2, MakeMsg("b"), &evicted, now + milliseconds(50));
+  cache.Push(1, MakeMsg("c"), &evicted, now + milliseconds(60));
+
+  std::list<std::shared_ptr<Msg>> msgs;
+  EXPECT_EQ(0u, cache.Expire(&msgs, now + milliseconds(99)));
+  EXPECT_EQ(1u, cache.Expire(&msgs, now + milliseconds(100)));
+  EXPECT_EQ("a", Join(msgs));
+  // 已经取走的消息不再超时
+  EXPECT_EQ(1u, cache.Pop(2, &msgs));
+  msgs.clear();
+  EXPECT_EQ(1u, cache.Expire(&msgs, now + milliseconds(200)));
+  EXPECT_EQ("c", Join(msgs));
+  EXPECT_TRUE(cache.Empty());
+  EXPECT_EQ(2u, cache.ExpiredCount());
+  EXPECT_EQ(1u, cache.DeliveredCount());
+}
+
+// Start() 之前缓存的消息从 Start() 开始计时
+TEST(PendingMsgCacheTest, TtlFromStart) {
+  PendingMsgCache cache;
+  cache.SetTtl(milliseconds(100));
+  auto now = PendingMsgCache::Clock::now();
+  std::list<std::shared_ptr<Msg>> evicted;
+  cache.Push(1, MakeMsg("a"), &evicted, now);
+  std::list<std::shared_ptr<Msg>> msgs;
+  EXPECT_EQ(0u, cache.Expire(&msgs, now + milliseconds(1000)));
+  cache.Start(now + milliseconds(1000));
+  EXPECT_EQ(0u, cache.Expire(&msgs, now + milliseconds(1099)));
+  EXPECT_EQ(1u, cache.Expire(&msgs, now + milliseconds(1100)));
+}
+
+TEST(PendingMsgCacheTest, EvictBySize) {
+  PendingMsgCache cache;
+  cache.SetMaxSize(2);
+  std::list<std::shared_ptr<Msg>> evicted;
+  cache.Push(1, MakeMsg("a"), &evicted);
+  cache.Push(2, MakeMsg("b"), &evicted);
+  cache.Push(3, MakeMsg("c"), &evicted);
+  EXPECT_EQ("a", Join(evicted));
+  EXPECT_EQ(2u, cache.Size());
+  // 被取走的消息不会被挤出
+  std::list<std::shared_ptr<Msg>> msgs;
+  EXPECT_EQ(1u, cache.Pop(2, &msgs));
+  cache.Push(4, MakeMsg("d"), &evicted);
+  EXPECT_EQ("a", Join(evicted));
+  cache.Push(4, MakeMsg("e"), &evicted);
+  EXPECT_EQ("ac", Join(evicted));
+  EXPECT_EQ(2u, cache.EvictedCount());
+  msgs.clear();
+  EXPECT_EQ(2u, cache.Pop(4, &msgs));
+  EXPECT_EQ("de", Join(msgs));
+}
+
+TEST(PendingMsgCacheTest, InvalidConfig) {
+  PendingMsgCache cache;
+  auto ttl = cache.GetTtl();
+  auto max_size = cache.GetMaxSize();
+  cache.SetTtl(milliseconds(0));
+  cache.SetMaxSize(0);
+  EXPECT_EQ(ttl, cache.GetTtl());
+  EXPECT_EQ(max_size, cache.GetMaxSize());
+}
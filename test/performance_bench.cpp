@@ -0,0 +1,493 @@
+/****************************************************************************
+Copyright (c) 2019, 李柯鹏
+All rights reserved.
+
+Author: 李柯鹏 <likepeng0418@163.com>
+****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <json/json.h>
+
+#include "myframe/log.h"
+#include "myframe/common.h"
+#include "myframe/msg.h"
+#include "myframe/actor.h"
+#include "myframe/mod_manager.h"
+#include "myframe/app.h"
+
+#include "performance_test_config.h"
+
+/**
+ * 性能测试
+ *
+ *  每组(group)一个源actor，源actor同时发出fanout条消息，
+ *  每条消息依次经过chain个actor，最后一个actor记录延迟(源actor发出到收到)
+ *  并回复源actor; 源actor收到fanout个回复后发出下一轮消息。
+ *  每组同时有inflight轮消息在流转。
+ *
+ *  参数(--key=value):
+ *    --groups       组数(actor数 = groups * (1 + fanout * chain))  默认 1
+ *    --chain        每条消息经过的actor数                         默认 10
+ *    --fanout       每轮发出的消息数                              默认 1
+ *    --msg_size     消息数据大小(字节，所有消息共享同一份数据)    默认 8192
+ *    --inflight     每组同时流转的轮数                            默认 1
+ *    --interval_us  每轮结束后等待的时间，0为全速                 默认 0
+ *    --workers      工作线程数                                    默认 4
+ *    --direct       直接分发模式 0/1                              默认 0
+ *    --warmup       预热时间(秒)，不计入结果                      默认 1
+ *    --duration     测试时间(秒)                                  默认 10
+ *    --out          结果另外写入该文件
+ *
+ *  结果以JSON格式输出到标准输出:
+ *    吞吐量(actor处理的消息数/秒)、延迟分位数(p50/p99/p999)、
+ *    每条消息的内存分配次数。
+ *
+ *  原来的测试对应的参数:
+ *    1个actor消息延迟:    --groups=1 --chain=1 --interval_us=10000
+ *    10个actor消息延迟:   --groups=1 --chain=10 --interval_us=10000
+ *    1/20/100个actor吞吐: --groups=1/20/100 --chain=1
+ */
+
+namespace {
+
+struct BenchConfig {
+  int groups{1};
+  int chain{10};
+  int fanout{1};
+  int msg_size{8192};
+  int inflight{1};
+  int interval_us{0};
+  int workers{4};
+  bool direct{false};
+  int warmup_s{1};
+  int duration_s{10};
+  std::string out;
+};
+
+/// 内存分配次数(替换全局operator new统计)，按线程分片避免竞争
+struct alignas(64) AllocShard {
+  std::atomic<uint64_t> cnt{0};
+};
+const std::size_t kAllocShards = 64;
+AllocShard g_alloc[kAllocShards];
+std::atomic<std::size_t> g_alloc_index{0};
+thread_local std::size_t t_alloc_index =
+  g_alloc_index.fetch_add(1, std::memory_order_relaxed) % kAllocShards;
+
+uint64_t AllocCount() {
+  uint64_t sum = 0;
+  for (std::size_t i = 0; i < kAllocShards; ++i) {
+    sum += g_alloc[i].cnt.load(std::memory_order_relaxed);
+  }
+  return sum;
+}
+
+int64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * 延迟直方图(ns)
+ *  小于64ns每个值一个桶，之后每个2的幂分32个桶，相对误差约3%
+ */
+class LatencyHist final {
+ public:
+  static const std::size_t kSub = 32;
+  static const std::size_t kBuckets = 64 + 58 * kSub;
+
+  LatencyHist() : buckets_(kBuckets, 0) {}
+
+  void Record(int64_t ns) {
+    auto v = static_cast<uint64_t>(ns < 0 ? 0 : ns);
+    ++buckets_[Index(v)];
+    ++count_;
+    sum_ += v;
+    if (v > max_) {
+      max_ = v;
+    }
+  }
+
+  void Merge(const LatencyHist& other) {
+    for (std::size_t i = 0; i < kBuckets; ++i) {
+      buckets_[i] += other.buckets_[i];
+    }
+    count_ += other.count_;
+    sum_ += other.sum_;
+    max_ = std::max(max_, other.max_);
+  }
+
+  uint64_t Count() const { return count_; }
+  uint64_t Max() const { return max_; }
+  uint64_t Avg() const { return count_ == 0 ? 0 : sum_ / count_; }
+  /* p: 0~1, 返回桶的下界 */
+  uint64_t Percentile(double p) const {
+    if (count_ == 0) {
+      return 0;
+    }
+    auto target = static_cast<uint64_t>(p * count_);
+    uint64_t sum = 0;
+    for (std::size_t i = 0; i < kBuckets; ++i) {
+      sum += buckets_[i];
+      if (sum > target) {
+        return std::min(LowerBound(i), max_);
+      }
+    }
+    return max_;
+  }
+
+ private:
+  static std::size_t Index(uint64_t v) {
+    if (v < 64) {
+      return v;
+    }
+    std::size_t msb = 6;
+    while ((v >> (msb + 1)) != 0) {
+      ++msb;
+    }
+    return 64 + (msb - 6) * kSub + ((v >> (msb - 5)) - kSub);
+  }
+  static uint64_t LowerBound(std::size_t i) {
+    if (i < 64) {
+      return i;
+    }
+    auto k = i - 64;
+    auto msb = k / kSub + 6;
+    return (kSub + k % kSub) << (msb - 5);
+  }
+
+  std::vector<uint64_t> buckets_;
+  uint64_t count_{0};
+  uint64_t sum_{0};
+  uint64_t max_{0};
+};
+
+/// 测试状态
+BenchConfig g_cfg;
+std::atomic_bool g_recording{false};
+std::atomic_bool g_stop{false};
+std::mutex g_mtx;
+/// 每个actor处理的消息数(单写者)
+std::vector<std::atomic<uint64_t>*> g_proc_cnts;
+/// 最后一个actor的延迟直方图(结束后汇总)
+std::vector<LatencyHist*> g_hists;
+
+std::string StageName(int group, int branch, int stage) {
+  return "g" + std::to_string(group) + ".b" + std::to_string(branch)
+    + ".s" + std::to_string(stage);
+}
+
+}  // namespace
+
+void* operator new(std::size_t size) {
+  g_alloc[t_alloc_index].cnt.fetch_add(1, std::memory_order_relaxed);
+  if (size == 0) {
+    size = 1;
+  }
+  void* p = malloc(size);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void* p) noexcept {
+  free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+  free(p);
+}
+
+/* 源actor: 发出每一轮消息 */
+class BenchSource : public myframe::Actor {
+ public:
+  BenchSource() : payload_(std::string(g_cfg.msg_size, 'x')) {}
+
+  int Init(const char* param) override {
+    group_ = std::stoi(param);
+    for (int b = 0; b < g_cfg.fanout; ++b) {
+      heads_.push_back(GetMailbox()->Resolve(
+        "actor.BenchStage." + StageName(group_, b, 1)));
+    }
+    {
+      std::lock_guard<std::mutex> lk(g_mtx);
+      g_proc_cnts.push_back(&proc_cnt_);
+    }
+    for (int i = 0; i < g_cfg.inflight; ++i) {
+      StartRound();
+    }
+    return 0;
+  }
+
+  void Proc(const std::shared_ptr<const myframe::Msg>& msg) override {
+    if (msg->GetType() == "TIMER") {
+      StartRound();
+      return;
+    }
+    if (g_recording.load(std::memory_order_relaxed)) {
+      proc_cnt_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (++acks_ % g_cfg.fanout != 0) {
+      return;
+    }
+    if (g_cfg.interval_us > 0) {
+      myframe::timer_handle_t handle;
+      Timeout("bench.round",
+        std::chrono::microseconds(g_cfg.interval_us), &handle);
+    } else {
+      StartRound();
+    }
+  }
+
+ private:
+  void StartRound() {
+    if (g_stop.load()) {
+      return;
+    }
+    auto mailbox = GetMailbox();
+    auto now = NowNs();
+    for (auto head : heads_) {
+      auto msg = mailbox->NewMsg();
+      msg->SetBuffer(payload_);
+      msg->SetAnyData(now);
+      mailbox->Send(head, msg);
+    }
+  }
+
+  int group_{0};
+  uint64_t acks_{0};
+  std::vector<myframe::addr_id_t> heads_;
+  std::atomic<uint64_t> proc_cnt_{0};
+  // 所有消息共享同一份数据
+  myframe::Buffer payload_;
+};
+
+/* 转发actor: 转发给下一个actor，最后一个记录延迟并回复源actor */
+class BenchStage : public myframe::Actor {
+ public:
+  int Init(const char* param) override {
+    int group = 0;
+    int branch = 0;
+    if (3 != sscanf(param, "%d %d %d", &group, &branch, &stage_)) {
+      return -1;
+    }
+    last_ = stage_ == g_cfg.chain;
+    next_ = GetMailbox()->Resolve(last_
+      ? "actor.BenchSource." + std::to_string(group)
+      : "actor.BenchStage." + StageName(group, branch, stage_ + 1));
+    std::lock_guard<std::mutex> lk(g_mtx);
+    g_proc_cnts.push_back(&proc_cnt_);
+    if (last_) {
+      g_hists.push_back(&hist_);
+    }
+    return 0;
+  }
+
+  void Proc(const std::shared_ptr<const myframe::Msg>& msg) override {
+    auto ts = msg->GetAnyData<int64_t>();
+    bool recording = g_recording.load(std::memory_order_relaxed);
+    if (recording) {
+      proc_cnt_.fetch_add(1, std::memory_order_relaxed);
+    }
+    auto mailbox = GetMailbox();
+    if (last_) {
+      if (recording) {
+        hist_.Record(NowNs() - ts);
+      }
+      mailbox->Send(next_, mailbox->NewMsg());
+      return;
+    }
+    auto fwd = mailbox->NewMsg();
+    fwd->SetBuffer(msg->GetBuffer());
+    fwd->SetAnyData(ts);
+    mailbox->Send(next_, fwd);
+  }
+
+ private:
+  int stage_{0};
+  bool last_{false};
+  myframe::addr_id_t next_{myframe::INVALID_ADDR_ID};
+  std::atomic<uint64_t> proc_cnt_{0};
+  LatencyHist hist_;
+};
+
+static bool ParseArgs(int argc, char** argv, BenchConfig* cfg) {
+  for (int i = 1; i < argc; ++i) {
+    std::string arg(argv[i]);
+    auto pos = arg.find('=');
+    if (arg.compare(0, 2, "--") != 0 || pos == std::string::npos) {
+      std::cerr << "unknown arg " << arg << std::endl;
+      return false;
+    }
+    auto key = arg.substr(2, pos - 2);
+    auto value = arg.substr(pos + 1);
+    if (key == "out") {
+      cfg->out = value;
+      continue;
+    }
+    int v = 0;
+    try {
+      v = std::stoi(value);
+    } catch (...) {
+      std::cerr << "invalid value " << arg << std::endl;
+      return false;
+    }
+    if (key == "groups") {
+      cfg->groups = v;
+    } else if (key == "chain") {
+      cfg->chain = v;
+    } else if (key == "fanout") {
+      cfg->fanout = v;
+    } else if (key == "msg_size") {
+      cfg->msg_size = v;
+    } else if (key == "inflight") {
+      cfg->inflight = v;
+    } else if (key == "interval_us") {
+      cfg->interval_us = v;
+    } else if (key == "workers") {
+      cfg->workers = v;
+    } else if (key == "direct") {
+      cfg->direct = v != 0;
+    } else if (key == "warmup") {
+      cfg->warmup_s = v;
+    } else if (key == "duration") {
+      cfg->duration_s = v;
+    } else {
+      std::cerr << "unknown arg " << arg << std::endl;
+      return false;
+    }
+  }
+  if (cfg->groups < 1 || cfg->chain < 1 || cfg->fanout < 1
+      || cfg->msg_size < 0 || cfg->inflight < 1 || cfg->interval_us < 0
+      || cfg->workers < 1 || cfg->warmup_s < 0 || cfg->duration_s < 1) {
+    std::cerr << "invalid args" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  if (!ParseArgs(argc, argv, &g_cfg)) {
+    return -1;
+  }
+  auto lib_dir =
+      myframe::Common::GetAbsolutePath(MYFRAME_LIB_DIR).string();
+  auto log_dir =
+      myframe::Common::GetAbsolutePath(MYFRAME_LOG_DIR).string();
+
+  myframe::InitLog(log_dir, "performance_bench");
+
+  auto app = std::make_shared<myframe::App>();
+  myframe::AppOptions opts;
+  opts.thread_pool_size = g_cfg.workers;
+  opts.direct_dispatch = g_cfg.direct;
+  if (false == app->Init(lib_dir, opts)) {
+    LOG(ERROR) << "Init failed";
+    return -1;
+  }
+
+  // 先创建转发actor，源actor在Init()中开始发送
+  auto& mod = app->GetModManager();
+  mod->RegActor("BenchSource", [](const std::string&) {
+    return std::make_shared<BenchSource>();
+  });
+  mod->RegActor("BenchStage", [](const std::string&) {
+    return std::make_shared<BenchStage>();
+  });
+  for (int g = 0; g < g_cfg.groups; ++g) {
+    for (int b = 0; b < g_cfg.fanout; ++b) {
+      for (int s = 1; s <= g_cfg.chain; ++s) {
+        auto param = std::to_string(g) + " " + std::to_string(b) + " "
+          + std::to_string(s);
+        app->AddActor(StageName(g, b, s), param,
+          mod->CreateActorInst("class", "BenchStage"));
+      }
+    }
+  }
+  for (int g = 0; g < g_cfg.groups; ++g) {
+    app->AddActor(std::to_string(g), std::to_string(g),
+      mod->CreateActorInst("class", "BenchSource"));
+  }
+
+  // 预热后开始统计，测试结束后停止发送并退出
+  uint64_t msgs = 0;
+  uint64_t allocs = 0;
+  double elapsed_s = 0;
+  std::thread ctrl([&]() {
+    std::this_thread::sleep_for(std::chrono::seconds(g_cfg.warmup_s));
+    auto alloc_begin = AllocCount();
+    auto begin = std::chrono::steady_clock::now();
+    g_recording.store(true);
+    std::this_thread::sleep_for(std::chrono::seconds(g_cfg.duration_s));
+    g_recording.store(false);
+    auto end = std::chrono::steady_clock::now();
+    allocs = AllocCount() - alloc_begin;
+    elapsed_s = std::chrono::duration<double>(end - begin).count();
+    std::lock_guard<std::mutex> lk(g_mtx);
+    for (auto cnt : g_proc_cnts) {
+      msgs += cnt->load(std::memory_order_relaxed);
+    }
+    g_stop.store(true);
+    app->Quit();
+  });
+  app->Exec();
+  ctrl.join();
+
+  LatencyHist hist;
+  for (auto h : g_hists) {
+    hist.Merge(*h);
+  }
+  Json::Value root;
+  Json::Value& config = root["config"];
+  config["groups"] = g_cfg.groups;
+  config["chain"] = g_cfg.chain;
+  config["fanout"] = g_cfg.fanout;
+  config["msg_size"] = g_cfg.msg_size;
+  config["inflight"] = g_cfg.inflight;
+  config["interval_us"] = g_cfg.interval_us;
+  config["workers"] = g_cfg.workers;
+  config["direct"] = g_cfg.direct;
+  config["actors"] = g_cfg.groups * (1 + g_cfg.fanout * g_cfg.chain);
+  config["warmup_s"] = g_cfg.warmup_s;
+  config["duration_s"] = g_cfg.duration_s;
+  Json::Value& result = root["result"];
+  result["elapsed_s"] = elapsed_s;
+  result["msgs"] = Json::UInt64(msgs);
+  result["msgs_per_sec"] = elapsed_s > 0 ? msgs / elapsed_s : 0;
+  result["rounds_per_sec"] = elapsed_s > 0
+    ? hist.Count() / g_cfg.fanout / elapsed_s : 0;
+  Json::Value& latency = result["latency_us"];
+  latency["count"] = Json::UInt64(hist.Count());
+  latency["avg"] = hist.Avg() / 1000.0;
+  latency["p50"] = hist.Percentile(0.5) / 1000.0;
+  latency["p99"] = hist.Percentile(0.99) / 1000.0;
+  latency["p999"] = hist.Percentile(0.999) / 1000.0;
+  latency["max"] = hist.Max() / 1000.0;
+  result["allocs"] = Json::UInt64(allocs);
+  result["allocs_per_msg"] = msgs > 0 ? static_cast<double>(allocs) / msgs : 0;
+
+  auto out = root.toStyledString();
+  std::cout << out;
+  if (!g_cfg.out.empty()) {
+    std::ofstream ofs(g_cfg.out);
+    ofs << out;
+    if (!ofs) {
+      LOG(ERROR) << "write " << g_cfg.out << " failed";
+      return -1;
+    }
+  }
+  return 0;
+}
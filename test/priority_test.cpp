@@ -0,0 +1,155 @@
+/****************************************************************************
+Copyright (c) 2019, 李柯鹏
+All rights reserved.
+
+Author: 李柯鹏 <likepeng0418@163.com>
+****************************************************************************/
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <json/json.h>
+
+#include "myframe/msg.h"
+#include "myframe/actor.h"
+#include "myframe/mod_manager.h"
+#include "myframe/app.h"
+
+using myframe::Msg;
+
+namespace {
+
+std::atomic_bool g_blocked{false};
+std::atomic_bool g_release{false};
+std::mutex g_recv_mtx;
+std::vector<std::string> g_recv;
+
+/* 收到 "block" 后一直处理到 g_release 为 true，其它消息按处理顺序记录 */
+class BlockActorTest : public myframe::Actor {
+ public:
+  int Init(const char*) override { return 0; }
+
+  void Proc(const std::shared_ptr<const Msg>& msg) override {
+    if (msg->GetData() == "block") {
+      g_blocked.store(true);
+      while (!g_release.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      return;
+    }
+    std::lock_guard<std::mutex> lk(g_recv_mtx);
+    g_recv.emplace_back(msg->GetData());
+  }
+};
+
+bool WaitFor(const std::function<bool()>& cond, int timeout_ms = 3000) {
+  auto deadline = std::chrono::steady_clock::now()
+    + std::chrono::milliseconds(timeout_ms);
+  while (!cond()) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+std::vector<std::string> GetRecv() {
+  std::lock_guard<std::mutex> lk(g_recv_mtx);
+  return g_recv;
+}
+
+/* 参数: 是否使用直接分发模式 */
+class PriorityAppTest : public ::testing::TestWithParam<bool> {
+ protected:
+  void SetUp() override {
+    g_blocked.store(false);
+    g_release.store(false);
+    {
+      std::lock_guard<std::mutex> lk(g_recv_mtx);
+      g_recv.clear();
+    }
+    app_ = std::make_shared<myframe::App>();
+    myframe::AppOptions opts;
+    opts.thread_pool_size = 2;
+    opts.direct_dispatch = GetParam();
+    ASSERT_TRUE(app_->Init("lib", opts));
+    auto& mod = app_->GetModManager();
+    mod->RegActor("BlockActorTest", [](const std::string&) {
+      return std::make_shared<BlockActorTest>();
+    });
+    ASSERT_TRUE(app_->AddActor(
+      "1", "", mod->CreateActorInst("class", "BlockActorTest")));
+    th_ = std::thread([this]() { app_->Exec(); });
+  }
+
+  void TearDown() override {
+    g_release.store(true);
+    app_->Quit();
+    if (th_.joinable()) {
+      th_.join();
+    }
+    app_.reset();
+  }
+
+  void Send(const std::string& data, Msg::Priority priority) {
+    auto msg = std::make_shared<Msg>(data);
+    msg->SetDst(kDst);
+    msg->SetPriority(priority);
+    ASSERT_EQ(0, app_->Send(msg));
+  }
+
+  /* 从框架获取actor收件箱中的消息数 */
+  uint64_t GetDepth() {
+    auto req = std::make_shared<Msg>(myframe::MAIN_CMD_METRICS);
+    req->SetDst(myframe::MAIN_ADDR);
+    auto resp = app_->SendRequest(req);
+    Json::Value root;
+    Json::Reader reader;
+    if (resp == nullptr || !reader.parse(resp->GetData(), root)) {
+      return 0;
+    }
+    for (auto& actor : root["actors"]) {
+      if (actor["name"].asString() == kDst) {
+        return actor["mailbox_depth"].asUInt64();
+      }
+    }
+    return 0;
+  }
+
+  static constexpr const char* kDst = "actor.BlockActorTest.1";
+  std::shared_ptr<myframe::App> app_;
+  std::thread th_;
+};
+
+}  // namespace
+
+// actor处理中收到的高优先级消息先于之前排队的普通消息处理
+TEST_P(PriorityAppTest, HighOvertakesQueuedNormal) {
+  Send("block", Msg::Priority::kNormal);
+  ASSERT_TRUE(WaitFor([]() { return g_blocked.load(); }));
+  for (int i = 0; i < 5; ++i) {
+    Send("n" + std::to_string(i), Msg::Priority::kNormal);
+  }
+  Send("h0", Msg::Priority::kHigh);
+  Send("n5", Msg::Priority::kNormal);
+  Send("h1", Msg::Priority::kHigh);
+  ASSERT_TRUE(WaitFor([this]() { return GetDepth() == 8; }));
+  g_release.store(true);
+  ASSERT_TRUE(WaitFor([]() { return GetRecv().size() == 8; }));
+  // 同一优先级内保持发送顺序
+  EXPECT_EQ((std::vector<std::string>{
+    "h0", "h1", "n0", "n1", "n2", "n3", "n4", "n5"}), GetRecv());
+}
+
+INSTANTIATE_TEST_SUITE_P(DispatchMode, PriorityAppTest,
+  ::testing::Values(false, true),
+  [](const ::testing::TestParamInfo<bool>& info) {
+    return info.param ? "Direct" : "Shard";
+  });
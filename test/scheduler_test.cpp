@@ -0,0 +1,175 @@
+/****************************************************************************
+Copyright (c) 2019, 李柯鹏
+All rights reserved.
+
+Author: 李柯鹏 <likepeng0418@163.com>
+****************************************************************************/
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "myframe/msg.h"
+#include "myframe/actor.h"
+#include "myframe/actor_context.h"
+#include "myframe/scheduler.h"
+
+using myframe::ActorContext;
+using myframe::Scheduler;
+
+namespace {
+
+class NopActorTest : public myframe::Actor {
+ public:
+  int Init(const char*) override { return 0; }
+  void Proc(const std::shared_ptr<const myframe::Msg>&) override {}
+};
+
+std::vector<std::shared_ptr<ActorContext>> MakeContexts(int n) {
+  std::vector<std::shared_ptr<ActorContext>> ctxs;
+  for (int i = 0; i < n; ++i) {
+    ctxs.emplace_back(std::make_shared<ActorContext>(
+      nullptr, std::make_shared<NopActorTest>()));
+  }
+  return ctxs;
+}
+
+/* 在绑定为第index个工作线程的新线程中执行 */
+void RunAs(Scheduler* sched, std::size_t index, std::function<void()> fn) {
+  std::thread th([sched, index, &fn]() {
+    sched->Bind(index);
+    fn();
+  });
+  th.join();
+}
+
+std::shared_ptr<ActorContext> PopAs(Scheduler* sched, std::size_t index) {
+  std::shared_ptr<ActorContext> ctx;
+  RunAs(sched, index, [&]() { ctx = sched->Pop(); });
+  return ctx;
+}
+
+}  // namespace
+
+// 外部线程放入注入队列，工作线程一次取走 size/worker+1 个
+TEST(SchedulerTest, PopInjectBatch) {
+  Scheduler sched(4);
+  auto ctxs = MakeContexts(8);
+  for (auto& ctx : ctxs) {
+    sched.Push(ctx);
+  }
+  // 取走3个: 返回第0个，第1、2个放入工作线程0的本地队列
+  EXPECT_EQ(ctxs[0], PopAs(&sched, 0));
+  // 剩余5个，取走2个
+  EXPECT_EQ(ctxs[3], PopAs(&sched, 1));
+  EXPECT_EQ(ctxs[4], PopAs(&sched, 1));
+  EXPECT_EQ(ctxs[1], PopAs(&sched, 0));
+  EXPECT_EQ(ctxs[2], PopAs(&sched, 0));
+  // 剩余3个，每次取走1个
+  EXPECT_EQ(ctxs[5], PopAs(&sched, 0));
+  EXPECT_EQ(ctxs[6], PopAs(&sched, 1));
+  EXPECT_EQ(ctxs[7], PopAs(&sched, 2));
+}
+
+// 高优先级的actor放入队列头部
+TEST(SchedulerTest, HighFirst) {
+  Scheduler sched(2);
+  auto ctxs = MakeContexts(3);
+  RunAs(&sched, 0, [&]() {
+    sched.Push(ctxs[0]);
+    sched.Push(ctxs[1]);
+    sched.Push(ctxs[2], true);
+  });
+  EXPECT_EQ(ctxs[2], PopAs(&sched, 0));
+  EXPECT_EQ(ctxs[0], PopAs(&sched, 0));
+  EXPECT_EQ(ctxs[1], PopAs(&sched, 0));
+}
+
+// 负载集中在一个工作线程时，空闲线程从队列尾部窃取一半
+TEST(SchedulerTest, StealHalfUnderSkewedLoad) {
+  Scheduler sched(4);
+  auto ctxs = MakeContexts(100);
+  RunAs(&sched, 0, [&]() {
+    for (auto& ctx : ctxs) {
+      sched.Push(ctx);
+    }
+  });
+  EXPECT_EQ(ctxs[50], PopAs(&sched, 1));
+  EXPECT_EQ(ctxs[0], PopAs(&sched, 0));
+  // 窃取的其余actor在工作线程1的本地队列中
+  for (int i = 51; i < 100; ++i) {
+    ASSERT_EQ(ctxs[i], PopAs(&sched, 1)) << i;
+  }
+  // 工作线程0剩余49个，工作线程2再窃取一半
+  EXPECT_EQ(ctxs[25], PopAs(&sched, 2));
+  for (int i = 1; i < 25; ++i) {
+    ASSERT_EQ(ctxs[i], PopAs(&sched, 0)) << i;
+  }
+}
+
+// 窃取时跳过绑定了其它工作线程的actor
+TEST(SchedulerTest, BoundNeverStolen) {
+  Scheduler sched(2);
+  auto ctxs = MakeContexts(3);
+  ctxs[0]->SetWorkerAffinity({0});
+  RunAs(&sched, 0, [&]() {
+    for (auto& ctx : ctxs) {
+      sched.Push(ctx);
+    }
+  });
+  EXPECT_EQ(ctxs[1], PopAs(&sched, 1));
+  EXPECT_EQ(ctxs[2], PopAs(&sched, 1));
+  // 只剩下绑定工作线程0的actor，工作线程1一直等待
+  std::atomic_bool popped{false};
+  std::shared_ptr<ActorContext> stolen;
+  std::thread th([&]() {
+    sched.Bind(1);
+    stolen = sched.Pop();
+    popped.store(true);
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(popped.load());
+  EXPECT_EQ(ctxs[0], PopAs(&sched, 0));
+  sched.Stop();
+  th.join();
+  EXPECT_EQ(nullptr, stolen);
+}
+
+// 工作线程等待期间放入的actor都能被取走，不丢失唤醒
+TEST(SchedulerTest, NoLostWakeup) {
+  const int kWorkers = 3;
+  const int kPushes = 20000;
+  Scheduler sched(kWorkers);
+  auto ctxs = MakeContexts(8);
+  std::atomic<int> popped{0};
+  std::vector<std::thread> workers;
+  for (int i = 0; i < kWorkers; ++i) {
+    workers.emplace_back([&, i]() {
+      sched.Bind(i);
+      while (sched.Pop() != nullptr) {
+        popped.fetch_add(1);
+      }
+    });
+  }
+  for (int i = 0; i < kPushes; ++i) {
+    sched.Push(ctxs[i % ctxs.size()]);
+    // 让工作线程有机会进入等待
+    if (i % 64 == 0) {
+      std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+  }
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (popped.load() < kPushes
+      && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(kPushes, popped.load());
+  sched.Stop();
+  for (auto& th : workers) {
+    th.join();
+  }
+}
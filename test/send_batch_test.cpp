@@ -0,0 +1,234 @@
+/****************************************************************************
+Copyright (c) 2019, 李柯鹏
+All rights reserved.
+
+Author: 李柯鹏 <likepeng0418@163.com>
+****************************************************************************/
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "myframe/msg.h"
+#include "myframe/actor.h"
+#include "myframe/mod_manager.h"
+#include "myframe/app.h"
+
+namespace {
+
+std::mutex g_recv_mtx;
+std::vector<std::string> g_recv;
+
+/* 记录收到的消息 */
+class RecordActorTest : public myframe::Actor {
+ public:
+  int Init(const char*) override { return 0; }
+
+  void Proc(const std::shared_ptr<const myframe::Msg>& msg) override {
+    std::lock_guard<std::mutex> lk(g_recv_mtx);
+    g_recv.emplace_back(msg->GetData());
+  }
+};
+
+/* 收到 "i/n" 的请求后保存，凑齐n个请求后按相反顺序使用Reply()回复 */
+class HoldActorTest : public myframe::Actor {
+ public:
+  int Init(const char*) override { return 0; }
+
+  void Proc(const std::shared_ptr<const myframe::Msg>& msg) override {
+    auto& data = msg->GetData();
+    reqs_.emplace_back(msg);
+    if (reqs_.size() < std::stoul(data.substr(data.find('/') + 1))) {
+      return;
+    }
+    for (auto it = reqs_.rbegin(); it != reqs_.rend(); ++it) {
+      GetMailbox()->Reply(*it,
+        std::make_shared<myframe::Msg>((*it)->GetData()));
+    }
+    reqs_.clear();
+  }
+
+ private:
+  std::vector<std::shared_ptr<const myframe::Msg>> reqs_;
+};
+
+/* 使用Reply()对同一个请求回复两次 */
+class DupActorTest : public myframe::Actor {
+ public:
+  int Init(const char*) override { return 0; }
+
+  void Proc(const std::shared_ptr<const myframe::Msg>& msg) override {
+    GetMailbox()->Reply(msg, std::make_shared<myframe::Msg>(msg->GetData()));
+    GetMailbox()->Reply(msg, std::make_shared<myframe::Msg>("dup"));
+  }
+};
+
+/* 延迟一段时间后不使用Reply()直接发送回复(不带关联ID) */
+class PlainActorTest : public myframe::Actor {
+ public:
+  int Init(const char*) override { return 0; }
+
+  void Proc(const std::shared_ptr<const myframe::Msg>& msg) override {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    GetMailbox()->Send(msg->GetSrc(),
+      std::make_shared<myframe::Msg>(msg->GetData()));
+  }
+};
+
+bool WaitFor(const std::function<bool()>& cond, int timeout_ms = 3000) {
+  auto deadline = std::chrono::steady_clock::now()
+    + std::chrono::milliseconds(timeout_ms);
+  while (!cond()) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+std::vector<std::string> GetRecv() {
+  std::lock_guard<std::mutex> lk(g_recv_mtx);
+  return g_recv;
+}
+
+std::shared_ptr<myframe::Msg> MakeMsg(
+    const std::string& dst, const std::string& data) {
+  auto msg = std::make_shared<myframe::Msg>(data);
+  msg->SetDst(dst);
+  return msg;
+}
+
+class SendBatchTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    {
+      std::lock_guard<std::mutex> lk(g_recv_mtx);
+      g_recv.clear();
+    }
+    app_ = std::make_shared<myframe::App>();
+    ASSERT_TRUE(app_->Init("lib", 4));
+    auto& mod = app_->GetModManager();
+    mod->RegActor("RecordActorTest", [](const std::string&) {
+      return std::make_shared<RecordActorTest>();
+    });
+    mod->RegActor("HoldActorTest", [](const std::string&) {
+      return std::make_shared<HoldActorTest>();
+    });
+    mod->RegActor("DupActorTest", [](const std::string&) {
+      return std::make_shared<DupActorTest>();
+    });
+    mod->RegActor("PlainActorTest", [](const std::string&) {
+      return std::make_shared<PlainActorTest>();
+    });
+    for (auto name : {"RecordActorTest", "HoldActorTest",
+                      "DupActorTest", "PlainActorTest"}) {
+      ASSERT_TRUE(app_->AddActor(
+        "1", "", mod->CreateActorInst("class", name)));
+    }
+    th_ = std::thread([this]() { app_->Exec(); });
+  }
+
+  void TearDown() override {
+    if (app_ != nullptr) {
+      app_->Quit();
+    }
+    if (th_.joinable()) {
+      th_.join();
+    }
+    app_.reset();
+  }
+
+  static constexpr const char* kRecord = "actor.RecordActorTest.1";
+  static constexpr const char* kHold = "actor.HoldActorTest.1";
+  static constexpr const char* kDup = "actor.DupActorTest.1";
+  static constexpr const char* kPlain = "actor.PlainActorTest.1";
+  std::shared_ptr<myframe::App> app_;
+  std::thread th_;
+};
+
+}  // namespace
+
+TEST_F(SendBatchTest, SendBatchInOrder) {
+  const int kMsgs = 100;
+  std::vector<std::shared_ptr<myframe::Msg>> msgs;
+  std::vector<std::string> expect;
+  for (int i = 0; i < kMsgs; ++i) {
+    msgs.emplace_back(MakeMsg(kRecord, std::to_string(i)));
+    expect.emplace_back(std::to_string(i));
+  }
+  ASSERT_EQ(0, app_->SendBatch(msgs));
+  ASSERT_TRUE(WaitFor([]() { return GetRecv().size() == kMsgs; }));
+  EXPECT_EQ(expect, GetRecv());
+}
+
+// 有消息没有目的地址时整批都不发送
+TEST_F(SendBatchTest, SendBatchInvalid) {
+  std::vector<std::shared_ptr<myframe::Msg>> msgs;
+  msgs.emplace_back(MakeMsg(kRecord, "0"));
+  msgs.emplace_back(MakeMsg("", "1"));
+  EXPECT_EQ(-1, app_->SendBatch(msgs));
+  ASSERT_EQ(0, app_->SendBatch({MakeMsg(kRecord, "2")}));
+  ASSERT_TRUE(WaitFor([]() { return GetRecv().size() == 1; }));
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ((std::vector<std::string>{"2"}), GetRecv());
+}
+
+// 使用Reply()的回复乱序到达，按关联ID放到请求对应的位置
+TEST_F(SendBatchTest, RequestBatchByCorrelation) {
+  std::vector<std::shared_ptr<myframe::Msg>> reqs;
+  for (int i = 0; i < 3; ++i) {
+    reqs.emplace_back(MakeMsg(kHold, std::to_string(i) + "/3"));
+  }
+  auto resps = app_->SendRequestBatch(reqs);
+  ASSERT_EQ(3u, resps.size());
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_NE(nullptr, resps[i]);
+    EXPECT_EQ(std::to_string(i) + "/3", resps[i]->GetData());
+  }
+}
+
+// 没有关联ID的回复按到达顺序放到剩余的位置
+TEST_F(SendBatchTest, RequestBatchMixed) {
+  std::vector<std::shared_ptr<myframe::Msg>> reqs;
+  reqs.emplace_back(MakeMsg(kHold, "0/2"));
+  reqs.emplace_back(MakeMsg(kPlain, "plain"));
+  reqs.emplace_back(MakeMsg(kHold, "1/2"));
+  auto resps = app_->SendRequestBatch(reqs);
+  ASSERT_EQ(3u, resps.size());
+  ASSERT_NE(nullptr, resps[0]);
+  ASSERT_NE(nullptr, resps[1]);
+  ASSERT_NE(nullptr, resps[2]);
+  EXPECT_EQ("0/2", resps[0]->GetData());
+  EXPECT_EQ("plain", resps[1]->GetData());
+  EXPECT_EQ("1/2", resps[2]->GetData());
+}
+
+// 同一个请求的多余回复被丢弃，不占用其它请求的位置
+TEST_F(SendBatchTest, RequestBatchDupReply) {
+  std::vector<std::shared_ptr<myframe::Msg>> reqs;
+  reqs.emplace_back(MakeMsg(kDup, "dup0"));
+  reqs.emplace_back(MakeMsg(kPlain, "plain"));
+  auto resps = app_->SendRequestBatch(reqs);
+  ASSERT_EQ(2u, resps.size());
+  ASSERT_NE(nullptr, resps[0]);
+  ASSERT_NE(nullptr, resps[1]);
+  EXPECT_EQ("dup0", resps[0]->GetData());
+  EXPECT_EQ("plain", resps[1]->GetData());
+}
+
+// 上一个请求的多余回复不会被当作下一个请求的回复
+TEST_F(SendBatchTest, RequestStaleReply) {
+  for (int i = 0; i < 5; ++i) {
+    auto resp = app_->SendRequest(MakeMsg(kDup, "dup"));
+    ASSERT_NE(nullptr, resp);
+    resp = app_->SendRequest(MakeMsg(kPlain, "plain"));
+    ASSERT_NE(nullptr, resp);
+    EXPECT_EQ("plain", resp->GetData());
+  }
+}
@@ -0,0 +1,171 @@
+/****************************************************************************
+Copyright (c) 2019, 李柯鹏
+All rights reserved.
+
+Author: 李柯鹏 <likepeng0418@163.com>
+****************************************************************************/
+#include <chrono>
+#include <list>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "myframe/msg.h"
+#include "myframe/worker_timer.h"
+
+using myframe::Msg;
+using myframe::TimerManager;
+using std::chrono::milliseconds;
+
+namespace {
+
+const char* const kActor = "actor.timer.1";
+
+/* 当前线程作为定时器线程推进时间轮，返回这段时间内超时的消息 */
+std::vector<std::shared_ptr<Msg>> Advance(
+    TimerManager* mgr, milliseconds dur) {
+  std::vector<std::shared_ptr<Msg>> msgs;
+  auto end = std::chrono::steady_clock::now() + dur;
+  while (std::chrono::steady_clock::now() < end) {
+    auto list = mgr->Updatetime();
+    msgs.insert(msgs.end(), list->begin(), list->end());
+    list->clear();
+    std::this_thread::sleep_for(milliseconds(1));
+  }
+  return msgs;
+}
+
+std::size_t Count(
+    const std::vector<std::shared_ptr<Msg>>& msgs,
+    const std::string& name) {
+  std::size_t n = 0;
+  for (auto& msg : msgs) {
+    if (msg->GetDesc() == name) {
+      ++n;
+    }
+  }
+  return n;
+}
+
+}  // namespace
+
+TEST(WorkerTimerTest, Timeout) {
+  TimerManager mgr;
+  auto h = mgr.Timeout(kActor, "t", milliseconds(20));
+  EXPECT_NE(myframe::INVALID_TIMER_HANDLE, h);
+  EXPECT_EQ(0u, Advance(&mgr, milliseconds(10)).size());
+  auto msgs = Advance(&mgr, milliseconds(40));
+  ASSERT_EQ(1u, msgs.size());
+  EXPECT_EQ("TIMER", msgs[0]->GetType());
+  EXPECT_EQ("t", msgs[0]->GetDesc());
+  EXPECT_EQ(kActor, msgs[0]->GetDst());
+  EXPECT_EQ(0u, mgr.Size());
+}
+
+TEST(WorkerTimerTest, InvalidArgs) {
+  TimerManager mgr;
+  EXPECT_EQ(myframe::INVALID_TIMER_HANDLE,
+    mgr.Timeout(kActor, "t", milliseconds(0)));
+  EXPECT_EQ(myframe::INVALID_TIMER_HANDLE,
+    mgr.Timeout(kActor, "t", milliseconds(10), milliseconds(-1)));
+  EXPECT_EQ(-1, mgr.Reset(myframe::INVALID_TIMER_HANDLE, milliseconds(10)));
+  EXPECT_EQ(-1, mgr.Cancel(myframe::INVALID_TIMER_HANDLE));
+  EXPECT_EQ(-1, mgr.Cancel(kActor, "unknown"));
+}
+
+// 同名定时器不会互相替换
+TEST(WorkerTimerTest, SameNameAdds) {
+  TimerManager mgr;
+  mgr.Timeout(kActor, "t", milliseconds(10));
+  mgr.Timeout(kActor, "t", milliseconds(20));
+  mgr.Timeout(kActor, "t", milliseconds(20));
+  auto msgs = Advance(&mgr, milliseconds(60));
+  EXPECT_EQ(3u, Count(msgs, "t"));
+  EXPECT_EQ(0u, mgr.Size());
+}
+
+// 按名字取消该actor所有同名的定时器
+TEST(WorkerTimerTest, CancelByName) {
+  TimerManager mgr;
+  mgr.Timeout(kActor, "t", milliseconds(20));
+  mgr.Timeout(kActor, "t", milliseconds(30));
+  mgr.Timeout(kActor, "u", milliseconds(20));
+  mgr.Timeout("actor.timer.2", "t", milliseconds(20));
+  EXPECT_EQ(0, mgr.Cancel(kActor, "t"));
+  auto msgs = Advance(&mgr, milliseconds(60));
+  ASSERT_EQ(2u, msgs.size());
+  EXPECT_EQ(1u, Count(msgs, "u"));
+  EXPECT_EQ(1u, Count(msgs, "t"));
+  EXPECT_EQ(0u, mgr.Size());
+}
+
+TEST(WorkerTimerTest, CancelByHandle) {
+  TimerManager mgr;
+  auto h1 = mgr.Timeout(
+    kActor, "t", milliseconds(20), milliseconds(0), false);
+  auto h2 = mgr.Timeout(
+    kActor, "t", milliseconds(20), milliseconds(0), false);
+  EXPECT_EQ(0, mgr.Cancel(h1));
+  auto msgs = Advance(&mgr, milliseconds(50));
+  // 独立定时器的超时消息带有句柄
+  ASSERT_EQ(1u, msgs.size());
+  EXPECT_EQ(h2, msgs[0]->GetCorrelationId());
+  // 已取消或者已超时的句柄失效
+  EXPECT_EQ(-1, mgr.Cancel(h1));
+  EXPECT_EQ(-1, mgr.Cancel(h2));
+  EXPECT_EQ(-1, mgr.Reset(h2, milliseconds(10)));
+}
+
+// 通过句柄重新设置(替换)未超时的定时器
+TEST(WorkerTimerTest, Reset) {
+  TimerManager mgr;
+  auto h = mgr.Timeout(kActor, "t", milliseconds(20), milliseconds(0), false);
+  EXPECT_EQ(0, mgr.Reset(h, milliseconds(80)));
+  EXPECT_EQ(0u, Advance(&mgr, milliseconds(50)).size());
+  EXPECT_EQ(0, mgr.Reset(h, milliseconds(20)));
+  auto msgs = Advance(&mgr, milliseconds(50));
+  ASSERT_EQ(1u, msgs.size());
+  EXPECT_EQ(h, msgs[0]->GetCorrelationId());
+  EXPECT_EQ(0u, mgr.Size());
+}
+
+TEST(WorkerTimerTest, Interval) {
+  TimerManager mgr;
+  mgr.Timeout(kActor, "i", milliseconds(10), milliseconds(10));
+  auto msgs = Advance(&mgr, milliseconds(105));
+  EXPECT_GE(Count(msgs, "i"), 8u);
+  EXPECT_LE(Count(msgs, "i"), 11u);
+  EXPECT_EQ(1u, mgr.Size());
+  EXPECT_EQ(0, mgr.Cancel(kActor, "i"));
+  Advance(&mgr, milliseconds(5));
+  EXPECT_EQ(0u, Advance(&mgr, milliseconds(30)).size());
+  EXPECT_EQ(0u, mgr.Size());
+}
+
+// 节点池按块扩容，超时或者取消的节点可以复用
+TEST(WorkerTimerTest, NodeReuse) {
+  TimerManager mgr;
+  const int kTimers = 3000;
+  std::vector<myframe::timer_handle_t> handles;
+  for (int i = 0; i < kTimers; ++i) {
+    handles.emplace_back(mgr.Timeout(
+      kActor, "t", milliseconds(1000), milliseconds(0), false));
+  }
+  Advance(&mgr, milliseconds(5));
+  EXPECT_EQ(static_cast<std::size_t>(kTimers), mgr.Size());
+  EXPECT_GE(mgr.Capacity(), static_cast<std::size_t>(kTimers));
+  for (auto h : handles) {
+    EXPECT_EQ(0, mgr.Cancel(h));
+  }
+  Advance(&mgr, milliseconds(5));
+  EXPECT_EQ(0u, mgr.Size());
+  // 取消命令也占用节点，处理后和定时器节点一起归还
+  auto capacity = mgr.Capacity();
+  for (int i = 0; i < kTimers; ++i) {
+    mgr.Timeout(kActor, "t", milliseconds(1000), milliseconds(0), false);
+  }
+  EXPECT_EQ(capacity, mgr.Capacity());
+}